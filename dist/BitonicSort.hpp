@@ -0,0 +1,878 @@
+// This code was automatically generated; you're not supposed to edit it!
+
+#ifndef GLU_BITONICSORT_HPP
+#define GLU_BITONICSORT_HPP
+
+#include <algorithm>
+
+#ifndef GLU_DATA_TYPES_HPP
+#define GLU_DATA_TYPES_HPP
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    enum DataType
+    {
+        DataType_Float = 0,
+        DataType_Double,
+        DataType_Int,
+        DataType_Uint,
+        DataType_Vec2,
+        DataType_Vec4,
+        DataType_DVec2,
+        DataType_DVec4,
+        DataType_UVec2,
+        DataType_UVec4,
+        DataType_IVec2,
+        DataType_IVec4
+    };
+
+    inline const char* to_glsl_type_str(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return "float";
+        else if (data_type == DataType_Double) return "double";
+        else if (data_type == DataType_Int)    return "int";
+        else if (data_type == DataType_Uint)   return "uint";
+        else if (data_type == DataType_Vec2)   return "vec2";
+        else if (data_type == DataType_Vec4)   return "vec4";
+        else if (data_type == DataType_DVec2)  return "dvec2";
+        else if (data_type == DataType_DVec4)  return "dvec4";
+        else if (data_type == DataType_UVec2)  return "uvec2";
+        else if (data_type == DataType_UVec4)  return "uvec4";
+        else if (data_type == DataType_IVec2)  return "ivec2";
+        else if (data_type == DataType_IVec4)  return "ivec4";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+} // namespace glu
+
+#endif // GLU_DATA_TYPES_HPP
+
+
+#ifndef GLU_GL_UTILS_HPP
+#define GLU_GL_UTILS_HPP
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    inline void
+    copy_buffer(GLuint src_buffer, GLuint dst_buffer, size_t size, size_t src_offset = 0, size_t dst_offset = 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, src_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, dst_buffer);
+
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr) src_offset, (GLintptr) dst_offset, (GLsizeiptr) size
+        );
+    }
+
+    /// A RAII wrapper for GL shader.
+    class Shader
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Shader(GLenum type) :
+            m_handle(glCreateShader(type)){};
+        Shader(const Shader&) = delete;
+
+        Shader(Shader&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Shader() { glDeleteShader(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void source_from_str(const std::string& src_str)
+        {
+            const char* src_ptr = src_str.c_str();
+            glShaderSource(m_handle, 1, &src_ptr, nullptr);
+        }
+
+        void source_from_file(const char* src_filepath)
+        {
+            FILE* file = fopen(src_filepath, "rt");
+            GLU_CHECK_STATE(!file, "Failed to shader file: %s", src_filepath);
+
+            fseek(file, 0, SEEK_END);
+            size_t file_size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+
+            std::string src{};
+            src.resize(file_size);
+            fread(src.data(), sizeof(char), file_size, file);
+            source_from_str(src.c_str());
+
+            fclose(file);
+        }
+
+        std::string get_info_log()
+        {
+            GLint log_length = 0;
+            glGetShaderiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetShaderInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void compile()
+        {
+            glCompileShader(m_handle);
+
+            GLint status;
+            glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Shader failed to compile: %s", get_info_log().c_str());
+            }
+        }
+    };
+
+    /// A RAII wrapper for GL program.
+    class Program
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Program() { m_handle = glCreateProgram(); };
+        Program(const Program&) = delete;
+
+        Program(Program&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Program() { glDeleteProgram(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void attach_shader(GLuint shader_handle) { glAttachShader(m_handle, shader_handle); }
+        void attach_shader(const Shader& shader) { glAttachShader(m_handle, shader.handle()); }
+
+        [[nodiscard]] std::string get_info_log() const
+        {
+            GLint log_length = 0;
+            glGetProgramiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetProgramInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void link()
+        {
+            GLint status;
+            glLinkProgram(m_handle);
+            glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Program failed to link: %s", get_info_log().c_str());
+            }
+        }
+
+        void use() { glUseProgram(m_handle); }
+
+        GLint get_uniform_location(const char* uniform_name)
+        {
+            GLint loc = glGetUniformLocation(m_handle, uniform_name);
+            GLU_CHECK_STATE(loc >= 0, "Failed to get uniform location: %s", uniform_name);
+            return loc;
+        }
+    };
+
+    /// A RAII helper class for GL shader storage buffer.
+    class ShaderStorageBuffer
+    {
+    private:
+        GLuint m_handle = 0;
+        size_t m_size = 0;
+
+    public:
+        explicit ShaderStorageBuffer(size_t initial_size = 0)
+        {
+            if (initial_size > 0)
+                resize(initial_size, false);
+        }
+
+        explicit ShaderStorageBuffer(const void* data, size_t size) :
+            m_size(size)
+        {
+            GLU_CHECK_ARGUMENT(data, "");
+            GLU_CHECK_ARGUMENT(size > 0, "");
+
+            glCreateBuffers(1, &m_handle);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, data, GL_DYNAMIC_STORAGE_BIT);
+        }
+
+        template<typename T>
+        explicit ShaderStorageBuffer(const std::vector<T>& data) :
+            ShaderStorageBuffer(data.data(), data.size() * sizeof(T))
+        {
+        }
+
+        ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+        ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            m_size = other.m_size;
+            other.m_handle = 0;
+        }
+
+        ~ShaderStorageBuffer()
+        {
+            if (m_handle)
+                glDeleteBuffers(1, &m_handle);
+        }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        /// Grows or shrinks the buffer. If keep_data, performs an additional copy to maintain the data.
+        void resize(size_t size, bool keep_data = false)
+        {
+            size_t old_size = m_size;
+            GLuint old_handle = m_handle;
+
+            if (old_size != size)
+            {
+                m_size = size;
+
+                glCreateBuffers(1, &m_handle);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+                glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+                if (keep_data)
+                    copy_buffer(old_handle, m_handle, std::min(old_size, size));
+
+                glDeleteBuffers(1, &old_handle);
+            }
+        }
+
+        /// Clears the entire buffer with the given GLuint value (repeated).
+        void clear(GLuint value)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED, GL_UNSIGNED_INT, &value);
+        }
+
+        void write_data(const void* data, size_t size)
+        {
+            GLU_CHECK_ARGUMENT(size <= m_size, "");
+
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+        }
+
+        template<typename T>
+        std::vector<T> get_data() const
+        {
+            GLU_CHECK_ARGUMENT(m_size % sizeof(T) == 0, "Size %zu isn't a multiple of %zu", m_size, sizeof(T));
+
+            std::vector<T> result(m_size / sizeof(T));
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) m_size, result.data());
+            return result;
+        }
+
+        void bind(GLuint index, size_t size = 0, size_t offset = 0)
+        {
+            if (size == 0)
+                size = m_size;
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, m_handle, (GLintptr) offset, (GLsizeiptr) size);
+        }
+    };
+
+    /// Measures elapsed time on GPU for executing the given callback.
+    inline uint64_t measure_gl_elapsed_time(const std::function<void()>& callback)
+    {
+        GLuint query;
+        uint64_t elapsed_time{};
+
+        glGenQueries(1, &query);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        callback();
+
+        glEndQuery(GL_TIME_ELAPSED);
+
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
+        glDeleteQueries(1, &query);
+
+        return elapsed_time;
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_floor(IntegerT n)
+    {
+        return (IntegerT) floor(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_ceil(IntegerT n)
+    {
+        return (IntegerT) ceil(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT div_ceil(IntegerT n, IntegerT d)
+    {
+        return (IntegerT) ceil(double(n) / double(d));
+    }
+
+    template<typename T>
+    bool is_power_of_2(T n)
+    {
+        return (n & (n - 1)) == 0;
+    }
+
+    template<typename IntegerT>
+    IntegerT next_power_of_2(IntegerT n)
+    {
+        n--;
+        n |= n >> 1;
+        n |= n >> 2;
+        n |= n >> 4;
+        n |= n >> 8;
+        n |= n >> 16;
+        n++;
+        return n;
+    }
+
+    template<typename Iterator>
+    void print_stl_container(Iterator begin, Iterator end)
+    {
+        size_t i = 0;
+        for (; begin != end; begin++)
+        {
+            printf("(%zu) %s, ", i, std::to_string(*begin).c_str());
+            i++;
+        }
+        printf("\n");
+    }
+
+    template<typename T>
+    void print_buffer(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<T> data = buffer.get_data<T>();
+        print_stl_container(data.begin(), data.end());
+    }
+
+    inline void print_buffer_hex(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<GLuint> data = buffer.get_data<GLuint>();
+        for (size_t i = 0; i < data.size(); i++)
+            printf("(%zu) %08x, ", i, data[i]);
+        printf("\n");
+    }
+} // namespace glu
+
+#endif // GLU_GL_UTILS_HPP
+
+
+#ifndef GLU_RADIX_SORT_COMMON_HPP
+#define GLU_RADIX_SORT_COMMON_HPP
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Code shared by all the RadixSort shaders. Keys are either uint (32 bits) or uvec2 (64 bits, low bits in x).
+        ///
+        /// Signed and floating-point keys are sorted as unsigned integers after an order-preserving bit transform:
+        /// the sign bit of integers is flipped; the sign bit of positive floats is flipped, and all the bits of
+        /// negative floats. NaNs are cleared of their sign so that they're always placed after +inf.
+        inline const char* k_radix_sort_common_shader = R"(
+#if defined(FLOAT_KEYS) && KEY_NUM_BITS == 64
+const uvec2 k_sign_mask = uvec2(0, 0x80000000u);
+
+bool is_nan(uvec2 key)
+{
+    uint hi = key.y & 0x7fffffffu;
+    return hi > 0x7ff00000u || (hi == 0x7ff00000u && key.x != 0);
+}
+
+uvec2 to_sortable_key(uvec2 key)
+{
+    if (is_nan(key)) key.y &= 0x7fffffffu;
+    return (key.y & 0x80000000u) != 0 ? ~key : key ^ k_sign_mask;
+}
+
+uvec2 from_sortable_key(uvec2 key)
+{
+    return (key.y & 0x80000000u) != 0 ? key ^ k_sign_mask : ~key;
+}
+#elif defined(FLOAT_KEYS)
+uint to_sortable_key(uint key)
+{
+    if ((key & 0x7fffffffu) > 0x7f800000u) key &= 0x7fffffffu; // NaN
+    return (key & 0x80000000u) != 0 ? ~key : key ^ 0x80000000u;
+}
+
+uint from_sortable_key(uint key)
+{
+    return (key & 0x80000000u) != 0 ? key ^ 0x80000000u : ~key;
+}
+#elif defined(SIGNED_KEYS)
+uint to_sortable_key(uint key) { return key ^ 0x80000000u; }
+uint from_sortable_key(uint key) { return key ^ 0x80000000u; }
+#endif
+
+/// Gets the digit of the key starting at the given bit; mask selects the digit bits.
+uint get_radix(KEY_TYPE key, uint shift, uint mask)
+{
+#if KEY_NUM_BITS == 64
+    uint bits = shift < 32 ? (key.x >> shift) : (key.y >> (shift - 32));
+    if (shift > 0 && shift < 32)
+    {
+        bits |= key.y << (32 - shift); // The digit may lie across the two halves (extra bits are masked)
+    }
+    return bits & mask;
+#else
+    return (key >> shift) & mask;
+#endif
+}
+
+/// Gets the digit the key is ranked by: in descending order digits are reversed, so that the largest comes first and
+/// keys with the same digit keep their order (the sort stays stable).
+uint get_key_radix(KEY_TYPE key, uint shift, uint mask)
+{
+#ifdef DESCENDING
+    return mask - get_radix(key, shift, mask);
+#else
+    return get_radix(key, shift, mask);
+#endif
+}
+
+/// Whether key1 is placed strictly before key2 by the sort (keys as stored, not transformed).
+bool precedes(KEY_TYPE key1, KEY_TYPE key2)
+{
+#ifdef TRANSFORM_KEYS
+    key1 = to_sortable_key(key1);
+    key2 = to_sortable_key(key2);
+#endif
+#ifdef DESCENDING
+    KEY_TYPE tmp = key1;
+    key1 = key2;
+    key2 = tmp;
+#endif
+#if KEY_NUM_BITS == 64
+    return key1.y < key2.y || (key1.y == key2.y && key1.x < key2.x);
+#else
+    return key1 < key2;
+#endif
+}
+)";
+    } // namespace detail
+
+    /// The order RadixSort sorts the keys in. Both orders are stable.
+    enum SortOrder
+    {
+        SortOrder_Ascending = 0,
+        SortOrder_Descending
+    };
+} // namespace glu
+
+#endif // GLU_RADIX_SORT_COMMON_HPP
+
+
+
+namespace glu
+{
+    namespace detail
+    {
+        /// The compare-and-swap of the bitonic network: every stage pairs the elements of index i and i ^ j (or, on
+        /// the first stage of a merge of size k, i and i ^ (k - 1), which flips the second half so that all the pairs
+        /// are ordered the same way). Keys past the count behave as the greatest ones: their pairs are skipped, so the
+        /// network sorts any count as if it was padded to a power of 2.
+        inline const char* k_bitonic_sort_common_shader = R"(
+/// The indices of the p-th pair of a stage, the first one being less than the second one.
+uvec2 get_pair(uint p, uint k, uint j)
+{
+    uint i = (p / j) * 2 * j + p % j;
+    return uvec2(i, j == k / 2 ? i ^ (k - 1) : i + j);
+}
+)";
+
+        /// Sorts every block of BLOCK_SIZE keys (and values) on shared memory if u_k is zero. Otherwise, runs the
+        /// stages of the merge of size u_k whose pairs lie within a block (j < BLOCK_SIZE).
+        inline const char* k_bitonic_sort_local_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 1) buffer ValBuffer
+{
+    uint b_val_buffer[];
+};
+#endif
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_k;
+
+shared KEY_TYPE s_key_buffer[BLOCK_SIZE];
+#ifdef WITH_VALUES
+shared uint s_val_buffer[BLOCK_SIZE];
+#endif
+
+void compare_and_swap(uint base_i, uint k, uint j)
+{
+    uvec2 pair = get_pair(gl_LocalInvocationIndex, k, j);
+    if (base_i + pair.y < u_count && precedes(s_key_buffer[pair.y], s_key_buffer[pair.x]))
+    {
+        KEY_TYPE key = s_key_buffer[pair.x];
+        s_key_buffer[pair.x] = s_key_buffer[pair.y];
+        s_key_buffer[pair.y] = key;
+#ifdef WITH_VALUES
+        uint val = s_val_buffer[pair.x];
+        s_val_buffer[pair.x] = s_val_buffer[pair.y];
+        s_val_buffer[pair.y] = val;
+#endif
+    }
+
+    barrier();
+}
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint base_i = workgroup_i * BLOCK_SIZE;
+    if (base_i >= u_count) return;
+
+    for (uint i = gl_LocalInvocationIndex; i < BLOCK_SIZE && base_i + i < u_count; i += NUM_THREADS)
+    {
+        s_key_buffer[i] = b_key_buffer[base_i + i];
+#ifdef WITH_VALUES
+        s_val_buffer[i] = b_val_buffer[base_i + i];
+#endif
+    }
+
+    barrier();
+
+    if (u_k == 0)
+    {
+        for (uint k = 2; k <= BLOCK_SIZE; k *= 2)
+        {
+            for (uint j = k / 2; j > 0; j /= 2) compare_and_swap(base_i, k, j);
+        }
+    }
+    else
+    {
+        for (uint j = BLOCK_SIZE / 2; j > 0; j /= 2) compare_and_swap(base_i, u_k, j);
+    }
+
+    for (uint i = gl_LocalInvocationIndex; i < BLOCK_SIZE && base_i + i < u_count; i += NUM_THREADS)
+    {
+        b_key_buffer[base_i + i] = s_key_buffer[i];
+#ifdef WITH_VALUES
+        b_val_buffer[base_i + i] = s_val_buffer[i];
+#endif
+    }
+}
+)";
+
+        /// Runs a stage of the merge of size u_k whose pairs span more than a block (u_j >= BLOCK_SIZE): a thread per
+        /// pair.
+        inline const char* k_bitonic_sort_global_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 1) buffer ValBuffer
+{
+    uint b_val_buffer[];
+};
+#endif
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_k;
+layout(location = 2) uniform uint u_j;
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uvec2 pair = get_pair(workgroup_i * NUM_THREADS + gl_LocalInvocationIndex, u_k, u_j);
+    if (pair.y >= u_count) return;
+
+    KEY_TYPE key1 = b_key_buffer[pair.x];
+    KEY_TYPE key2 = b_key_buffer[pair.y];
+    if (precedes(key2, key1))
+    {
+        b_key_buffer[pair.x] = key2;
+        b_key_buffer[pair.y] = key1;
+#ifdef WITH_VALUES
+        uint val = b_val_buffer[pair.x];
+        b_val_buffer[pair.x] = b_val_buffer[pair.y];
+        b_val_buffer[pair.y] = val;
+#endif
+    }
+}
+)";
+    } // namespace detail
+
+    /// A class that sorts keys (and values) in place by a bitonic sorting network: no scratch buffer is needed,
+    /// contrary to RadixSort. Blocks are sorted on shared memory first; then, every merge runs its stages spanning
+    /// more than a block as global dispatches, and its last stages on shared memory. It takes O(n log^2 n) compares,
+    /// so it's slower than RadixSort on large counts: it's meant for when memory is short.
+    ///
+    /// The sort isn't stable: the order of equal keys isn't preserved. Keys are compared the way RadixSort orders
+    /// them.
+    class BitonicSort
+    {
+    private:
+        const size_t m_num_threads;
+
+        /// The number of keys sorted on shared memory by a workgroup: a pair per thread.
+        const size_t m_block_size;
+
+        /// The type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or DataType_Double.
+        const DataType m_key_data_type;
+
+        const SortOrder m_order;
+
+        Program m_local_program;
+        Program m_key_only_local_program;
+        Program m_global_program;
+        Program m_key_only_global_program;
+
+    public:
+        /// @param key_data_type the type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or
+        ///                      DataType_Double
+        /// @param order the order keys are sorted in
+        explicit BitonicSort(DataType key_data_type = DataType_Uint, SortOrder order = SortOrder_Ascending) :
+            m_num_threads(512),
+            m_block_size(2 * m_num_threads),
+            m_key_data_type(key_data_type),
+            m_order(order)
+        {
+            GLU_CHECK_ARGUMENT(
+                m_key_data_type == DataType_Uint || m_key_data_type == DataType_Int ||
+                    m_key_data_type == DataType_Float || m_key_data_type == DataType_UVec2 ||
+                    m_key_data_type == DataType_Double,
+                "Invalid key data type: %d",
+                m_key_data_type
+            );
+
+            size_t key_size = get_data_type_size(m_key_data_type);
+
+            std::string shader_src = "#version 460\n\n";
+            shader_src += "#define NUM_THREADS " + std::to_string(m_num_threads) + "\n";
+            shader_src += "#define BLOCK_SIZE " + std::to_string(m_block_size) + "\n";
+            shader_src += std::string("#define KEY_TYPE ") + (key_size == 8 ? "uvec2" : "uint") + "\n";
+            shader_src += "#define KEY_NUM_BITS " + std::to_string(key_size * 8) + "\n";
+            if (m_key_data_type == DataType_Int)
+                shader_src += "#define SIGNED_KEYS\n";
+            else if (m_key_data_type == DataType_Float || m_key_data_type == DataType_Double)
+                shader_src += "#define FLOAT_KEYS\n";
+            if (m_key_data_type != DataType_Uint && m_key_data_type != DataType_UVec2)
+                shader_src += "#define TRANSFORM_KEYS\n";
+            if (m_order == SortOrder_Descending)
+                shader_src += "#define DESCENDING\n";
+            shader_src += detail::k_radix_sort_common_shader;
+            shader_src += detail::k_bitonic_sort_common_shader;
+
+            build_program(m_local_program, shader_src + "#define WITH_VALUES\n" + detail::k_bitonic_sort_local_shader);
+            build_program(m_key_only_local_program, shader_src + detail::k_bitonic_sort_local_shader);
+            build_program(
+                m_global_program, shader_src + "#define WITH_VALUES\n" + detail::k_bitonic_sort_global_shader
+            );
+            build_program(m_key_only_global_program, shader_src + detail::k_bitonic_sort_global_shader);
+        }
+
+        ~BitonicSort() = default;
+
+        [[nodiscard]] DataType key_data_type() const { return m_key_data_type; }
+        [[nodiscard]] SortOrder order() const { return m_order; }
+
+        /// Sorts the given keys (and values) in place.
+        ///
+        /// @param key_buffer the keys (of the key data type)
+        /// @param val_buffer the GLuint values moved along with the keys, or 0 to sort the keys only
+        /// @param count the number of keys (and values)
+        void operator()(GLuint key_buffer, GLuint val_buffer, size_t count)
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+
+            if (count <= 1)
+                return;
+
+            bool with_values = val_buffer != 0;
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+            if (with_values)
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, val_buffer);
+
+            // The network of the next power of 2, whose keys past the count are skipped
+            size_t count_power_of_2 = next_power_of_2(count);
+
+            run_local(with_values, count, 0);
+
+            for (size_t k = 2 * m_block_size; k <= count_power_of_2; k *= 2)
+            {
+                for (size_t j = k / 2; j >= m_block_size; j /= 2)
+                    run_global(with_values, count, k, j);
+
+                run_local(with_values, count, k);
+            }
+        }
+
+    private:
+        void run_local(bool with_values, size_t count, size_t k)
+        {
+            Program& program = with_values ? m_local_program : m_key_only_local_program;
+            program.use();
+
+            glUniform1ui(program.get_uniform_location("u_count"), count);
+            glUniform1ui(program.get_uniform_location("u_k"), k);
+
+            // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(count, m_block_size);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        void run_global(bool with_values, size_t count, size_t k, size_t j)
+        {
+            Program& program = with_values ? m_global_program : m_key_only_global_program;
+            program.use();
+
+            glUniform1ui(program.get_uniform_location("u_count"), count);
+            glUniform1ui(program.get_uniform_location("u_k"), k);
+            glUniform1ui(program.get_uniform_location("u_j"), j);
+
+            // A thread per pair of the network, on two dimensions as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(next_power_of_2(count) / 2, m_num_threads);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_BITONICSORT_HPP
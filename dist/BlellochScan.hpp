@@ -3,11 +3,14 @@
 #ifndef GLU_BLELLOCHSCAN_HPP
 #define GLU_BLELLOCHSCAN_HPP
 
+#include <algorithm>
 #include <string>
 
 #ifndef GLU_REDUCE_HPP
 #define GLU_REDUCE_HPP
 
+#include <algorithm>
+
 #ifndef GLU_DATA_TYPES_HPP
 #define GLU_DATA_TYPES_HPP
 
@@ -74,6 +77,52 @@ namespace glu
         // clang-format on
     }
 
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
 } // namespace glu
 
 #endif // GLU_DATA_TYPES_HPP
@@ -466,6 +515,67 @@ void main()
         }
     }
 }
+)";
+
+        /// Every workgroup reduces a tile of NUM_THREADS * NUM_ITEMS elements of the source (read from u_src_offset) to
+        /// an element of the destination (written at u_dst_offset + its index). No identity is needed: the threads
+        /// past the count sit out the subgroup operations, which only combine the active invocations.
+        inline const char* k_reduction_to_buffer_shader_src = R"(
+#extension GL_KHR_shader_subgroup_arithmetic : require
+
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer SrcBuffer
+{
+    DATA_TYPE b_src_buffer[];
+};
+
+layout(std430, binding = 1) writeonly buffer DstBuffer
+{
+    DATA_TYPE b_dst_buffer[];
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_src_offset;
+layout(location = 2) uniform uint u_dst_offset;
+
+shared DATA_TYPE s_subgroup_buffer[MAX_NUM_SUBGROUPS];
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint tile_i = workgroup_i * NUM_THREADS * NUM_ITEMS;
+    if (tile_i >= u_count) return;
+
+    // The threads holding an element are the first ones of the workgroup, filling its first subgroups
+    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+    uint i = tile_i + thread_i;
+    if (i < u_count)
+    {
+        DATA_TYPE value = b_src_buffer[u_src_offset + i];
+        for (uint item_i = 1; item_i < NUM_ITEMS; item_i++)
+        {
+            uint j = i + item_i * NUM_THREADS;
+            if (j < u_count) value = OPERATOR(value, b_src_buffer[u_src_offset + j]);
+        }
+
+        DATA_TYPE r = SUBGROUP_OPERATION(value);
+        if (subgroupElect()) s_subgroup_buffer[gl_SubgroupID] = r;
+    }
+
+    barrier();
+
+    uint num_subgroups = (min(u_count - tile_i, NUM_THREADS) + gl_SubgroupSize - 1) / gl_SubgroupSize;
+    if (gl_SubgroupID == 0 && gl_SubgroupInvocationID < num_subgroups)
+    {
+        DATA_TYPE value = s_subgroup_buffer[gl_SubgroupInvocationID];
+        for (uint j = gl_SubgroupInvocationID + gl_SubgroupSize; j < num_subgroups; j += gl_SubgroupSize)
+            value = OPERATOR(value, s_subgroup_buffer[j]);
+
+        DATA_TYPE r = SUBGROUP_OPERATION(value);
+        if (subgroupElect()) b_dst_buffer[u_dst_offset + workgroup_i] = r;
+    }
+}
 )";
     }
 
@@ -475,7 +585,8 @@ void main()
         ReduceOperator_Sum = 0,
         ReduceOperator_Mul,
         ReduceOperator_Min,
-        ReduceOperator_Max
+        ReduceOperator_Max,
+        ReduceOperator_Or ///< Bitwise OR, only for integer data types
     };
 
     /// A class that implements the reduction operation.
@@ -488,6 +599,10 @@ void main()
         const size_t m_num_items;
 
         Program m_program;
+        Program m_to_buffer_program;
+
+        /// The partial results of the levels of a reduction to a buffer, but the last one: an element per tile.
+        ShaderStorageBuffer m_scratch_buffer;
 
     public:
         explicit Reduce(DataType data_type, ReduceOperator operator_) :
@@ -496,6 +611,12 @@ void main()
             m_num_threads(1024),
             m_num_items(4)
         {
+            GLint subgroup_size = 0;
+            glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &subgroup_size);
+            GLU_CHECK_STATE(
+                subgroup_size > 0 && m_num_threads % subgroup_size == 0, "Unsupported subgroup size: %d", subgroup_size
+            );
+
             std::string shader_src = "#version 460\n\n";
 
             shader_src += std::string("#define DATA_TYPE ") + to_glsl_type_str(m_data_type) + "\n";
@@ -522,23 +643,27 @@ void main()
                 shader_src += "#define OPERATOR(a, b) (max(a, b))\n";
                 shader_src += "#define SUBGROUP_OPERATION(value) subgroupMax(value)\n";
             }
+            else if (m_operator == ReduceOperator_Or)
+            {
+                GLU_CHECK_ARGUMENT(is_integer_data_type(m_data_type), "OR requires an integer data type");
+
+                shader_src += "#define OPERATOR(a, b) (a | b)\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupOr(value)\n";
+            }
             else
             {
                 GLU_FAIL("Invalid reduction operator: %d", m_operator);
             }
 
-            shader_src += detail::k_reduction_shader_src;
+            shader_src += "#define MAX_NUM_SUBGROUPS " + std::to_string(m_num_threads / subgroup_size) + "\n";
 
-            Shader shader(GL_COMPUTE_SHADER);
-            shader.source_from_str(shader_src.c_str());
-            shader.compile();
-
-            m_program.attach_shader(shader);
-            m_program.link();
+            build_program(m_program, shader_src + detail::k_reduction_shader_src);
+            build_program(m_to_buffer_program, shader_src + detail::k_reduction_to_buffer_shader_src);
         }
 
         ~Reduce() = default;
 
+        /// Reduces the buffer in place: the result is written to its first element, the others are overwritten.
         void operator()(GLuint buffer, size_t count)
         {
             GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
@@ -564,6 +689,82 @@ void main()
                 glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
             }
         }
+
+        /// Reduces a range of the input buffer, left untouched, and writes the result to an element of the result
+        /// buffer. Every level reduces tiles of m_num_threads * m_num_items elements to an element of the internal
+        /// scratch buffer, until a single tile remains, whose result is written straight to the result buffer.
+        ///
+        /// @param input_buffer the input buffer (of the data type), only read
+        /// @param offset the index of the first element to reduce
+        /// @param count the number of elements to reduce (offset + count up to 2^31)
+        /// @param result_buffer the buffer the result is written to; it can be the input buffer, outside of the range
+        /// @param result_offset the index of the element of the result buffer the result is written to
+        void operator()(GLuint input_buffer, size_t offset, size_t count, GLuint result_buffer, size_t result_offset)
+        {
+            GLU_CHECK_ARGUMENT(input_buffer, "Invalid input buffer");
+            GLU_CHECK_ARGUMENT(result_buffer, "Invalid result buffer");
+            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
+            GLU_CHECK_ARGUMENT(offset + count <= (size_t(1) << 31), "The range must end within 2^31 elements");
+            GLU_CHECK_ARGUMENT(result_offset < (size_t(1) << 31), "Result offset must be less than 2^31");
+
+            size_t tile_size = m_num_threads * m_num_items;
+
+            // Every level but the last one writes its results after those of the previous level
+            size_t required_count = 0;
+            for (size_t level_count = div_ceil(count, tile_size); level_count > 1;
+                 level_count = div_ceil(level_count, tile_size))
+                required_count += level_count;
+
+            size_t required_size = required_count * get_data_type_size(m_data_type);
+            if (m_scratch_buffer.size() < required_size)
+                m_scratch_buffer.resize(required_size, false);
+
+            m_to_buffer_program.use();
+
+            GLuint src_buffer = input_buffer;
+            size_t src_offset = offset;
+            size_t level_count = count;
+            size_t scratch_offset = 0;
+            while (true)
+            {
+                size_t num_workgroups = div_ceil(level_count, tile_size);
+                bool last_level = num_workgroups == 1;
+
+                GLuint dst_buffer = last_level ? result_buffer : m_scratch_buffer.handle();
+                size_t dst_offset = last_level ? result_offset : scratch_offset;
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src_buffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, dst_buffer);
+
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_count"), level_count);
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_src_offset"), src_offset);
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_dst_offset"), dst_offset);
+
+                // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+                size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+                glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+                if (last_level)
+                    break;
+
+                src_buffer = m_scratch_buffer.handle();
+                src_offset = scratch_offset;
+                level_count = num_workgroups;
+                scratch_offset += num_workgroups;
+            }
+        }
+
+    private:
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
     };
 } // namespace glu
 
@@ -636,6 +837,52 @@ namespace glu
         // clang-format on
     }
 
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
 } // namespace glu
 
 #endif // GLU_DATA_TYPES_HPP
@@ -646,8 +893,10 @@ namespace glu
 {
     namespace detail
     {
-        inline const char* k_upsweep_shader_src = R"(
-#extension GL_KHR_shader_subgroup_shuffle_relative : require
+        /// The exclusive scan of a value per thread of the workgroup: every subgroup scans its values, then the first
+        /// subgroup scans the totals of the subgroups (by chunks of gl_SubgroupSize, if there are more of them).
+        inline const char* k_scan_common_shader_src = R"(
+#extension GL_KHR_shader_subgroup_arithmetic : require
 
 layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
 
@@ -656,173 +905,346 @@ layout(std430, binding = 0) buffer Buffer
     DATA_TYPE data[];
 };
 
+layout(std430, binding = 1) buffer BlockSumBuffer
+{
+    DATA_TYPE b_block_sum_buffer[]; // num_partitions * num_blocks
+};
+
 layout(location = 0) uniform uint u_count;
-layout(location = 1) uniform uint u_step;
+layout(location = 1) uniform uint u_num_blocks;
 
-void main()
+shared DATA_TYPE s_subgroup_buffer[MAX_NUM_SUBGROUPS];
+shared DATA_TYPE s_total;
+
+/// Returns the exclusive scan of the value of this thread, and writes the total of the workgroup to s_total.
+DATA_TYPE workgroup_exclusive_scan(DATA_TYPE value)
 {
-    uint partition_i = gl_WorkGroupID.y;
-    uint thread_i = gl_WorkGroupID.x * NUM_THREADS + gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
-    uint i = partition_i * u_count + thread_i * u_step + u_step - 1;
-    uint end_i = (partition_i + 1) * u_count;
-    if (i < end_i)
+    DATA_TYPE prefix = SUBGROUP_EXCLUSIVE_OPERATION(value);
+    DATA_TYPE subgroup_total = SUBGROUP_OPERATION(value);
+    if (subgroupElect()) s_subgroup_buffer[gl_SubgroupID] = subgroup_total;
+
+    barrier();
+
+    if (gl_SubgroupID == 0)
     {
-        DATA_TYPE lval = subgroupShuffleUp(data[i], 1);
-        DATA_TYPE r = OPERATION(data[i], lval);
-        if (i == end_i - 1)  // Clear last
+        DATA_TYPE carry = IDENTITY;
+        for (uint base_i = 0; base_i < gl_NumSubgroups; base_i += gl_SubgroupSize)
         {
-            data[i] = IDENTITY;
-        }
-        else if (gl_SubgroupInvocationID % 2 == 1)
-        {
-            data[i] = r;
+            uint i = base_i + gl_SubgroupInvocationID;
+            DATA_TYPE sum = i < gl_NumSubgroups ? s_subgroup_buffer[i] : IDENTITY;
+            if (i < gl_NumSubgroups) s_subgroup_buffer[i] = OPERATION(carry, SUBGROUP_EXCLUSIVE_OPERATION(sum));
+            carry = OPERATION(carry, SUBGROUP_OPERATION(sum));
         }
+        if (subgroupElect()) s_total = carry;
     }
+
+    barrier();
+
+    return OPERATION(s_subgroup_buffer[gl_SubgroupID], prefix);
 }
 )";
 
-        inline const char* k_downsweep_shader_src = R"(
-layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+        /// Phase 1: every workgroup reduces a tile of NUM_THREADS * NUM_ITEMS elements to its block sum. Items are
+        /// read NUM_THREADS apart, the order doesn't matter here.
+        inline const char* k_scan_reduce_shader_src = R"(
+void main()
+{
+    uint partition_i = gl_WorkGroupID.z;
+    uint block_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (block_i >= u_num_blocks) return; // The 2D dispatch may exceed the blocks (uniform per workgroup)
 
-layout(std430, binding = 0) buffer Buffer
+    uint base_i = partition_i * u_count;
+    uint tile_i = block_i * NUM_THREADS * NUM_ITEMS;
+
+    DATA_TYPE thread_sum = IDENTITY;
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        uint i = tile_i + item_i * NUM_THREADS + gl_LocalInvocationIndex;
+        if (i < u_count) thread_sum = OPERATION(thread_sum, data[base_i + i]);
+    }
+
+    workgroup_exclusive_scan(thread_sum);
+
+    if (gl_LocalInvocationIndex == 0) b_block_sum_buffer[partition_i * u_num_blocks + block_i] = s_total;
+}
+)";
+
+        /// Phase 2: a workgroup per partition scans its block sums, a tile at a time.
+        inline const char* k_scan_block_sums_shader_src = R"(
+void main()
 {
-    DATA_TYPE data[];
-};
+    uint partition_i = gl_WorkGroupID.z;
+    uint base_i = partition_i * u_num_blocks;
 
-layout(location = 0) uniform uint u_count;
-layout(location = 1) uniform uint u_step;
+    DATA_TYPE carry = IDENTITY;
+    for (uint tile_i = 0; tile_i < u_num_blocks; tile_i += NUM_THREADS * NUM_ITEMS)
+    {
+        uint i = tile_i + gl_LocalInvocationIndex * NUM_ITEMS;
+
+        DATA_TYPE items[NUM_ITEMS];
+        DATA_TYPE thread_sum = IDENTITY;
+        for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+        {
+            items[item_i] = i + item_i < u_num_blocks ? b_block_sum_buffer[base_i + i + item_i] : IDENTITY;
+            thread_sum = OPERATION(thread_sum, items[item_i]);
+        }
+
+        DATA_TYPE prefix = OPERATION(carry, workgroup_exclusive_scan(thread_sum));
+        for (uint item_i = 0; item_i < NUM_ITEMS && i + item_i < u_num_blocks; item_i++)
+        {
+            b_block_sum_buffer[base_i + i + item_i] = prefix;
+            prefix = OPERATION(prefix, items[item_i]);
+        }
+
+        carry = OPERATION(carry, s_total);
+
+        barrier(); // s_total and s_subgroup_buffer are written again by the next tile
+    }
+}
+)";
 
+        /// Phase 3: every workgroup scans its tile, NUM_ITEMS consecutive elements per thread, starting from the
+        /// scanned sum of the blocks before it. If INCLUSIVE, every element is included in its own prefix.
+        inline const char* k_scan_downsweep_shader_src = R"(
 void main()
 {
-    uint partition_i = gl_WorkGroupID.y;
-    uint i = partition_i * u_count + gl_GlobalInvocationID.x * (u_step << 1) + (u_step - 1);
-    uint next_i = i + u_step;
-    uint end_i = (partition_i + 1) * u_count;
-    if (next_i < end_i)
-    {
-        DATA_TYPE tmp = data[i];
-        data[i] = data[next_i];
-        data[next_i] = data[next_i] + tmp;
+    uint partition_i = gl_WorkGroupID.z;
+    uint block_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (block_i >= u_num_blocks) return;
+
+    uint base_i = partition_i * u_count;
+    uint i = block_i * NUM_THREADS * NUM_ITEMS + gl_LocalInvocationIndex * NUM_ITEMS;
+
+    DATA_TYPE items[NUM_ITEMS];
+    DATA_TYPE thread_sum = IDENTITY;
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        items[item_i] = i + item_i < u_count ? data[base_i + i + item_i] : IDENTITY;
+        thread_sum = OPERATION(thread_sum, items[item_i]);
     }
-    else if (i < end_i)
+
+    DATA_TYPE block_prefix = b_block_sum_buffer[partition_i * u_num_blocks + block_i];
+    DATA_TYPE prefix = OPERATION(block_prefix, workgroup_exclusive_scan(thread_sum));
+    for (uint item_i = 0; item_i < NUM_ITEMS && i + item_i < u_count; item_i++)
     {
-        data[i] = IDENTITY;
+#ifdef INCLUSIVE
+        prefix = OPERATION(prefix, items[item_i]);
+        data[base_i + i + item_i] = prefix;
+#else
+        data[base_i + i + item_i] = prefix;
+        prefix = OPERATION(prefix, items[item_i]);
+#endif
     }
 }
 )";
+
+        /// The definitions of OPERATION, its subgroup operations and its IDENTITY, for the given data type (vector
+        /// types are combined component-wise).
+        inline std::string get_scan_operator_src(DataType data_type, ReduceOperator operator_)
+        {
+            std::string component_type = to_glsl_component_type_str(data_type);
+
+            // The greatest and the lowest component values, the identities of Min and Max
+            std::string greatest, lowest;
+            if (component_type == "float")
+            {
+                greatest = "uintBitsToFloat(0x7f800000u)"; // +inf
+                lowest = "uintBitsToFloat(0xff800000u)";   // -inf
+            }
+            else if (component_type == "double")
+            {
+                greatest = "packDouble2x32(uvec2(0u, 0x7ff00000u))"; // +inf
+                lowest = "packDouble2x32(uvec2(0u, 0xfff00000u))";   // -inf
+            }
+            else if (component_type == "int")
+            {
+                greatest = "0x7fffffff";
+                lowest = "(-0x7fffffff - 1)";
+            }
+            else
+            {
+                greatest = "0xffffffffu";
+                lowest = "0u";
+            }
+
+            std::string src;
+            if (operator_ == ReduceOperator_Sum)
+            {
+                src += "#define OPERATION(a, b) (a + b)\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupAdd(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveAdd(value)\n";
+                src += "#define IDENTITY DATA_TYPE(0)\n";
+            }
+            else if (operator_ == ReduceOperator_Mul)
+            {
+                src += "#define OPERATION(a, b) (a * b)\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupMul(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveMul(value)\n";
+                src += "#define IDENTITY DATA_TYPE(1)\n";
+            }
+            else if (operator_ == ReduceOperator_Min)
+            {
+                src += "#define OPERATION(a, b) (min(a, b))\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupMin(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveMin(value)\n";
+                src += "#define IDENTITY DATA_TYPE(" + greatest + ")\n";
+            }
+            else if (operator_ == ReduceOperator_Max)
+            {
+                src += "#define OPERATION(a, b) (max(a, b))\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupMax(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveMax(value)\n";
+                src += "#define IDENTITY DATA_TYPE(" + lowest + ")\n";
+            }
+            else if (operator_ == ReduceOperator_Or)
+            {
+                GLU_CHECK_ARGUMENT(is_integer_data_type(data_type), "OR requires an integer data type");
+
+                src += "#define OPERATION(a, b) (a | b)\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupOr(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveOr(value)\n";
+                src += "#define IDENTITY DATA_TYPE(0)\n";
+            }
+            else
+            {
+                GLU_FAIL("Invalid scan operator: %d", operator_);
+            }
+            return src;
+        }
     } // namespace detail
 
-    /// A class that implements Blelloch scan algorithm (exclusive prefix sum).
+    /// The kinds of scan: whether every element is included in its own prefix.
+    enum ScanType
+    {
+        ScanType_Exclusive = 0,
+        ScanType_Inclusive
+    };
+
+    /// A class that implements a prefix scan (by default an exclusive prefix sum), by reduce-then-scan: every block of
+    /// NUM_THREADS * NUM_ITEMS elements is reduced to its sum, the block sums are scanned by a single workgroup, then
+    /// every block is scanned starting from its scanned sum. That's 3 dispatches whatever the count, reading the
+    /// elements twice and writing them once.
+    ///
+    /// Vector data types are scanned component-wise, e.g. DataType_Vec4 runs 4 prefix sums at once.
     class BlellochScan
     {
     private:
         const DataType m_data_type;
+        const ReduceOperator m_operator;
+        const ScanType m_scan_type;
         const size_t m_num_threads;
         const size_t m_num_items;
 
-        Program m_upsweep_program;
+        Program m_reduce_program;
+        Program m_block_sums_program;
         Program m_downsweep_program;
 
+        /// The sum of every block, then its exclusive prefix (for every partition).
+        ShaderStorageBuffer m_block_sum_buffer;
+
     public:
-        explicit BlellochScan(DataType data_type) :
+        /// @param data_type the type of the elements
+        /// @param operator_ the operator of the scan (ReduceOperator_Or only for integer data types)
+        /// @param scan_type whether the scan is exclusive (the first element is the identity) or inclusive
+        explicit BlellochScan(
+            DataType data_type,
+            ReduceOperator operator_ = ReduceOperator_Sum,
+            ScanType scan_type = ScanType_Exclusive
+        ) :
             m_data_type(data_type),
+            m_operator(operator_),
+            m_scan_type(scan_type),
             m_num_threads(1024),
             m_num_items(4)
         {
+            GLint subgroup_size = 0;
+            glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &subgroup_size);
+            GLU_CHECK_STATE(
+                subgroup_size > 0 && m_num_threads % subgroup_size == 0, "Unsupported subgroup size: %d", subgroup_size
+            );
+
             std::string shader_src = "#version 460\n\n";
 
             shader_src += std::string("#define DATA_TYPE ") + to_glsl_type_str(m_data_type) + "\n";
-            shader_src += "#define OPERATION(a, b) (a + b)\n";
-            shader_src += "#define IDENTITY 0\n";
+            shader_src += detail::get_scan_operator_src(m_data_type, m_operator);
+            if (m_scan_type == ScanType_Inclusive)
+                shader_src += "#define INCLUSIVE\n";
             shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
             shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
+            shader_src += "#define MAX_NUM_SUBGROUPS " + std::to_string(m_num_threads / subgroup_size) + "\n";
+            shader_src += detail::k_scan_common_shader_src;
 
-            { // Upsweep program
-                Shader upsweep_shader(GL_COMPUTE_SHADER);
-                upsweep_shader.source_from_str((shader_src + detail::k_upsweep_shader_src).c_str());
-                upsweep_shader.compile();
-
-                m_upsweep_program.attach_shader(upsweep_shader);
-                m_upsweep_program.link();
-            }
-
-            { // Downsweep program
-                Shader downsweep_program(GL_COMPUTE_SHADER);
-                downsweep_program.source_from_str((shader_src + detail::k_downsweep_shader_src).c_str());
-                downsweep_program.compile();
-
-                m_downsweep_program.attach_shader(downsweep_program);
-                m_downsweep_program.link();
-            }
+            build_program(m_reduce_program, shader_src + detail::k_scan_reduce_shader_src);
+            build_program(m_block_sums_program, shader_src + detail::k_scan_block_sums_shader_src);
+            build_program(m_downsweep_program, shader_src + detail::k_scan_downsweep_shader_src);
         }
 
         ~BlellochScan() = default;
 
-        /// Runs Blelloch exclusive scan on multiple partitions.
+        /// Runs the scan on multiple partitions, in place.
         ///
-        /// @param buffer the input GLuint buffer
-        /// @param count the number of GLuint in the buffer (must be a power of 2)
+        /// @param buffer the input buffer (of the data type)
+        /// @param count the number of elements in every partition (up to 2^30)
         /// @param num_partitions the number of partitions (must be adjacent)
         void operator()(GLuint buffer, size_t count, size_t num_partitions = 1)
         {
             GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
             GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
-            GLU_CHECK_ARGUMENT(is_power_of_2(count), "Count must be a power of 2"); // TODO Remove this requirement
+            GLU_CHECK_ARGUMENT(count <= (size_t(1) << 30), "Count must be at most 2^30");
             GLU_CHECK_ARGUMENT(num_partitions >= 1, "Num of partitions must be >= 1");
 
-            upsweep(buffer, count, num_partitions); // Also clear last
-            downsweep(buffer, count, num_partitions);
-        }
+            size_t num_blocks = div_ceil(count, m_num_threads * m_num_items);
 
-    private:
-        void upsweep(GLuint buffer, size_t count, size_t num_partitions) // Also clear last
-        {
-            m_upsweep_program.use();
+            size_t required_size = num_partitions * num_blocks * get_data_type_size(m_data_type);
+            if (m_block_sum_buffer.size() < required_size)
+                m_block_sum_buffer.resize(required_size, false);
 
-            glUniform1ui(m_upsweep_program.get_uniform_location("u_count"), count);
             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+            m_block_sum_buffer.bind(1);
 
-            int step = 1;
-            int level_count = (int) count;
-            while (true)
-            {
-                glUniform1ui(m_upsweep_program.get_uniform_location("u_step"), step);
+            // Blocks on two dimensions, as the guaranteed max workgroup count is 65535; partitions on the third one
+            size_t num_blocks_x = std::min<size_t>(num_blocks, 65535);
+            size_t num_blocks_y = div_ceil(num_blocks, num_blocks_x);
 
-                size_t num_workgroups = div_ceil<size_t>(level_count, m_num_threads);
-                glDispatchCompute(num_workgroups, num_partitions, 1);
-                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            // ---------------------------------------------------------------- Reduce
 
-                step <<= 1;
+            m_reduce_program.use();
 
-                level_count >>= 1;
+            glUniform1ui(m_reduce_program.get_uniform_location("u_count"), count);
+            glUniform1ui(m_reduce_program.get_uniform_location("u_num_blocks"), num_blocks);
 
-                if (level_count <= 1)
-                    break;
-            }
-        }
+            glDispatchCompute(num_blocks_x, num_blocks_y, num_partitions);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // ---------------------------------------------------------------- Scan of block sums
+
+            m_block_sums_program.use();
+
+            glUniform1ui(m_block_sums_program.get_uniform_location("u_num_blocks"), num_blocks);
+
+            glDispatchCompute(1, 1, num_partitions);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // ---------------------------------------------------------------- Downsweep
 
-        void downsweep(GLuint buffer, size_t count, size_t num_partitions)
-        {
             m_downsweep_program.use();
 
             glUniform1ui(m_downsweep_program.get_uniform_location("u_count"), count);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+            glUniform1ui(m_downsweep_program.get_uniform_location("u_num_blocks"), num_blocks);
 
-            int step = next_power_of_2(int(count)) >> 1;
-            size_t level_count = 1;
-            while (true)
-            {
-                glUniform1ui(m_downsweep_program.get_uniform_location("u_step"), step);
+            glDispatchCompute(num_blocks_x, num_blocks_y, num_partitions);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
 
-                size_t num_workgroups = div_ceil(level_count, m_num_threads);
-                glDispatchCompute(num_workgroups, num_partitions, 1);
-                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    private:
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
 
-                step >>= 1;
-                level_count <<= 1;
-                if (step == 0)
-                    break;
-            }
+            program.attach_shader(shader);
+            program.link();
         }
     };
 } // namespace glu
@@ -0,0 +1,1974 @@
+// This code was automatically generated; you're not supposed to edit it!
+
+#ifndef GLU_COUNTINGSORT_HPP
+#define GLU_COUNTINGSORT_HPP
+
+#include <algorithm>
+
+#ifndef GLU_BLELLOCHSCAN_HPP
+#define GLU_BLELLOCHSCAN_HPP
+
+#include <algorithm>
+#include <string>
+
+#ifndef GLU_REDUCE_HPP
+#define GLU_REDUCE_HPP
+
+#include <algorithm>
+
+#ifndef GLU_DATA_TYPES_HPP
+#define GLU_DATA_TYPES_HPP
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    enum DataType
+    {
+        DataType_Float = 0,
+        DataType_Double,
+        DataType_Int,
+        DataType_Uint,
+        DataType_Vec2,
+        DataType_Vec4,
+        DataType_DVec2,
+        DataType_DVec4,
+        DataType_UVec2,
+        DataType_UVec4,
+        DataType_IVec2,
+        DataType_IVec4
+    };
+
+    inline const char* to_glsl_type_str(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return "float";
+        else if (data_type == DataType_Double) return "double";
+        else if (data_type == DataType_Int)    return "int";
+        else if (data_type == DataType_Uint)   return "uint";
+        else if (data_type == DataType_Vec2)   return "vec2";
+        else if (data_type == DataType_Vec4)   return "vec4";
+        else if (data_type == DataType_DVec2)  return "dvec2";
+        else if (data_type == DataType_DVec4)  return "dvec4";
+        else if (data_type == DataType_UVec2)  return "uvec2";
+        else if (data_type == DataType_UVec4)  return "uvec4";
+        else if (data_type == DataType_IVec2)  return "ivec2";
+        else if (data_type == DataType_IVec4)  return "ivec4";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+} // namespace glu
+
+#endif // GLU_DATA_TYPES_HPP
+
+
+#ifndef GLU_GL_UTILS_HPP
+#define GLU_GL_UTILS_HPP
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    inline void
+    copy_buffer(GLuint src_buffer, GLuint dst_buffer, size_t size, size_t src_offset = 0, size_t dst_offset = 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, src_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, dst_buffer);
+
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr) src_offset, (GLintptr) dst_offset, (GLsizeiptr) size
+        );
+    }
+
+    /// A RAII wrapper for GL shader.
+    class Shader
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Shader(GLenum type) :
+            m_handle(glCreateShader(type)){};
+        Shader(const Shader&) = delete;
+
+        Shader(Shader&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Shader() { glDeleteShader(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void source_from_str(const std::string& src_str)
+        {
+            const char* src_ptr = src_str.c_str();
+            glShaderSource(m_handle, 1, &src_ptr, nullptr);
+        }
+
+        void source_from_file(const char* src_filepath)
+        {
+            FILE* file = fopen(src_filepath, "rt");
+            GLU_CHECK_STATE(!file, "Failed to shader file: %s", src_filepath);
+
+            fseek(file, 0, SEEK_END);
+            size_t file_size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+
+            std::string src{};
+            src.resize(file_size);
+            fread(src.data(), sizeof(char), file_size, file);
+            source_from_str(src.c_str());
+
+            fclose(file);
+        }
+
+        std::string get_info_log()
+        {
+            GLint log_length = 0;
+            glGetShaderiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetShaderInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void compile()
+        {
+            glCompileShader(m_handle);
+
+            GLint status;
+            glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Shader failed to compile: %s", get_info_log().c_str());
+            }
+        }
+    };
+
+    /// A RAII wrapper for GL program.
+    class Program
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Program() { m_handle = glCreateProgram(); };
+        Program(const Program&) = delete;
+
+        Program(Program&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Program() { glDeleteProgram(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void attach_shader(GLuint shader_handle) { glAttachShader(m_handle, shader_handle); }
+        void attach_shader(const Shader& shader) { glAttachShader(m_handle, shader.handle()); }
+
+        [[nodiscard]] std::string get_info_log() const
+        {
+            GLint log_length = 0;
+            glGetProgramiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetProgramInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void link()
+        {
+            GLint status;
+            glLinkProgram(m_handle);
+            glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Program failed to link: %s", get_info_log().c_str());
+            }
+        }
+
+        void use() { glUseProgram(m_handle); }
+
+        GLint get_uniform_location(const char* uniform_name)
+        {
+            GLint loc = glGetUniformLocation(m_handle, uniform_name);
+            GLU_CHECK_STATE(loc >= 0, "Failed to get uniform location: %s", uniform_name);
+            return loc;
+        }
+    };
+
+    /// A RAII helper class for GL shader storage buffer.
+    class ShaderStorageBuffer
+    {
+    private:
+        GLuint m_handle = 0;
+        size_t m_size = 0;
+
+    public:
+        explicit ShaderStorageBuffer(size_t initial_size = 0)
+        {
+            if (initial_size > 0)
+                resize(initial_size, false);
+        }
+
+        explicit ShaderStorageBuffer(const void* data, size_t size) :
+            m_size(size)
+        {
+            GLU_CHECK_ARGUMENT(data, "");
+            GLU_CHECK_ARGUMENT(size > 0, "");
+
+            glCreateBuffers(1, &m_handle);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, data, GL_DYNAMIC_STORAGE_BIT);
+        }
+
+        template<typename T>
+        explicit ShaderStorageBuffer(const std::vector<T>& data) :
+            ShaderStorageBuffer(data.data(), data.size() * sizeof(T))
+        {
+        }
+
+        ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+        ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            m_size = other.m_size;
+            other.m_handle = 0;
+        }
+
+        ~ShaderStorageBuffer()
+        {
+            if (m_handle)
+                glDeleteBuffers(1, &m_handle);
+        }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        /// Grows or shrinks the buffer. If keep_data, performs an additional copy to maintain the data.
+        void resize(size_t size, bool keep_data = false)
+        {
+            size_t old_size = m_size;
+            GLuint old_handle = m_handle;
+
+            if (old_size != size)
+            {
+                m_size = size;
+
+                glCreateBuffers(1, &m_handle);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+                glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+                if (keep_data)
+                    copy_buffer(old_handle, m_handle, std::min(old_size, size));
+
+                glDeleteBuffers(1, &old_handle);
+            }
+        }
+
+        /// Clears the entire buffer with the given GLuint value (repeated).
+        void clear(GLuint value)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED, GL_UNSIGNED_INT, &value);
+        }
+
+        void write_data(const void* data, size_t size)
+        {
+            GLU_CHECK_ARGUMENT(size <= m_size, "");
+
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+        }
+
+        template<typename T>
+        std::vector<T> get_data() const
+        {
+            GLU_CHECK_ARGUMENT(m_size % sizeof(T) == 0, "Size %zu isn't a multiple of %zu", m_size, sizeof(T));
+
+            std::vector<T> result(m_size / sizeof(T));
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) m_size, result.data());
+            return result;
+        }
+
+        void bind(GLuint index, size_t size = 0, size_t offset = 0)
+        {
+            if (size == 0)
+                size = m_size;
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, m_handle, (GLintptr) offset, (GLsizeiptr) size);
+        }
+    };
+
+    /// Measures elapsed time on GPU for executing the given callback.
+    inline uint64_t measure_gl_elapsed_time(const std::function<void()>& callback)
+    {
+        GLuint query;
+        uint64_t elapsed_time{};
+
+        glGenQueries(1, &query);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        callback();
+
+        glEndQuery(GL_TIME_ELAPSED);
+
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
+        glDeleteQueries(1, &query);
+
+        return elapsed_time;
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_floor(IntegerT n)
+    {
+        return (IntegerT) floor(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_ceil(IntegerT n)
+    {
+        return (IntegerT) ceil(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT div_ceil(IntegerT n, IntegerT d)
+    {
+        return (IntegerT) ceil(double(n) / double(d));
+    }
+
+    template<typename T>
+    bool is_power_of_2(T n)
+    {
+        return (n & (n - 1)) == 0;
+    }
+
+    template<typename IntegerT>
+    IntegerT next_power_of_2(IntegerT n)
+    {
+        n--;
+        n |= n >> 1;
+        n |= n >> 2;
+        n |= n >> 4;
+        n |= n >> 8;
+        n |= n >> 16;
+        n++;
+        return n;
+    }
+
+    template<typename Iterator>
+    void print_stl_container(Iterator begin, Iterator end)
+    {
+        size_t i = 0;
+        for (; begin != end; begin++)
+        {
+            printf("(%zu) %s, ", i, std::to_string(*begin).c_str());
+            i++;
+        }
+        printf("\n");
+    }
+
+    template<typename T>
+    void print_buffer(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<T> data = buffer.get_data<T>();
+        print_stl_container(data.begin(), data.end());
+    }
+
+    inline void print_buffer_hex(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<GLuint> data = buffer.get_data<GLuint>();
+        for (size_t i = 0; i < data.size(); i++)
+            printf("(%zu) %08x, ", i, data[i]);
+        printf("\n");
+    }
+} // namespace glu
+
+#endif // GLU_GL_UTILS_HPP
+
+
+
+namespace glu
+{
+    namespace detail
+    {
+        inline const char* k_reduction_shader_src = R"(
+#extension GL_KHR_shader_subgroup_arithmetic : require
+
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer Buffer
+{
+    DATA_TYPE data[];
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_depth;
+
+void main()
+{
+    uint step = 1 << (5 * u_depth);
+    uint subgroup_i = gl_WorkGroupID.x * NUM_THREADS + gl_SubgroupID * gl_SubgroupSize;
+    uint i = (subgroup_i + gl_SubgroupInvocationID) * step;
+    if (i < u_count)
+    {
+        DATA_TYPE r = SUBGROUP_OPERATION(data[i]);
+        if (gl_SubgroupInvocationID == 0)
+        {
+            data[i] = r;
+        }
+    }
+}
+)";
+
+        /// Every workgroup reduces a tile of NUM_THREADS * NUM_ITEMS elements of the source (read from u_src_offset) to
+        /// an element of the destination (written at u_dst_offset + its index). No identity is needed: the threads
+        /// past the count sit out the subgroup operations, which only combine the active invocations.
+        inline const char* k_reduction_to_buffer_shader_src = R"(
+#extension GL_KHR_shader_subgroup_arithmetic : require
+
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer SrcBuffer
+{
+    DATA_TYPE b_src_buffer[];
+};
+
+layout(std430, binding = 1) writeonly buffer DstBuffer
+{
+    DATA_TYPE b_dst_buffer[];
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_src_offset;
+layout(location = 2) uniform uint u_dst_offset;
+
+shared DATA_TYPE s_subgroup_buffer[MAX_NUM_SUBGROUPS];
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint tile_i = workgroup_i * NUM_THREADS * NUM_ITEMS;
+    if (tile_i >= u_count) return;
+
+    // The threads holding an element are the first ones of the workgroup, filling its first subgroups
+    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+    uint i = tile_i + thread_i;
+    if (i < u_count)
+    {
+        DATA_TYPE value = b_src_buffer[u_src_offset + i];
+        for (uint item_i = 1; item_i < NUM_ITEMS; item_i++)
+        {
+            uint j = i + item_i * NUM_THREADS;
+            if (j < u_count) value = OPERATOR(value, b_src_buffer[u_src_offset + j]);
+        }
+
+        DATA_TYPE r = SUBGROUP_OPERATION(value);
+        if (subgroupElect()) s_subgroup_buffer[gl_SubgroupID] = r;
+    }
+
+    barrier();
+
+    uint num_subgroups = (min(u_count - tile_i, NUM_THREADS) + gl_SubgroupSize - 1) / gl_SubgroupSize;
+    if (gl_SubgroupID == 0 && gl_SubgroupInvocationID < num_subgroups)
+    {
+        DATA_TYPE value = s_subgroup_buffer[gl_SubgroupInvocationID];
+        for (uint j = gl_SubgroupInvocationID + gl_SubgroupSize; j < num_subgroups; j += gl_SubgroupSize)
+            value = OPERATOR(value, s_subgroup_buffer[j]);
+
+        DATA_TYPE r = SUBGROUP_OPERATION(value);
+        if (subgroupElect()) b_dst_buffer[u_dst_offset + workgroup_i] = r;
+    }
+}
+)";
+    }
+
+    /// The operators that can be used for the reduction operation.
+    enum ReduceOperator
+    {
+        ReduceOperator_Sum = 0,
+        ReduceOperator_Mul,
+        ReduceOperator_Min,
+        ReduceOperator_Max,
+        ReduceOperator_Or ///< Bitwise OR, only for integer data types
+    };
+
+    /// A class that implements the reduction operation.
+    class Reduce
+    {
+    private:
+        const DataType m_data_type;
+        const ReduceOperator m_operator;
+        const size_t m_num_threads;
+        const size_t m_num_items;
+
+        Program m_program;
+        Program m_to_buffer_program;
+
+        /// The partial results of the levels of a reduction to a buffer, but the last one: an element per tile.
+        ShaderStorageBuffer m_scratch_buffer;
+
+    public:
+        explicit Reduce(DataType data_type, ReduceOperator operator_) :
+            m_data_type(data_type),
+            m_operator(operator_),
+            m_num_threads(1024),
+            m_num_items(4)
+        {
+            GLint subgroup_size = 0;
+            glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &subgroup_size);
+            GLU_CHECK_STATE(
+                subgroup_size > 0 && m_num_threads % subgroup_size == 0, "Unsupported subgroup size: %d", subgroup_size
+            );
+
+            std::string shader_src = "#version 460\n\n";
+
+            shader_src += std::string("#define DATA_TYPE ") + to_glsl_type_str(m_data_type) + "\n";
+            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
+            shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
+
+            if (m_operator == ReduceOperator_Sum)
+            {
+                shader_src += "#define OPERATOR(a, b) (a + b)\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupAdd(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Mul)
+            {
+                shader_src += "#define OPERATOR(a, b) (a * b)\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMul(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Min)
+            {
+                shader_src += "#define OPERATOR(a, b) (min(a, b))\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMin(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Max)
+            {
+                shader_src += "#define OPERATOR(a, b) (max(a, b))\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMax(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Or)
+            {
+                GLU_CHECK_ARGUMENT(is_integer_data_type(m_data_type), "OR requires an integer data type");
+
+                shader_src += "#define OPERATOR(a, b) (a | b)\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupOr(value)\n";
+            }
+            else
+            {
+                GLU_FAIL("Invalid reduction operator: %d", m_operator);
+            }
+
+            shader_src += "#define MAX_NUM_SUBGROUPS " + std::to_string(m_num_threads / subgroup_size) + "\n";
+
+            build_program(m_program, shader_src + detail::k_reduction_shader_src);
+            build_program(m_to_buffer_program, shader_src + detail::k_reduction_to_buffer_shader_src);
+        }
+
+        ~Reduce() = default;
+
+        /// Reduces the buffer in place: the result is written to its first element, the others are overwritten.
+        void operator()(GLuint buffer, size_t count)
+        {
+            GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
+            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
+
+            m_program.use();
+
+            glUniform1ui(m_program.get_uniform_location("u_count"), count);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+
+            for (int depth = 0;; depth++)
+            {
+                int step = 1 << (5 * depth);
+                if (step >= count)
+                    break;
+
+                size_t level_count = count >> (5 * depth);
+
+                glUniform1ui(m_program.get_uniform_location("u_depth"), depth);
+
+                size_t num_workgroups = div_ceil(level_count, m_num_threads);
+                glDispatchCompute(num_workgroups, 1, 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            }
+        }
+
+        /// Reduces a range of the input buffer, left untouched, and writes the result to an element of the result
+        /// buffer. Every level reduces tiles of m_num_threads * m_num_items elements to an element of the internal
+        /// scratch buffer, until a single tile remains, whose result is written straight to the result buffer.
+        ///
+        /// @param input_buffer the input buffer (of the data type), only read
+        /// @param offset the index of the first element to reduce
+        /// @param count the number of elements to reduce (offset + count up to 2^31)
+        /// @param result_buffer the buffer the result is written to; it can be the input buffer, outside of the range
+        /// @param result_offset the index of the element of the result buffer the result is written to
+        void operator()(GLuint input_buffer, size_t offset, size_t count, GLuint result_buffer, size_t result_offset)
+        {
+            GLU_CHECK_ARGUMENT(input_buffer, "Invalid input buffer");
+            GLU_CHECK_ARGUMENT(result_buffer, "Invalid result buffer");
+            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
+            GLU_CHECK_ARGUMENT(offset + count <= (size_t(1) << 31), "The range must end within 2^31 elements");
+            GLU_CHECK_ARGUMENT(result_offset < (size_t(1) << 31), "Result offset must be less than 2^31");
+
+            size_t tile_size = m_num_threads * m_num_items;
+
+            // Every level but the last one writes its results after those of the previous level
+            size_t required_count = 0;
+            for (size_t level_count = div_ceil(count, tile_size); level_count > 1;
+                 level_count = div_ceil(level_count, tile_size))
+                required_count += level_count;
+
+            size_t required_size = required_count * get_data_type_size(m_data_type);
+            if (m_scratch_buffer.size() < required_size)
+                m_scratch_buffer.resize(required_size, false);
+
+            m_to_buffer_program.use();
+
+            GLuint src_buffer = input_buffer;
+            size_t src_offset = offset;
+            size_t level_count = count;
+            size_t scratch_offset = 0;
+            while (true)
+            {
+                size_t num_workgroups = div_ceil(level_count, tile_size);
+                bool last_level = num_workgroups == 1;
+
+                GLuint dst_buffer = last_level ? result_buffer : m_scratch_buffer.handle();
+                size_t dst_offset = last_level ? result_offset : scratch_offset;
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src_buffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, dst_buffer);
+
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_count"), level_count);
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_src_offset"), src_offset);
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_dst_offset"), dst_offset);
+
+                // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+                size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+                glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+                if (last_level)
+                    break;
+
+                src_buffer = m_scratch_buffer.handle();
+                src_offset = scratch_offset;
+                level_count = num_workgroups;
+                scratch_offset += num_workgroups;
+            }
+        }
+
+    private:
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_REDUCE_HPP
+
+
+#ifndef GLU_DATA_TYPES_HPP
+#define GLU_DATA_TYPES_HPP
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    enum DataType
+    {
+        DataType_Float = 0,
+        DataType_Double,
+        DataType_Int,
+        DataType_Uint,
+        DataType_Vec2,
+        DataType_Vec4,
+        DataType_DVec2,
+        DataType_DVec4,
+        DataType_UVec2,
+        DataType_UVec4,
+        DataType_IVec2,
+        DataType_IVec4
+    };
+
+    inline const char* to_glsl_type_str(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return "float";
+        else if (data_type == DataType_Double) return "double";
+        else if (data_type == DataType_Int)    return "int";
+        else if (data_type == DataType_Uint)   return "uint";
+        else if (data_type == DataType_Vec2)   return "vec2";
+        else if (data_type == DataType_Vec4)   return "vec4";
+        else if (data_type == DataType_DVec2)  return "dvec2";
+        else if (data_type == DataType_DVec4)  return "dvec4";
+        else if (data_type == DataType_UVec2)  return "uvec2";
+        else if (data_type == DataType_UVec4)  return "uvec4";
+        else if (data_type == DataType_IVec2)  return "ivec2";
+        else if (data_type == DataType_IVec4)  return "ivec4";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+} // namespace glu
+
+#endif // GLU_DATA_TYPES_HPP
+
+
+
+namespace glu
+{
+    namespace detail
+    {
+        /// The exclusive scan of a value per thread of the workgroup: every subgroup scans its values, then the first
+        /// subgroup scans the totals of the subgroups (by chunks of gl_SubgroupSize, if there are more of them).
+        inline const char* k_scan_common_shader_src = R"(
+#extension GL_KHR_shader_subgroup_arithmetic : require
+
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer Buffer
+{
+    DATA_TYPE data[];
+};
+
+layout(std430, binding = 1) buffer BlockSumBuffer
+{
+    DATA_TYPE b_block_sum_buffer[]; // num_partitions * num_blocks
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_num_blocks;
+
+shared DATA_TYPE s_subgroup_buffer[MAX_NUM_SUBGROUPS];
+shared DATA_TYPE s_total;
+
+/// Returns the exclusive scan of the value of this thread, and writes the total of the workgroup to s_total.
+DATA_TYPE workgroup_exclusive_scan(DATA_TYPE value)
+{
+    DATA_TYPE prefix = SUBGROUP_EXCLUSIVE_OPERATION(value);
+    DATA_TYPE subgroup_total = SUBGROUP_OPERATION(value);
+    if (subgroupElect()) s_subgroup_buffer[gl_SubgroupID] = subgroup_total;
+
+    barrier();
+
+    if (gl_SubgroupID == 0)
+    {
+        DATA_TYPE carry = IDENTITY;
+        for (uint base_i = 0; base_i < gl_NumSubgroups; base_i += gl_SubgroupSize)
+        {
+            uint i = base_i + gl_SubgroupInvocationID;
+            DATA_TYPE sum = i < gl_NumSubgroups ? s_subgroup_buffer[i] : IDENTITY;
+            if (i < gl_NumSubgroups) s_subgroup_buffer[i] = OPERATION(carry, SUBGROUP_EXCLUSIVE_OPERATION(sum));
+            carry = OPERATION(carry, SUBGROUP_OPERATION(sum));
+        }
+        if (subgroupElect()) s_total = carry;
+    }
+
+    barrier();
+
+    return OPERATION(s_subgroup_buffer[gl_SubgroupID], prefix);
+}
+)";
+
+        /// Phase 1: every workgroup reduces a tile of NUM_THREADS * NUM_ITEMS elements to its block sum. Items are
+        /// read NUM_THREADS apart, the order doesn't matter here.
+        inline const char* k_scan_reduce_shader_src = R"(
+void main()
+{
+    uint partition_i = gl_WorkGroupID.z;
+    uint block_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (block_i >= u_num_blocks) return; // The 2D dispatch may exceed the blocks (uniform per workgroup)
+
+    uint base_i = partition_i * u_count;
+    uint tile_i = block_i * NUM_THREADS * NUM_ITEMS;
+
+    DATA_TYPE thread_sum = IDENTITY;
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        uint i = tile_i + item_i * NUM_THREADS + gl_LocalInvocationIndex;
+        if (i < u_count) thread_sum = OPERATION(thread_sum, data[base_i + i]);
+    }
+
+    workgroup_exclusive_scan(thread_sum);
+
+    if (gl_LocalInvocationIndex == 0) b_block_sum_buffer[partition_i * u_num_blocks + block_i] = s_total;
+}
+)";
+
+        /// Phase 2: a workgroup per partition scans its block sums, a tile at a time.
+        inline const char* k_scan_block_sums_shader_src = R"(
+void main()
+{
+    uint partition_i = gl_WorkGroupID.z;
+    uint base_i = partition_i * u_num_blocks;
+
+    DATA_TYPE carry = IDENTITY;
+    for (uint tile_i = 0; tile_i < u_num_blocks; tile_i += NUM_THREADS * NUM_ITEMS)
+    {
+        uint i = tile_i + gl_LocalInvocationIndex * NUM_ITEMS;
+
+        DATA_TYPE items[NUM_ITEMS];
+        DATA_TYPE thread_sum = IDENTITY;
+        for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+        {
+            items[item_i] = i + item_i < u_num_blocks ? b_block_sum_buffer[base_i + i + item_i] : IDENTITY;
+            thread_sum = OPERATION(thread_sum, items[item_i]);
+        }
+
+        DATA_TYPE prefix = OPERATION(carry, workgroup_exclusive_scan(thread_sum));
+        for (uint item_i = 0; item_i < NUM_ITEMS && i + item_i < u_num_blocks; item_i++)
+        {
+            b_block_sum_buffer[base_i + i + item_i] = prefix;
+            prefix = OPERATION(prefix, items[item_i]);
+        }
+
+        carry = OPERATION(carry, s_total);
+
+        barrier(); // s_total and s_subgroup_buffer are written again by the next tile
+    }
+}
+)";
+
+        /// Phase 3: every workgroup scans its tile, NUM_ITEMS consecutive elements per thread, starting from the
+        /// scanned sum of the blocks before it. If INCLUSIVE, every element is included in its own prefix.
+        inline const char* k_scan_downsweep_shader_src = R"(
+void main()
+{
+    uint partition_i = gl_WorkGroupID.z;
+    uint block_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (block_i >= u_num_blocks) return;
+
+    uint base_i = partition_i * u_count;
+    uint i = block_i * NUM_THREADS * NUM_ITEMS + gl_LocalInvocationIndex * NUM_ITEMS;
+
+    DATA_TYPE items[NUM_ITEMS];
+    DATA_TYPE thread_sum = IDENTITY;
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        items[item_i] = i + item_i < u_count ? data[base_i + i + item_i] : IDENTITY;
+        thread_sum = OPERATION(thread_sum, items[item_i]);
+    }
+
+    DATA_TYPE block_prefix = b_block_sum_buffer[partition_i * u_num_blocks + block_i];
+    DATA_TYPE prefix = OPERATION(block_prefix, workgroup_exclusive_scan(thread_sum));
+    for (uint item_i = 0; item_i < NUM_ITEMS && i + item_i < u_count; item_i++)
+    {
+#ifdef INCLUSIVE
+        prefix = OPERATION(prefix, items[item_i]);
+        data[base_i + i + item_i] = prefix;
+#else
+        data[base_i + i + item_i] = prefix;
+        prefix = OPERATION(prefix, items[item_i]);
+#endif
+    }
+}
+)";
+
+        /// The definitions of OPERATION, its subgroup operations and its IDENTITY, for the given data type (vector
+        /// types are combined component-wise).
+        inline std::string get_scan_operator_src(DataType data_type, ReduceOperator operator_)
+        {
+            std::string component_type = to_glsl_component_type_str(data_type);
+
+            // The greatest and the lowest component values, the identities of Min and Max
+            std::string greatest, lowest;
+            if (component_type == "float")
+            {
+                greatest = "uintBitsToFloat(0x7f800000u)"; // +inf
+                lowest = "uintBitsToFloat(0xff800000u)";   // -inf
+            }
+            else if (component_type == "double")
+            {
+                greatest = "packDouble2x32(uvec2(0u, 0x7ff00000u))"; // +inf
+                lowest = "packDouble2x32(uvec2(0u, 0xfff00000u))";   // -inf
+            }
+            else if (component_type == "int")
+            {
+                greatest = "0x7fffffff";
+                lowest = "(-0x7fffffff - 1)";
+            }
+            else
+            {
+                greatest = "0xffffffffu";
+                lowest = "0u";
+            }
+
+            std::string src;
+            if (operator_ == ReduceOperator_Sum)
+            {
+                src += "#define OPERATION(a, b) (a + b)\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupAdd(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveAdd(value)\n";
+                src += "#define IDENTITY DATA_TYPE(0)\n";
+            }
+            else if (operator_ == ReduceOperator_Mul)
+            {
+                src += "#define OPERATION(a, b) (a * b)\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupMul(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveMul(value)\n";
+                src += "#define IDENTITY DATA_TYPE(1)\n";
+            }
+            else if (operator_ == ReduceOperator_Min)
+            {
+                src += "#define OPERATION(a, b) (min(a, b))\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupMin(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveMin(value)\n";
+                src += "#define IDENTITY DATA_TYPE(" + greatest + ")\n";
+            }
+            else if (operator_ == ReduceOperator_Max)
+            {
+                src += "#define OPERATION(a, b) (max(a, b))\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupMax(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveMax(value)\n";
+                src += "#define IDENTITY DATA_TYPE(" + lowest + ")\n";
+            }
+            else if (operator_ == ReduceOperator_Or)
+            {
+                GLU_CHECK_ARGUMENT(is_integer_data_type(data_type), "OR requires an integer data type");
+
+                src += "#define OPERATION(a, b) (a | b)\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupOr(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveOr(value)\n";
+                src += "#define IDENTITY DATA_TYPE(0)\n";
+            }
+            else
+            {
+                GLU_FAIL("Invalid scan operator: %d", operator_);
+            }
+            return src;
+        }
+    } // namespace detail
+
+    /// The kinds of scan: whether every element is included in its own prefix.
+    enum ScanType
+    {
+        ScanType_Exclusive = 0,
+        ScanType_Inclusive
+    };
+
+    /// A class that implements a prefix scan (by default an exclusive prefix sum), by reduce-then-scan: every block of
+    /// NUM_THREADS * NUM_ITEMS elements is reduced to its sum, the block sums are scanned by a single workgroup, then
+    /// every block is scanned starting from its scanned sum. That's 3 dispatches whatever the count, reading the
+    /// elements twice and writing them once.
+    ///
+    /// Vector data types are scanned component-wise, e.g. DataType_Vec4 runs 4 prefix sums at once.
+    class BlellochScan
+    {
+    private:
+        const DataType m_data_type;
+        const ReduceOperator m_operator;
+        const ScanType m_scan_type;
+        const size_t m_num_threads;
+        const size_t m_num_items;
+
+        Program m_reduce_program;
+        Program m_block_sums_program;
+        Program m_downsweep_program;
+
+        /// The sum of every block, then its exclusive prefix (for every partition).
+        ShaderStorageBuffer m_block_sum_buffer;
+
+    public:
+        /// @param data_type the type of the elements
+        /// @param operator_ the operator of the scan (ReduceOperator_Or only for integer data types)
+        /// @param scan_type whether the scan is exclusive (the first element is the identity) or inclusive
+        explicit BlellochScan(
+            DataType data_type,
+            ReduceOperator operator_ = ReduceOperator_Sum,
+            ScanType scan_type = ScanType_Exclusive
+        ) :
+            m_data_type(data_type),
+            m_operator(operator_),
+            m_scan_type(scan_type),
+            m_num_threads(1024),
+            m_num_items(4)
+        {
+            GLint subgroup_size = 0;
+            glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &subgroup_size);
+            GLU_CHECK_STATE(
+                subgroup_size > 0 && m_num_threads % subgroup_size == 0, "Unsupported subgroup size: %d", subgroup_size
+            );
+
+            std::string shader_src = "#version 460\n\n";
+
+            shader_src += std::string("#define DATA_TYPE ") + to_glsl_type_str(m_data_type) + "\n";
+            shader_src += detail::get_scan_operator_src(m_data_type, m_operator);
+            if (m_scan_type == ScanType_Inclusive)
+                shader_src += "#define INCLUSIVE\n";
+            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
+            shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
+            shader_src += "#define MAX_NUM_SUBGROUPS " + std::to_string(m_num_threads / subgroup_size) + "\n";
+            shader_src += detail::k_scan_common_shader_src;
+
+            build_program(m_reduce_program, shader_src + detail::k_scan_reduce_shader_src);
+            build_program(m_block_sums_program, shader_src + detail::k_scan_block_sums_shader_src);
+            build_program(m_downsweep_program, shader_src + detail::k_scan_downsweep_shader_src);
+        }
+
+        ~BlellochScan() = default;
+
+        /// Runs the scan on multiple partitions, in place.
+        ///
+        /// @param buffer the input buffer (of the data type)
+        /// @param count the number of elements in every partition (up to 2^30)
+        /// @param num_partitions the number of partitions (must be adjacent)
+        void operator()(GLuint buffer, size_t count, size_t num_partitions = 1)
+        {
+            GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
+            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
+            GLU_CHECK_ARGUMENT(count <= (size_t(1) << 30), "Count must be at most 2^30");
+            GLU_CHECK_ARGUMENT(num_partitions >= 1, "Num of partitions must be >= 1");
+
+            size_t num_blocks = div_ceil(count, m_num_threads * m_num_items);
+
+            size_t required_size = num_partitions * num_blocks * get_data_type_size(m_data_type);
+            if (m_block_sum_buffer.size() < required_size)
+                m_block_sum_buffer.resize(required_size, false);
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+            m_block_sum_buffer.bind(1);
+
+            // Blocks on two dimensions, as the guaranteed max workgroup count is 65535; partitions on the third one
+            size_t num_blocks_x = std::min<size_t>(num_blocks, 65535);
+            size_t num_blocks_y = div_ceil(num_blocks, num_blocks_x);
+
+            // ---------------------------------------------------------------- Reduce
+
+            m_reduce_program.use();
+
+            glUniform1ui(m_reduce_program.get_uniform_location("u_count"), count);
+            glUniform1ui(m_reduce_program.get_uniform_location("u_num_blocks"), num_blocks);
+
+            glDispatchCompute(num_blocks_x, num_blocks_y, num_partitions);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // ---------------------------------------------------------------- Scan of block sums
+
+            m_block_sums_program.use();
+
+            glUniform1ui(m_block_sums_program.get_uniform_location("u_num_blocks"), num_blocks);
+
+            glDispatchCompute(1, 1, num_partitions);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // ---------------------------------------------------------------- Downsweep
+
+            m_downsweep_program.use();
+
+            glUniform1ui(m_downsweep_program.get_uniform_location("u_count"), count);
+            glUniform1ui(m_downsweep_program.get_uniform_location("u_num_blocks"), num_blocks);
+
+            glDispatchCompute(num_blocks_x, num_blocks_y, num_partitions);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+    private:
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_BLELLOCHSCAN_HPP
+
+
+#ifndef GLU_GL_UTILS_HPP
+#define GLU_GL_UTILS_HPP
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    inline void
+    copy_buffer(GLuint src_buffer, GLuint dst_buffer, size_t size, size_t src_offset = 0, size_t dst_offset = 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, src_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, dst_buffer);
+
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr) src_offset, (GLintptr) dst_offset, (GLsizeiptr) size
+        );
+    }
+
+    /// A RAII wrapper for GL shader.
+    class Shader
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Shader(GLenum type) :
+            m_handle(glCreateShader(type)){};
+        Shader(const Shader&) = delete;
+
+        Shader(Shader&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Shader() { glDeleteShader(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void source_from_str(const std::string& src_str)
+        {
+            const char* src_ptr = src_str.c_str();
+            glShaderSource(m_handle, 1, &src_ptr, nullptr);
+        }
+
+        void source_from_file(const char* src_filepath)
+        {
+            FILE* file = fopen(src_filepath, "rt");
+            GLU_CHECK_STATE(!file, "Failed to shader file: %s", src_filepath);
+
+            fseek(file, 0, SEEK_END);
+            size_t file_size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+
+            std::string src{};
+            src.resize(file_size);
+            fread(src.data(), sizeof(char), file_size, file);
+            source_from_str(src.c_str());
+
+            fclose(file);
+        }
+
+        std::string get_info_log()
+        {
+            GLint log_length = 0;
+            glGetShaderiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetShaderInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void compile()
+        {
+            glCompileShader(m_handle);
+
+            GLint status;
+            glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Shader failed to compile: %s", get_info_log().c_str());
+            }
+        }
+    };
+
+    /// A RAII wrapper for GL program.
+    class Program
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Program() { m_handle = glCreateProgram(); };
+        Program(const Program&) = delete;
+
+        Program(Program&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Program() { glDeleteProgram(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void attach_shader(GLuint shader_handle) { glAttachShader(m_handle, shader_handle); }
+        void attach_shader(const Shader& shader) { glAttachShader(m_handle, shader.handle()); }
+
+        [[nodiscard]] std::string get_info_log() const
+        {
+            GLint log_length = 0;
+            glGetProgramiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetProgramInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void link()
+        {
+            GLint status;
+            glLinkProgram(m_handle);
+            glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Program failed to link: %s", get_info_log().c_str());
+            }
+        }
+
+        void use() { glUseProgram(m_handle); }
+
+        GLint get_uniform_location(const char* uniform_name)
+        {
+            GLint loc = glGetUniformLocation(m_handle, uniform_name);
+            GLU_CHECK_STATE(loc >= 0, "Failed to get uniform location: %s", uniform_name);
+            return loc;
+        }
+    };
+
+    /// A RAII helper class for GL shader storage buffer.
+    class ShaderStorageBuffer
+    {
+    private:
+        GLuint m_handle = 0;
+        size_t m_size = 0;
+
+    public:
+        explicit ShaderStorageBuffer(size_t initial_size = 0)
+        {
+            if (initial_size > 0)
+                resize(initial_size, false);
+        }
+
+        explicit ShaderStorageBuffer(const void* data, size_t size) :
+            m_size(size)
+        {
+            GLU_CHECK_ARGUMENT(data, "");
+            GLU_CHECK_ARGUMENT(size > 0, "");
+
+            glCreateBuffers(1, &m_handle);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, data, GL_DYNAMIC_STORAGE_BIT);
+        }
+
+        template<typename T>
+        explicit ShaderStorageBuffer(const std::vector<T>& data) :
+            ShaderStorageBuffer(data.data(), data.size() * sizeof(T))
+        {
+        }
+
+        ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+        ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            m_size = other.m_size;
+            other.m_handle = 0;
+        }
+
+        ~ShaderStorageBuffer()
+        {
+            if (m_handle)
+                glDeleteBuffers(1, &m_handle);
+        }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        /// Grows or shrinks the buffer. If keep_data, performs an additional copy to maintain the data.
+        void resize(size_t size, bool keep_data = false)
+        {
+            size_t old_size = m_size;
+            GLuint old_handle = m_handle;
+
+            if (old_size != size)
+            {
+                m_size = size;
+
+                glCreateBuffers(1, &m_handle);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+                glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+                if (keep_data)
+                    copy_buffer(old_handle, m_handle, std::min(old_size, size));
+
+                glDeleteBuffers(1, &old_handle);
+            }
+        }
+
+        /// Clears the entire buffer with the given GLuint value (repeated).
+        void clear(GLuint value)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED, GL_UNSIGNED_INT, &value);
+        }
+
+        void write_data(const void* data, size_t size)
+        {
+            GLU_CHECK_ARGUMENT(size <= m_size, "");
+
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+        }
+
+        template<typename T>
+        std::vector<T> get_data() const
+        {
+            GLU_CHECK_ARGUMENT(m_size % sizeof(T) == 0, "Size %zu isn't a multiple of %zu", m_size, sizeof(T));
+
+            std::vector<T> result(m_size / sizeof(T));
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) m_size, result.data());
+            return result;
+        }
+
+        void bind(GLuint index, size_t size = 0, size_t offset = 0)
+        {
+            if (size == 0)
+                size = m_size;
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, m_handle, (GLintptr) offset, (GLsizeiptr) size);
+        }
+    };
+
+    /// Measures elapsed time on GPU for executing the given callback.
+    inline uint64_t measure_gl_elapsed_time(const std::function<void()>& callback)
+    {
+        GLuint query;
+        uint64_t elapsed_time{};
+
+        glGenQueries(1, &query);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        callback();
+
+        glEndQuery(GL_TIME_ELAPSED);
+
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
+        glDeleteQueries(1, &query);
+
+        return elapsed_time;
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_floor(IntegerT n)
+    {
+        return (IntegerT) floor(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_ceil(IntegerT n)
+    {
+        return (IntegerT) ceil(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT div_ceil(IntegerT n, IntegerT d)
+    {
+        return (IntegerT) ceil(double(n) / double(d));
+    }
+
+    template<typename T>
+    bool is_power_of_2(T n)
+    {
+        return (n & (n - 1)) == 0;
+    }
+
+    template<typename IntegerT>
+    IntegerT next_power_of_2(IntegerT n)
+    {
+        n--;
+        n |= n >> 1;
+        n |= n >> 2;
+        n |= n >> 4;
+        n |= n >> 8;
+        n |= n >> 16;
+        n++;
+        return n;
+    }
+
+    template<typename Iterator>
+    void print_stl_container(Iterator begin, Iterator end)
+    {
+        size_t i = 0;
+        for (; begin != end; begin++)
+        {
+            printf("(%zu) %s, ", i, std::to_string(*begin).c_str());
+            i++;
+        }
+        printf("\n");
+    }
+
+    template<typename T>
+    void print_buffer(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<T> data = buffer.get_data<T>();
+        print_stl_container(data.begin(), data.end());
+    }
+
+    inline void print_buffer_hex(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<GLuint> data = buffer.get_data<GLuint>();
+        for (size_t i = 0; i < data.size(); i++)
+            printf("(%zu) %08x, ", i, data[i]);
+        printf("\n");
+    }
+} // namespace glu
+
+#endif // GLU_GL_UTILS_HPP
+
+
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Keys are grouped by bucket within every subgroup (a ballot per bucket bit), so that a single atomic is
+        /// issued per bucket and subgroup. If the buckets fit the shared memory, they're further aggregated per
+        /// workgroup, and only flushed to global memory once.
+        inline const char* k_counting_sort_common_shader = R"(
+#extension GL_KHR_shader_subgroup_ballot : require
+#extension GL_KHR_shader_subgroup_shuffle : require
+
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_num_buckets;
+layout(location = 2) uniform uint u_num_bucket_bits; // The bits of the last bucket
+
+shared uint s_bucket_buffer[NUM_SHARED_BUCKETS]; // Only used if u_num_buckets <= NUM_SHARED_BUCKETS
+
+/// The bucket of a key: keys past the domain are clamped to the last bucket.
+uint get_bucket(uint key)
+{
+    return min(key, u_num_buckets - 1);
+}
+
+/// The invocations of the subgroup whose key falls in the same bucket (for invocations without key, all of them).
+uvec4 match_bucket(bool has_key, uint bucket)
+{
+    uvec4 has_key_ballot = subgroupBallot(has_key);
+    uvec4 match = has_key ? has_key_ballot : ~has_key_ballot;
+    for (uint bit = 0; bit < u_num_bucket_bits; bit++)
+    {
+        bool is_set = ((bucket >> bit) & 1) != 0;
+        uvec4 ballot = subgroupBallot(is_set);
+        match &= is_set ? ballot : ~ballot;
+    }
+    return match;
+}
+
+void clear_shared_buckets()
+{
+    if (u_num_buckets > NUM_SHARED_BUCKETS) return;
+
+    for (uint bucket = gl_LocalInvocationIndex; bucket < u_num_buckets; bucket += NUM_THREADS)
+    {
+        s_bucket_buffer[bucket] = 0;
+    }
+}
+)";
+
+        inline const char* k_counting_sort_histogram_shader = R"(
+layout(std430, binding = 0) readonly buffer KeyBuffer
+{
+    uint b_key_buffer[];
+};
+
+layout(std430, binding = 1) buffer BucketCountBuffer
+{
+    uint b_bucket_count_buffer[];
+};
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    bool shared_buckets = u_num_buckets <= NUM_SHARED_BUCKETS;
+
+    clear_shared_buckets();
+
+    barrier();
+
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        uint i = (workgroup_i * NUM_ITEMS + item_i) * NUM_THREADS + gl_LocalInvocationIndex;
+        bool has_key = i < u_count;
+        uint bucket = has_key ? get_bucket(b_key_buffer[i]) : 0;
+
+        // The first invocation of every bucket counts the keys of the subgroup
+        uvec4 match = match_bucket(has_key, bucket);
+        if (has_key && gl_SubgroupInvocationID == subgroupBallotFindLSB(match))
+        {
+            uint bucket_count = subgroupBallotBitCount(match);
+            if (shared_buckets) atomicAdd(s_bucket_buffer[bucket], bucket_count);
+            else atomicAdd(b_bucket_count_buffer[bucket], bucket_count);
+        }
+    }
+
+    barrier();
+
+    if (shared_buckets)
+    {
+        for (uint bucket = gl_LocalInvocationIndex; bucket < u_num_buckets; bucket += NUM_THREADS)
+        {
+            uint bucket_count = s_bucket_buffer[bucket];
+            if (bucket_count > 0) atomicAdd(b_bucket_count_buffer[bucket], bucket_count);
+        }
+    }
+}
+)";
+
+        /// Every key takes an index in its bucket: the first invocation of the bucket in the subgroup reserves the
+        /// indices of the subgroup (from the workgroup range, reserved from the bucket cursor afterwards, if the
+        /// buckets fit the shared memory), and the others follow it in the order of the subgroup.
+        inline const char* k_counting_sort_scatter_shader = R"(
+layout(std430, binding = 0) readonly buffer SrcKeyBuffer
+{
+    uint b_src_key_buffer[];
+};
+
+layout(std430, binding = 1) buffer BucketCursorBuffer
+{
+    uint b_bucket_cursor_buffer[]; // The next free index of every bucket, initially its offset
+};
+
+layout(std430, binding = 2) writeonly buffer DstKeyBuffer
+{
+    uint b_dst_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 3) readonly buffer SrcValBuffer
+{
+    uint b_src_val_buffer[];
+};
+
+layout(std430, binding = 4) writeonly buffer DstValBuffer
+{
+    uint b_dst_val_buffer[];
+};
+#endif
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    bool shared_buckets = u_num_buckets <= NUM_SHARED_BUCKETS;
+
+    clear_shared_buckets();
+
+    barrier();
+
+    uint keys[NUM_ITEMS];
+    uint ranks[NUM_ITEMS]; // The index in the bucket, or in the workgroup range of the bucket if shared_buckets
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        uint i = (workgroup_i * NUM_ITEMS + item_i) * NUM_THREADS + gl_LocalInvocationIndex;
+        bool has_key = i < u_count;
+        keys[item_i] = has_key ? b_src_key_buffer[i] : 0;
+        uint bucket = get_bucket(keys[item_i]);
+
+        uvec4 match = match_bucket(has_key, bucket);
+        uint first_invocation_i = subgroupBallotFindLSB(match);
+
+        uint subgroup_base = 0;
+        if (has_key && gl_SubgroupInvocationID == first_invocation_i)
+        {
+            uint bucket_count = subgroupBallotBitCount(match);
+            if (shared_buckets) subgroup_base = atomicAdd(s_bucket_buffer[bucket], bucket_count);
+            else subgroup_base = atomicAdd(b_bucket_cursor_buffer[bucket], bucket_count);
+        }
+
+        ranks[item_i] = subgroupShuffle(subgroup_base, first_invocation_i) + subgroupBallotExclusiveBitCount(match);
+    }
+
+    barrier();
+
+    if (shared_buckets)
+    {
+        // The workgroup range of every bucket
+        for (uint bucket = gl_LocalInvocationIndex; bucket < u_num_buckets; bucket += NUM_THREADS)
+        {
+            uint bucket_count = s_bucket_buffer[bucket];
+            if (bucket_count > 0) s_bucket_buffer[bucket] = atomicAdd(b_bucket_cursor_buffer[bucket], bucket_count);
+        }
+    }
+
+    barrier();
+
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        uint i = (workgroup_i * NUM_ITEMS + item_i) * NUM_THREADS + gl_LocalInvocationIndex;
+        if (i >= u_count) break;
+
+        uint di = ranks[item_i];
+        if (shared_buckets) di += s_bucket_buffer[get_bucket(keys[item_i])];
+
+        b_dst_key_buffer[di] = keys[item_i];
+#ifdef WITH_VALUES
+        b_dst_val_buffer[di] = b_src_val_buffer[i];
+#endif
+    }
+}
+)";
+    } // namespace detail
+
+    /// A class that sorts GLuint keys of a small known domain [0, num_buckets) (e.g. the cells of a grid) by a
+    /// counting sort: a histogram of the buckets, a prefix sum on it and a scatter, i.e. a single pass over the keys
+    /// instead of the steps of RadixSort. The offset of every bucket is output as well.
+    ///
+    /// Keys of the same bucket are moved by atomic cursors, reserved once per subgroup (or per workgroup, up to
+    /// 4096 buckets): their order within the bucket isn't preserved across subgroups (the sort isn't stable).
+    /// RadixSort with a bit range is the stable alternative.
+    class CountingSort
+    {
+    private:
+        const size_t m_num_threads;
+        const size_t m_num_items;
+        const size_t m_num_shared_buckets;
+
+        Program m_histogram_program;
+        Program m_scatter_program;
+        Program m_key_only_scatter_program;
+
+        BlellochScan m_blelloch_scan;
+
+        /// The counts of the buckets, then their offsets, then the next free index of every bucket (while scattering).
+        ShaderStorageBuffer m_bucket_offset_buffer;
+
+        ShaderStorageBuffer m_key_scratch_buffer;
+        ShaderStorageBuffer m_val_scratch_buffer;
+
+    public:
+        CountingSort() :
+            m_num_threads(256),
+            m_num_items(8),
+            m_num_shared_buckets(4096),
+            m_blelloch_scan(DataType_Uint)
+        {
+            GLint subgroup_features = 0;
+            glGetIntegerv(GL_SUBGROUP_SUPPORTED_FEATURES_KHR, &subgroup_features);
+            GLU_CHECK_STATE(subgroup_features & GL_SUBGROUP_FEATURE_BALLOT_BIT_KHR, "Subgroup ballot isn't supported");
+            GLU_CHECK_STATE(
+                subgroup_features & GL_SUBGROUP_FEATURE_SHUFFLE_BIT_KHR, "Subgroup shuffle isn't supported"
+            );
+
+            std::string shader_src = "#version 460\n\n";
+            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
+            shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
+            shader_src += std::string("#define NUM_SHARED_BUCKETS ") + std::to_string(m_num_shared_buckets) + "\n";
+            shader_src += detail::k_counting_sort_common_shader;
+
+            build_program(m_histogram_program, shader_src + detail::k_counting_sort_histogram_shader);
+            build_program(
+                m_scatter_program, shader_src + "#define WITH_VALUES\n" + detail::k_counting_sort_scatter_shader
+            );
+            build_program(m_key_only_scatter_program, shader_src + detail::k_counting_sort_scatter_shader);
+        }
+
+        ~CountingSort() = default;
+
+        /// Sorts the given keys (and values) by bucket, in place.
+        ///
+        /// @param key_buffer the GLuint keys, in [0, num_buckets): greater keys are sorted in the last bucket (keeping
+        ///                   their value)
+        /// @param val_buffer the GLuint values moved along with the keys, or 0 to sort the keys only
+        /// @param count the number of keys (and values)
+        /// @param num_buckets the size of the key domain
+        /// @param bucket_offset_buffer if not 0, a GLuint buffer where num_buckets + 1 offsets are written: the keys
+        ///                             of the i-th bucket span [offsets[i], offsets[i + 1]) once sorted. They can be
+        ///                             given to RadixSort::sort_segments to make the buckets ordered by another key
+        void operator()(
+            GLuint key_buffer, GLuint val_buffer, size_t count, size_t num_buckets, GLuint bucket_offset_buffer = 0
+        )
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+            GLU_CHECK_ARGUMENT(num_buckets > 0, "Num buckets must be greater than zero");
+
+            bool with_values = val_buffer != 0;
+
+            // ---------------------------------------------------------------- Histogram
+
+            size_t num_offsets = num_buckets + 1;
+            if (m_bucket_offset_buffer.size() < num_offsets * sizeof(GLuint))
+                m_bucket_offset_buffer.resize(num_offsets * sizeof(GLuint), false);
+
+            m_bucket_offset_buffer.clear(0);
+
+            size_t num_bucket_bits = 0; // The bits to tell the buckets apart
+            while ((size_t(1) << num_bucket_bits) < num_buckets)
+                num_bucket_bits++;
+
+            size_t num_workgroups = div_ceil(count, m_num_threads * m_num_items);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            size_t num_workgroups_y = div_ceil(num_workgroups, std::max<size_t>(num_workgroups_x, 1));
+
+            if (count > 0)
+            {
+                m_histogram_program.use();
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+                m_bucket_offset_buffer.bind(1);
+
+                set_bucket_uniforms(m_histogram_program, count, num_buckets, num_bucket_bits);
+
+                glDispatchCompute(num_workgroups_x, num_workgroups_y, 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            }
+
+            // ---------------------------------------------------------------- Prefix sum
+
+            m_blelloch_scan(m_bucket_offset_buffer.handle(), num_offsets);
+
+            if (bucket_offset_buffer)
+            {
+                glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+                copy_buffer(m_bucket_offset_buffer.handle(), bucket_offset_buffer, num_offsets * sizeof(GLuint));
+            }
+
+            if (count <= 1)
+                return;
+
+            // ---------------------------------------------------------------- Scatter
+
+            if (m_key_scratch_buffer.size() < count * sizeof(GLuint))
+                m_key_scratch_buffer.resize(count * sizeof(GLuint), false);
+            if (with_values && m_val_scratch_buffer.size() < count * sizeof(GLuint))
+                m_val_scratch_buffer.resize(count * sizeof(GLuint), false);
+
+            Program& scatter_program = with_values ? m_scatter_program : m_key_only_scatter_program;
+            scatter_program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+            m_bucket_offset_buffer.bind(1);
+            m_key_scratch_buffer.bind(2);
+            if (with_values)
+            {
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, val_buffer);
+                m_val_scratch_buffer.bind(4);
+            }
+
+            set_bucket_uniforms(scatter_program, count, num_buckets, num_bucket_bits);
+
+            glDispatchCompute(num_workgroups_x, num_workgroups_y, 1);
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+            copy_buffer(m_key_scratch_buffer.handle(), key_buffer, count * sizeof(GLuint));
+            if (with_values)
+                copy_buffer(m_val_scratch_buffer.handle(), val_buffer, count * sizeof(GLuint));
+        }
+
+    private:
+        static void set_bucket_uniforms(Program& program, size_t count, size_t num_buckets, size_t num_bucket_bits)
+        {
+            glUniform1ui(program.get_uniform_location("u_count"), count);
+            glUniform1ui(program.get_uniform_location("u_num_buckets"), num_buckets);
+            glUniform1ui(program.get_uniform_location("u_num_bucket_bits"), num_bucket_bits);
+        }
+
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_COUNTINGSORT_HPP
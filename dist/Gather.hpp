@@ -0,0 +1,481 @@
+// This code was automatically generated; you're not supposed to edit it!
+
+#ifndef GLU_GATHER_HPP
+#define GLU_GATHER_HPP
+
+#include <algorithm>
+
+#ifndef GLU_GL_UTILS_HPP
+#define GLU_GL_UTILS_HPP
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    inline void
+    copy_buffer(GLuint src_buffer, GLuint dst_buffer, size_t size, size_t src_offset = 0, size_t dst_offset = 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, src_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, dst_buffer);
+
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr) src_offset, (GLintptr) dst_offset, (GLsizeiptr) size
+        );
+    }
+
+    /// A RAII wrapper for GL shader.
+    class Shader
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Shader(GLenum type) :
+            m_handle(glCreateShader(type)){};
+        Shader(const Shader&) = delete;
+
+        Shader(Shader&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Shader() { glDeleteShader(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void source_from_str(const std::string& src_str)
+        {
+            const char* src_ptr = src_str.c_str();
+            glShaderSource(m_handle, 1, &src_ptr, nullptr);
+        }
+
+        void source_from_file(const char* src_filepath)
+        {
+            FILE* file = fopen(src_filepath, "rt");
+            GLU_CHECK_STATE(!file, "Failed to shader file: %s", src_filepath);
+
+            fseek(file, 0, SEEK_END);
+            size_t file_size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+
+            std::string src{};
+            src.resize(file_size);
+            fread(src.data(), sizeof(char), file_size, file);
+            source_from_str(src.c_str());
+
+            fclose(file);
+        }
+
+        std::string get_info_log()
+        {
+            GLint log_length = 0;
+            glGetShaderiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetShaderInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void compile()
+        {
+            glCompileShader(m_handle);
+
+            GLint status;
+            glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Shader failed to compile: %s", get_info_log().c_str());
+            }
+        }
+    };
+
+    /// A RAII wrapper for GL program.
+    class Program
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Program() { m_handle = glCreateProgram(); };
+        Program(const Program&) = delete;
+
+        Program(Program&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Program() { glDeleteProgram(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void attach_shader(GLuint shader_handle) { glAttachShader(m_handle, shader_handle); }
+        void attach_shader(const Shader& shader) { glAttachShader(m_handle, shader.handle()); }
+
+        [[nodiscard]] std::string get_info_log() const
+        {
+            GLint log_length = 0;
+            glGetProgramiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetProgramInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void link()
+        {
+            GLint status;
+            glLinkProgram(m_handle);
+            glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Program failed to link: %s", get_info_log().c_str());
+            }
+        }
+
+        void use() { glUseProgram(m_handle); }
+
+        GLint get_uniform_location(const char* uniform_name)
+        {
+            GLint loc = glGetUniformLocation(m_handle, uniform_name);
+            GLU_CHECK_STATE(loc >= 0, "Failed to get uniform location: %s", uniform_name);
+            return loc;
+        }
+    };
+
+    /// A RAII helper class for GL shader storage buffer.
+    class ShaderStorageBuffer
+    {
+    private:
+        GLuint m_handle = 0;
+        size_t m_size = 0;
+
+    public:
+        explicit ShaderStorageBuffer(size_t initial_size = 0)
+        {
+            if (initial_size > 0)
+                resize(initial_size, false);
+        }
+
+        explicit ShaderStorageBuffer(const void* data, size_t size) :
+            m_size(size)
+        {
+            GLU_CHECK_ARGUMENT(data, "");
+            GLU_CHECK_ARGUMENT(size > 0, "");
+
+            glCreateBuffers(1, &m_handle);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, data, GL_DYNAMIC_STORAGE_BIT);
+        }
+
+        template<typename T>
+        explicit ShaderStorageBuffer(const std::vector<T>& data) :
+            ShaderStorageBuffer(data.data(), data.size() * sizeof(T))
+        {
+        }
+
+        ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+        ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            m_size = other.m_size;
+            other.m_handle = 0;
+        }
+
+        ~ShaderStorageBuffer()
+        {
+            if (m_handle)
+                glDeleteBuffers(1, &m_handle);
+        }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        /// Grows or shrinks the buffer. If keep_data, performs an additional copy to maintain the data.
+        void resize(size_t size, bool keep_data = false)
+        {
+            size_t old_size = m_size;
+            GLuint old_handle = m_handle;
+
+            if (old_size != size)
+            {
+                m_size = size;
+
+                glCreateBuffers(1, &m_handle);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+                glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+                if (keep_data)
+                    copy_buffer(old_handle, m_handle, std::min(old_size, size));
+
+                glDeleteBuffers(1, &old_handle);
+            }
+        }
+
+        /// Clears the entire buffer with the given GLuint value (repeated).
+        void clear(GLuint value)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED, GL_UNSIGNED_INT, &value);
+        }
+
+        void write_data(const void* data, size_t size)
+        {
+            GLU_CHECK_ARGUMENT(size <= m_size, "");
+
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+        }
+
+        template<typename T>
+        std::vector<T> get_data() const
+        {
+            GLU_CHECK_ARGUMENT(m_size % sizeof(T) == 0, "Size %zu isn't a multiple of %zu", m_size, sizeof(T));
+
+            std::vector<T> result(m_size / sizeof(T));
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) m_size, result.data());
+            return result;
+        }
+
+        void bind(GLuint index, size_t size = 0, size_t offset = 0)
+        {
+            if (size == 0)
+                size = m_size;
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, m_handle, (GLintptr) offset, (GLsizeiptr) size);
+        }
+    };
+
+    /// Measures elapsed time on GPU for executing the given callback.
+    inline uint64_t measure_gl_elapsed_time(const std::function<void()>& callback)
+    {
+        GLuint query;
+        uint64_t elapsed_time{};
+
+        glGenQueries(1, &query);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        callback();
+
+        glEndQuery(GL_TIME_ELAPSED);
+
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
+        glDeleteQueries(1, &query);
+
+        return elapsed_time;
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_floor(IntegerT n)
+    {
+        return (IntegerT) floor(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_ceil(IntegerT n)
+    {
+        return (IntegerT) ceil(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT div_ceil(IntegerT n, IntegerT d)
+    {
+        return (IntegerT) ceil(double(n) / double(d));
+    }
+
+    template<typename T>
+    bool is_power_of_2(T n)
+    {
+        return (n & (n - 1)) == 0;
+    }
+
+    template<typename IntegerT>
+    IntegerT next_power_of_2(IntegerT n)
+    {
+        n--;
+        n |= n >> 1;
+        n |= n >> 2;
+        n |= n >> 4;
+        n |= n >> 8;
+        n |= n >> 16;
+        n++;
+        return n;
+    }
+
+    template<typename Iterator>
+    void print_stl_container(Iterator begin, Iterator end)
+    {
+        size_t i = 0;
+        for (; begin != end; begin++)
+        {
+            printf("(%zu) %s, ", i, std::to_string(*begin).c_str());
+            i++;
+        }
+        printf("\n");
+    }
+
+    template<typename T>
+    void print_buffer(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<T> data = buffer.get_data<T>();
+        print_stl_container(data.begin(), data.end());
+    }
+
+    inline void print_buffer_hex(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<GLuint> data = buffer.get_data<GLuint>();
+        for (size_t i = 0; i < data.size(); i++)
+            printf("(%zu) %08x, ", i, data[i]);
+        printf("\n");
+    }
+} // namespace glu
+
+#endif // GLU_GL_UTILS_HPP
+
+
+
+namespace glu
+{
+    namespace detail
+    {
+        inline const char* k_gather_shader_src = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer SrcBuffer
+{
+    CHUNK_TYPE b_src_buffer[];
+};
+
+layout(std430, binding = 1) writeonly buffer DstBuffer
+{
+    CHUNK_TYPE b_dst_buffer[];
+};
+
+layout(std430, binding = 2) readonly buffer IndexBuffer
+{
+    uint b_index_buffer[];
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_num_element_chunks;
+
+void main()
+{
+    // A thread per chunk: consecutive threads move consecutive chunks of an element
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint chunk_i = workgroup_i * NUM_THREADS + gl_LocalInvocationIndex;
+
+    uint i = chunk_i / u_num_element_chunks;
+    if (i < u_count)
+    {
+        uint element_chunk_i = chunk_i % u_num_element_chunks;
+        b_dst_buffer[chunk_i] = b_src_buffer[b_index_buffer[i] * u_num_element_chunks + element_chunk_i];
+    }
+}
+)";
+    }
+
+    /// A class that applies a permutation to a buffer of elements of any size: dst[i] = src[index[i]].
+    /// Elements are moved by 16-byte chunks if their stride allows it, by 4-byte chunks otherwise.
+    class Gather
+    {
+    private:
+        const size_t m_num_threads;
+
+        Program m_uvec4_program;
+        Program m_uint_program;
+
+    public:
+        Gather() :
+            m_num_threads(256)
+        {
+            std::string shader_src = "#version 460\n\n";
+            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
+
+            { // uvec4 program
+                Shader shader(GL_COMPUTE_SHADER);
+                shader.source_from_str(shader_src + "#define CHUNK_TYPE uvec4\n" + detail::k_gather_shader_src);
+                shader.compile();
+
+                m_uvec4_program.attach_shader(shader);
+                m_uvec4_program.link();
+            }
+
+            { // uint program
+                Shader shader(GL_COMPUTE_SHADER);
+                shader.source_from_str(shader_src + "#define CHUNK_TYPE uint\n" + detail::k_gather_shader_src);
+                shader.compile();
+
+                m_uint_program.attach_shader(shader);
+                m_uint_program.link();
+            }
+        }
+
+        ~Gather() = default;
+
+        /// @param src_buffer the elements to read
+        /// @param dst_buffer where the permuted elements are written (can't be src_buffer)
+        /// @param index_buffer a GLuint buffer of count indices into src_buffer (e.g. output by RadixSort::argsort)
+        /// @param count the number of elements to write
+        /// @param stride the size of an element in bytes, must be a multiple of 4
+        void operator()(GLuint src_buffer, GLuint dst_buffer, GLuint index_buffer, size_t count, size_t stride)
+        {
+            GLU_CHECK_ARGUMENT(src_buffer, "Invalid src buffer");
+            GLU_CHECK_ARGUMENT(dst_buffer, "Invalid dst buffer");
+            GLU_CHECK_ARGUMENT(src_buffer != dst_buffer, "Src and dst buffer must be different");
+            GLU_CHECK_ARGUMENT(index_buffer, "Invalid index buffer");
+            GLU_CHECK_ARGUMENT(stride > 0 && stride % 4 == 0, "Stride must be a non-zero multiple of 4: %zu", stride);
+
+            if (count == 0)
+                return;
+
+            size_t chunk_size = stride % 16 == 0 ? 16 : 4;
+            size_t num_element_chunks = stride / chunk_size;
+
+            Program& program = chunk_size == 16 ? m_uvec4_program : m_uint_program;
+            program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, dst_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, index_buffer);
+
+            glUniform1ui(program.get_uniform_location("u_count"), count);
+            glUniform1ui(program.get_uniform_location("u_num_element_chunks"), num_element_chunks);
+
+            // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(count * num_element_chunks, m_num_threads);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+    };
+} // namespace glu
+
+#endif // GLU_GATHER_HPP
@@ -0,0 +1,820 @@
+// This code was automatically generated; you're not supposed to edit it!
+
+#ifndef GLU_MERGE_HPP
+#define GLU_MERGE_HPP
+
+#include <algorithm>
+
+#ifndef GLU_DATA_TYPES_HPP
+#define GLU_DATA_TYPES_HPP
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    enum DataType
+    {
+        DataType_Float = 0,
+        DataType_Double,
+        DataType_Int,
+        DataType_Uint,
+        DataType_Vec2,
+        DataType_Vec4,
+        DataType_DVec2,
+        DataType_DVec4,
+        DataType_UVec2,
+        DataType_UVec4,
+        DataType_IVec2,
+        DataType_IVec4
+    };
+
+    inline const char* to_glsl_type_str(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return "float";
+        else if (data_type == DataType_Double) return "double";
+        else if (data_type == DataType_Int)    return "int";
+        else if (data_type == DataType_Uint)   return "uint";
+        else if (data_type == DataType_Vec2)   return "vec2";
+        else if (data_type == DataType_Vec4)   return "vec4";
+        else if (data_type == DataType_DVec2)  return "dvec2";
+        else if (data_type == DataType_DVec4)  return "dvec4";
+        else if (data_type == DataType_UVec2)  return "uvec2";
+        else if (data_type == DataType_UVec4)  return "uvec4";
+        else if (data_type == DataType_IVec2)  return "ivec2";
+        else if (data_type == DataType_IVec4)  return "ivec4";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+} // namespace glu
+
+#endif // GLU_DATA_TYPES_HPP
+
+
+#ifndef GLU_GL_UTILS_HPP
+#define GLU_GL_UTILS_HPP
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    inline void
+    copy_buffer(GLuint src_buffer, GLuint dst_buffer, size_t size, size_t src_offset = 0, size_t dst_offset = 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, src_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, dst_buffer);
+
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr) src_offset, (GLintptr) dst_offset, (GLsizeiptr) size
+        );
+    }
+
+    /// A RAII wrapper for GL shader.
+    class Shader
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Shader(GLenum type) :
+            m_handle(glCreateShader(type)){};
+        Shader(const Shader&) = delete;
+
+        Shader(Shader&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Shader() { glDeleteShader(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void source_from_str(const std::string& src_str)
+        {
+            const char* src_ptr = src_str.c_str();
+            glShaderSource(m_handle, 1, &src_ptr, nullptr);
+        }
+
+        void source_from_file(const char* src_filepath)
+        {
+            FILE* file = fopen(src_filepath, "rt");
+            GLU_CHECK_STATE(!file, "Failed to shader file: %s", src_filepath);
+
+            fseek(file, 0, SEEK_END);
+            size_t file_size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+
+            std::string src{};
+            src.resize(file_size);
+            fread(src.data(), sizeof(char), file_size, file);
+            source_from_str(src.c_str());
+
+            fclose(file);
+        }
+
+        std::string get_info_log()
+        {
+            GLint log_length = 0;
+            glGetShaderiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetShaderInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void compile()
+        {
+            glCompileShader(m_handle);
+
+            GLint status;
+            glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Shader failed to compile: %s", get_info_log().c_str());
+            }
+        }
+    };
+
+    /// A RAII wrapper for GL program.
+    class Program
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Program() { m_handle = glCreateProgram(); };
+        Program(const Program&) = delete;
+
+        Program(Program&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Program() { glDeleteProgram(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void attach_shader(GLuint shader_handle) { glAttachShader(m_handle, shader_handle); }
+        void attach_shader(const Shader& shader) { glAttachShader(m_handle, shader.handle()); }
+
+        [[nodiscard]] std::string get_info_log() const
+        {
+            GLint log_length = 0;
+            glGetProgramiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetProgramInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void link()
+        {
+            GLint status;
+            glLinkProgram(m_handle);
+            glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Program failed to link: %s", get_info_log().c_str());
+            }
+        }
+
+        void use() { glUseProgram(m_handle); }
+
+        GLint get_uniform_location(const char* uniform_name)
+        {
+            GLint loc = glGetUniformLocation(m_handle, uniform_name);
+            GLU_CHECK_STATE(loc >= 0, "Failed to get uniform location: %s", uniform_name);
+            return loc;
+        }
+    };
+
+    /// A RAII helper class for GL shader storage buffer.
+    class ShaderStorageBuffer
+    {
+    private:
+        GLuint m_handle = 0;
+        size_t m_size = 0;
+
+    public:
+        explicit ShaderStorageBuffer(size_t initial_size = 0)
+        {
+            if (initial_size > 0)
+                resize(initial_size, false);
+        }
+
+        explicit ShaderStorageBuffer(const void* data, size_t size) :
+            m_size(size)
+        {
+            GLU_CHECK_ARGUMENT(data, "");
+            GLU_CHECK_ARGUMENT(size > 0, "");
+
+            glCreateBuffers(1, &m_handle);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, data, GL_DYNAMIC_STORAGE_BIT);
+        }
+
+        template<typename T>
+        explicit ShaderStorageBuffer(const std::vector<T>& data) :
+            ShaderStorageBuffer(data.data(), data.size() * sizeof(T))
+        {
+        }
+
+        ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+        ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            m_size = other.m_size;
+            other.m_handle = 0;
+        }
+
+        ~ShaderStorageBuffer()
+        {
+            if (m_handle)
+                glDeleteBuffers(1, &m_handle);
+        }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        /// Grows or shrinks the buffer. If keep_data, performs an additional copy to maintain the data.
+        void resize(size_t size, bool keep_data = false)
+        {
+            size_t old_size = m_size;
+            GLuint old_handle = m_handle;
+
+            if (old_size != size)
+            {
+                m_size = size;
+
+                glCreateBuffers(1, &m_handle);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+                glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+                if (keep_data)
+                    copy_buffer(old_handle, m_handle, std::min(old_size, size));
+
+                glDeleteBuffers(1, &old_handle);
+            }
+        }
+
+        /// Clears the entire buffer with the given GLuint value (repeated).
+        void clear(GLuint value)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED, GL_UNSIGNED_INT, &value);
+        }
+
+        void write_data(const void* data, size_t size)
+        {
+            GLU_CHECK_ARGUMENT(size <= m_size, "");
+
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+        }
+
+        template<typename T>
+        std::vector<T> get_data() const
+        {
+            GLU_CHECK_ARGUMENT(m_size % sizeof(T) == 0, "Size %zu isn't a multiple of %zu", m_size, sizeof(T));
+
+            std::vector<T> result(m_size / sizeof(T));
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) m_size, result.data());
+            return result;
+        }
+
+        void bind(GLuint index, size_t size = 0, size_t offset = 0)
+        {
+            if (size == 0)
+                size = m_size;
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, m_handle, (GLintptr) offset, (GLsizeiptr) size);
+        }
+    };
+
+    /// Measures elapsed time on GPU for executing the given callback.
+    inline uint64_t measure_gl_elapsed_time(const std::function<void()>& callback)
+    {
+        GLuint query;
+        uint64_t elapsed_time{};
+
+        glGenQueries(1, &query);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        callback();
+
+        glEndQuery(GL_TIME_ELAPSED);
+
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
+        glDeleteQueries(1, &query);
+
+        return elapsed_time;
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_floor(IntegerT n)
+    {
+        return (IntegerT) floor(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_ceil(IntegerT n)
+    {
+        return (IntegerT) ceil(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT div_ceil(IntegerT n, IntegerT d)
+    {
+        return (IntegerT) ceil(double(n) / double(d));
+    }
+
+    template<typename T>
+    bool is_power_of_2(T n)
+    {
+        return (n & (n - 1)) == 0;
+    }
+
+    template<typename IntegerT>
+    IntegerT next_power_of_2(IntegerT n)
+    {
+        n--;
+        n |= n >> 1;
+        n |= n >> 2;
+        n |= n >> 4;
+        n |= n >> 8;
+        n |= n >> 16;
+        n++;
+        return n;
+    }
+
+    template<typename Iterator>
+    void print_stl_container(Iterator begin, Iterator end)
+    {
+        size_t i = 0;
+        for (; begin != end; begin++)
+        {
+            printf("(%zu) %s, ", i, std::to_string(*begin).c_str());
+            i++;
+        }
+        printf("\n");
+    }
+
+    template<typename T>
+    void print_buffer(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<T> data = buffer.get_data<T>();
+        print_stl_container(data.begin(), data.end());
+    }
+
+    inline void print_buffer_hex(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<GLuint> data = buffer.get_data<GLuint>();
+        for (size_t i = 0; i < data.size(); i++)
+            printf("(%zu) %08x, ", i, data[i]);
+        printf("\n");
+    }
+} // namespace glu
+
+#endif // GLU_GL_UTILS_HPP
+
+
+#ifndef GLU_RADIX_SORT_COMMON_HPP
+#define GLU_RADIX_SORT_COMMON_HPP
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Code shared by all the RadixSort shaders. Keys are either uint (32 bits) or uvec2 (64 bits, low bits in x).
+        ///
+        /// Signed and floating-point keys are sorted as unsigned integers after an order-preserving bit transform:
+        /// the sign bit of integers is flipped; the sign bit of positive floats is flipped, and all the bits of
+        /// negative floats. NaNs are cleared of their sign so that they're always placed after +inf.
+        inline const char* k_radix_sort_common_shader = R"(
+#if defined(FLOAT_KEYS) && KEY_NUM_BITS == 64
+const uvec2 k_sign_mask = uvec2(0, 0x80000000u);
+
+bool is_nan(uvec2 key)
+{
+    uint hi = key.y & 0x7fffffffu;
+    return hi > 0x7ff00000u || (hi == 0x7ff00000u && key.x != 0);
+}
+
+uvec2 to_sortable_key(uvec2 key)
+{
+    if (is_nan(key)) key.y &= 0x7fffffffu;
+    return (key.y & 0x80000000u) != 0 ? ~key : key ^ k_sign_mask;
+}
+
+uvec2 from_sortable_key(uvec2 key)
+{
+    return (key.y & 0x80000000u) != 0 ? key ^ k_sign_mask : ~key;
+}
+#elif defined(FLOAT_KEYS)
+uint to_sortable_key(uint key)
+{
+    if ((key & 0x7fffffffu) > 0x7f800000u) key &= 0x7fffffffu; // NaN
+    return (key & 0x80000000u) != 0 ? ~key : key ^ 0x80000000u;
+}
+
+uint from_sortable_key(uint key)
+{
+    return (key & 0x80000000u) != 0 ? key ^ 0x80000000u : ~key;
+}
+#elif defined(SIGNED_KEYS)
+uint to_sortable_key(uint key) { return key ^ 0x80000000u; }
+uint from_sortable_key(uint key) { return key ^ 0x80000000u; }
+#endif
+
+/// Gets the digit of the key starting at the given bit; mask selects the digit bits.
+uint get_radix(KEY_TYPE key, uint shift, uint mask)
+{
+#if KEY_NUM_BITS == 64
+    uint bits = shift < 32 ? (key.x >> shift) : (key.y >> (shift - 32));
+    if (shift > 0 && shift < 32)
+    {
+        bits |= key.y << (32 - shift); // The digit may lie across the two halves (extra bits are masked)
+    }
+    return bits & mask;
+#else
+    return (key >> shift) & mask;
+#endif
+}
+
+/// Gets the digit the key is ranked by: in descending order digits are reversed, so that the largest comes first and
+/// keys with the same digit keep their order (the sort stays stable).
+uint get_key_radix(KEY_TYPE key, uint shift, uint mask)
+{
+#ifdef DESCENDING
+    return mask - get_radix(key, shift, mask);
+#else
+    return get_radix(key, shift, mask);
+#endif
+}
+
+/// Whether key1 is placed strictly before key2 by the sort (keys as stored, not transformed).
+bool precedes(KEY_TYPE key1, KEY_TYPE key2)
+{
+#ifdef TRANSFORM_KEYS
+    key1 = to_sortable_key(key1);
+    key2 = to_sortable_key(key2);
+#endif
+#ifdef DESCENDING
+    KEY_TYPE tmp = key1;
+    key1 = key2;
+    key2 = tmp;
+#endif
+#if KEY_NUM_BITS == 64
+    return key1.y < key2.y || (key1.y == key2.y && key1.x < key2.x);
+#else
+    return key1 < key2;
+#endif
+}
+)";
+    } // namespace detail
+
+    /// The order RadixSort sorts the keys in. Both orders are stable.
+    enum SortOrder
+    {
+        SortOrder_Ascending = 0,
+        SortOrder_Descending
+    };
+} // namespace glu
+
+#endif // GLU_RADIX_SORT_COMMON_HPP
+
+
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Every thread writes NUM_ITEMS consecutive elements of the output. Its first element lies on a diagonal of
+        /// the merge path (the grid of the elements of A by those of B), whose crossing point is found by a binary
+        /// search: how many elements of A and B precede it. The NUM_ITEMS elements are then merged sequentially.
+        inline const char* k_merge_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer AKeyBuffer
+{
+    KEY_TYPE b_a_key_buffer[];
+};
+
+layout(std430, binding = 1) readonly buffer BKeyBuffer
+{
+    KEY_TYPE b_b_key_buffer[];
+};
+
+layout(std430, binding = 2) writeonly buffer DstKeyBuffer
+{
+    KEY_TYPE b_dst_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 3) readonly buffer AValBuffer
+{
+    uint b_a_val_buffer[];
+};
+
+layout(std430, binding = 4) readonly buffer BValBuffer
+{
+    uint b_b_val_buffer[];
+};
+
+layout(std430, binding = 5) writeonly buffer DstValBuffer
+{
+    uint b_dst_val_buffer[];
+};
+#endif
+
+layout(location = 0) uniform uint u_a_count;
+layout(location = 1) uniform uint u_b_count;
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint thread_i = workgroup_i * NUM_THREADS + gl_LocalInvocationIndex;
+
+    uint count = u_a_count + u_b_count;
+    uint diagonal = thread_i * NUM_ITEMS;
+    if (diagonal >= count) return;
+
+    // The number of elements of A preceding the diagonal
+    uint lo = diagonal > u_b_count ? diagonal - u_b_count : 0;
+    uint hi = min(diagonal, u_a_count);
+    while (lo < hi)
+    {
+        uint mid = (lo + hi) / 2;
+        if (precedes(b_b_key_buffer[diagonal - 1 - mid], b_a_key_buffer[mid])) hi = mid;
+        else lo = mid + 1;
+    }
+
+    uint a_i = lo;
+    uint b_i = diagonal - lo;
+
+    uint end_i = min(diagonal + NUM_ITEMS, count);
+    for (uint i = diagonal; i < end_i; i++)
+    {
+        // Keys of A are placed before the equal keys of B (stable merge)
+        bool from_a = b_i >= u_b_count ||
+                      (a_i < u_a_count && !precedes(b_b_key_buffer[b_i], b_a_key_buffer[a_i]));
+        if (from_a)
+        {
+            b_dst_key_buffer[i] = b_a_key_buffer[a_i];
+#ifdef WITH_VALUES
+            b_dst_val_buffer[i] = b_a_val_buffer[a_i];
+#endif
+            a_i++;
+        }
+        else
+        {
+            b_dst_key_buffer[i] = b_b_key_buffer[b_i];
+#ifdef WITH_VALUES
+            b_dst_val_buffer[i] = b_b_val_buffer[b_i];
+#endif
+            b_i++;
+        }
+    }
+}
+)";
+    } // namespace detail
+
+    /// A class that merges two buffers of keys (and values) sorted in the same order into a sorted buffer, with
+    /// merge-path partitioning: every thread finds by a binary search where its part of the output starts in both
+    /// inputs, so that all the threads merge independently. The merge is stable: keys of A are placed before the equal
+    /// keys of B. Keys are compared the way RadixSort orders them.
+    class Merge
+    {
+    private:
+        const size_t m_num_threads;
+
+        /// The number of elements written by every thread.
+        const size_t m_num_items;
+
+        /// The type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or DataType_Double.
+        const DataType m_key_data_type;
+
+        const SortOrder m_order;
+
+        Program m_program;
+        Program m_key_only_program;
+
+    public:
+        /// @param key_data_type the type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or
+        ///                      DataType_Double
+        /// @param order the order both inputs are sorted in
+        explicit Merge(DataType key_data_type = DataType_Uint, SortOrder order = SortOrder_Ascending) :
+            m_num_threads(256),
+            m_num_items(8),
+            m_key_data_type(key_data_type),
+            m_order(order)
+        {
+            GLU_CHECK_ARGUMENT(
+                m_key_data_type == DataType_Uint || m_key_data_type == DataType_Int ||
+                    m_key_data_type == DataType_Float || m_key_data_type == DataType_UVec2 ||
+                    m_key_data_type == DataType_Double,
+                "Invalid key data type: %d",
+                m_key_data_type
+            );
+
+            size_t key_size = get_data_type_size(m_key_data_type);
+
+            std::string shader_src = "#version 460\n\n";
+            shader_src += "#define NUM_THREADS " + std::to_string(m_num_threads) + "\n";
+            shader_src += "#define NUM_ITEMS " + std::to_string(m_num_items) + "\n";
+            shader_src += std::string("#define KEY_TYPE ") + (key_size == 8 ? "uvec2" : "uint") + "\n";
+            shader_src += "#define KEY_NUM_BITS " + std::to_string(key_size * 8) + "\n";
+            if (m_key_data_type == DataType_Int)
+                shader_src += "#define SIGNED_KEYS\n";
+            else if (m_key_data_type == DataType_Float || m_key_data_type == DataType_Double)
+                shader_src += "#define FLOAT_KEYS\n";
+            if (m_key_data_type != DataType_Uint && m_key_data_type != DataType_UVec2)
+                shader_src += "#define TRANSFORM_KEYS\n";
+            if (m_order == SortOrder_Descending)
+                shader_src += "#define DESCENDING\n";
+            shader_src += detail::k_radix_sort_common_shader;
+
+            build_program(m_program, shader_src + "#define WITH_VALUES\n" + detail::k_merge_shader);
+            build_program(m_key_only_program, shader_src + detail::k_merge_shader);
+        }
+
+        ~Merge() = default;
+
+        [[nodiscard]] DataType key_data_type() const { return m_key_data_type; }
+        [[nodiscard]] SortOrder order() const { return m_order; }
+
+        /// Merges A and B into dst, which can't be either of them.
+        ///
+        /// @param a_key_buffer the sorted keys of A
+        /// @param a_val_buffer the GLuint values of A, or 0 to merge the keys only
+        /// @param a_count the number of keys of A
+        /// @param b_key_buffer the sorted keys of B
+        /// @param b_val_buffer the GLuint values of B, or 0 to merge the keys only
+        /// @param b_count the number of keys of B
+        /// @param dst_key_buffer where the a_count + b_count merged keys are written
+        /// @param dst_val_buffer where the merged values are written, or 0 to merge the keys only
+        void operator()(
+            GLuint a_key_buffer,
+            GLuint a_val_buffer,
+            size_t a_count,
+            GLuint b_key_buffer,
+            GLuint b_val_buffer,
+            size_t b_count,
+            GLuint dst_key_buffer,
+            GLuint dst_val_buffer
+        )
+        {
+            GLU_CHECK_ARGUMENT(a_key_buffer, "Invalid A key buffer");
+            GLU_CHECK_ARGUMENT(b_key_buffer, "Invalid B key buffer");
+            GLU_CHECK_ARGUMENT(dst_key_buffer, "Invalid dst key buffer");
+            GLU_CHECK_ARGUMENT(
+                dst_key_buffer != a_key_buffer && dst_key_buffer != b_key_buffer,
+                "Dst key buffer must differ from the inputs"
+            );
+
+            bool with_values = dst_val_buffer != 0;
+            GLU_CHECK_ARGUMENT(
+                with_values == (a_val_buffer != 0) && with_values == (b_val_buffer != 0),
+                "Either all the value buffers or none must be given"
+            );
+
+            size_t count = a_count + b_count;
+            if (count == 0)
+                return;
+
+            Program& program = with_values ? m_program : m_key_only_program;
+            program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, a_key_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, b_key_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, dst_key_buffer);
+            if (with_values)
+            {
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, a_val_buffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, b_val_buffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, dst_val_buffer);
+            }
+
+            glUniform1ui(program.get_uniform_location("u_a_count"), a_count);
+            glUniform1ui(program.get_uniform_location("u_b_count"), b_count);
+
+            // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(div_ceil(count, m_num_items), m_num_threads);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+    private:
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_MERGE_HPP
@@ -3,13 +3,14 @@
 #ifndef GLU_RADIXSORT_HPP
 #define GLU_RADIXSORT_HPP
 
-#ifndef GLU_BLELLOCHSCAN_HPP
-#define GLU_BLELLOCHSCAN_HPP
-
+#include <algorithm>
+#include <memory>
 #include <string>
 
-#ifndef GLU_REDUCE_HPP
-#define GLU_REDUCE_HPP
+#ifndef GLU_BITONICSORT_HPP
+#define GLU_BITONICSORT_HPP
+
+#include <algorithm>
 
 #ifndef GLU_DATA_TYPES_HPP
 #define GLU_DATA_TYPES_HPP
@@ -77,6 +78,52 @@ namespace glu
         // clang-format on
     }
 
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
 } // namespace glu
 
 #endif // GLU_DATA_TYPES_HPP
@@ -437,141 +484,417 @@ namespace glu
 #endif // GLU_GL_UTILS_HPP
 
 
+#ifndef GLU_RADIX_SORT_COMMON_HPP
+#define GLU_RADIX_SORT_COMMON_HPP
 
 namespace glu
 {
     namespace detail
     {
-        inline const char* k_reduction_shader_src = R"(
-#extension GL_KHR_shader_subgroup_arithmetic : require
+        /// Code shared by all the RadixSort shaders. Keys are either uint (32 bits) or uvec2 (64 bits, low bits in x).
+        ///
+        /// Signed and floating-point keys are sorted as unsigned integers after an order-preserving bit transform:
+        /// the sign bit of integers is flipped; the sign bit of positive floats is flipped, and all the bits of
+        /// negative floats. NaNs are cleared of their sign so that they're always placed after +inf.
+        inline const char* k_radix_sort_common_shader = R"(
+#if defined(FLOAT_KEYS) && KEY_NUM_BITS == 64
+const uvec2 k_sign_mask = uvec2(0, 0x80000000u);
+
+bool is_nan(uvec2 key)
+{
+    uint hi = key.y & 0x7fffffffu;
+    return hi > 0x7ff00000u || (hi == 0x7ff00000u && key.x != 0);
+}
+
+uvec2 to_sortable_key(uvec2 key)
+{
+    if (is_nan(key)) key.y &= 0x7fffffffu;
+    return (key.y & 0x80000000u) != 0 ? ~key : key ^ k_sign_mask;
+}
+
+uvec2 from_sortable_key(uvec2 key)
+{
+    return (key.y & 0x80000000u) != 0 ? key ^ k_sign_mask : ~key;
+}
+#elif defined(FLOAT_KEYS)
+uint to_sortable_key(uint key)
+{
+    if ((key & 0x7fffffffu) > 0x7f800000u) key &= 0x7fffffffu; // NaN
+    return (key & 0x80000000u) != 0 ? ~key : key ^ 0x80000000u;
+}
+
+uint from_sortable_key(uint key)
+{
+    return (key & 0x80000000u) != 0 ? key ^ 0x80000000u : ~key;
+}
+#elif defined(SIGNED_KEYS)
+uint to_sortable_key(uint key) { return key ^ 0x80000000u; }
+uint from_sortable_key(uint key) { return key ^ 0x80000000u; }
+#endif
+
+/// Gets the digit of the key starting at the given bit; mask selects the digit bits.
+uint get_radix(KEY_TYPE key, uint shift, uint mask)
+{
+#if KEY_NUM_BITS == 64
+    uint bits = shift < 32 ? (key.x >> shift) : (key.y >> (shift - 32));
+    if (shift > 0 && shift < 32)
+    {
+        bits |= key.y << (32 - shift); // The digit may lie across the two halves (extra bits are masked)
+    }
+    return bits & mask;
+#else
+    return (key >> shift) & mask;
+#endif
+}
+
+/// Gets the digit the key is ranked by: in descending order digits are reversed, so that the largest comes first and
+/// keys with the same digit keep their order (the sort stays stable).
+uint get_key_radix(KEY_TYPE key, uint shift, uint mask)
+{
+#ifdef DESCENDING
+    return mask - get_radix(key, shift, mask);
+#else
+    return get_radix(key, shift, mask);
+#endif
+}
+
+/// Whether key1 is placed strictly before key2 by the sort (keys as stored, not transformed).
+bool precedes(KEY_TYPE key1, KEY_TYPE key2)
+{
+#ifdef TRANSFORM_KEYS
+    key1 = to_sortable_key(key1);
+    key2 = to_sortable_key(key2);
+#endif
+#ifdef DESCENDING
+    KEY_TYPE tmp = key1;
+    key1 = key2;
+    key2 = tmp;
+#endif
+#if KEY_NUM_BITS == 64
+    return key1.y < key2.y || (key1.y == key2.y && key1.x < key2.x);
+#else
+    return key1 < key2;
+#endif
+}
+)";
+    } // namespace detail
+
+    /// The order RadixSort sorts the keys in. Both orders are stable.
+    enum SortOrder
+    {
+        SortOrder_Ascending = 0,
+        SortOrder_Descending
+    };
+} // namespace glu
+
+#endif // GLU_RADIX_SORT_COMMON_HPP
 
+
+
+namespace glu
+{
+    namespace detail
+    {
+        /// The compare-and-swap of the bitonic network: every stage pairs the elements of index i and i ^ j (or, on
+        /// the first stage of a merge of size k, i and i ^ (k - 1), which flips the second half so that all the pairs
+        /// are ordered the same way). Keys past the count behave as the greatest ones: their pairs are skipped, so the
+        /// network sorts any count as if it was padded to a power of 2.
+        inline const char* k_bitonic_sort_common_shader = R"(
+/// The indices of the p-th pair of a stage, the first one being less than the second one.
+uvec2 get_pair(uint p, uint k, uint j)
+{
+    uint i = (p / j) * 2 * j + p % j;
+    return uvec2(i, j == k / 2 ? i ^ (k - 1) : i + j);
+}
+)";
+
+        /// Sorts every block of BLOCK_SIZE keys (and values) on shared memory if u_k is zero. Otherwise, runs the
+        /// stages of the merge of size u_k whose pairs lie within a block (j < BLOCK_SIZE).
+        inline const char* k_bitonic_sort_local_shader = R"(
 layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
 
-layout(std430, binding = 0) buffer Buffer
+layout(std430, binding = 0) buffer KeyBuffer
 {
-    DATA_TYPE data[];
+    KEY_TYPE b_key_buffer[];
 };
 
+#ifdef WITH_VALUES
+layout(std430, binding = 1) buffer ValBuffer
+{
+    uint b_val_buffer[];
+};
+#endif
+
 layout(location = 0) uniform uint u_count;
-layout(location = 1) uniform uint u_depth;
+layout(location = 1) uniform uint u_k;
+
+shared KEY_TYPE s_key_buffer[BLOCK_SIZE];
+#ifdef WITH_VALUES
+shared uint s_val_buffer[BLOCK_SIZE];
+#endif
+
+void compare_and_swap(uint base_i, uint k, uint j)
+{
+    uvec2 pair = get_pair(gl_LocalInvocationIndex, k, j);
+    if (base_i + pair.y < u_count && precedes(s_key_buffer[pair.y], s_key_buffer[pair.x]))
+    {
+        KEY_TYPE key = s_key_buffer[pair.x];
+        s_key_buffer[pair.x] = s_key_buffer[pair.y];
+        s_key_buffer[pair.y] = key;
+#ifdef WITH_VALUES
+        uint val = s_val_buffer[pair.x];
+        s_val_buffer[pair.x] = s_val_buffer[pair.y];
+        s_val_buffer[pair.y] = val;
+#endif
+    }
+
+    barrier();
+}
 
 void main()
 {
-    uint step = 1 << (5 * u_depth);
-    uint subgroup_i = gl_WorkGroupID.x * NUM_THREADS + gl_SubgroupID * gl_SubgroupSize;
-    uint i = (subgroup_i + gl_SubgroupInvocationID) * step;
-    if (i < u_count)
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint base_i = workgroup_i * BLOCK_SIZE;
+    if (base_i >= u_count) return;
+
+    for (uint i = gl_LocalInvocationIndex; i < BLOCK_SIZE && base_i + i < u_count; i += NUM_THREADS)
     {
-        DATA_TYPE r = SUBGROUP_OPERATION(data[i]);
-        if (gl_SubgroupInvocationID == 0)
+        s_key_buffer[i] = b_key_buffer[base_i + i];
+#ifdef WITH_VALUES
+        s_val_buffer[i] = b_val_buffer[base_i + i];
+#endif
+    }
+
+    barrier();
+
+    if (u_k == 0)
+    {
+        for (uint k = 2; k <= BLOCK_SIZE; k *= 2)
         {
-            data[i] = r;
+            for (uint j = k / 2; j > 0; j /= 2) compare_and_swap(base_i, k, j);
         }
     }
+    else
+    {
+        for (uint j = BLOCK_SIZE / 2; j > 0; j /= 2) compare_and_swap(base_i, u_k, j);
+    }
+
+    for (uint i = gl_LocalInvocationIndex; i < BLOCK_SIZE && base_i + i < u_count; i += NUM_THREADS)
+    {
+        b_key_buffer[base_i + i] = s_key_buffer[i];
+#ifdef WITH_VALUES
+        b_val_buffer[base_i + i] = s_val_buffer[i];
+#endif
+    }
 }
 )";
-    }
 
-    /// The operators that can be used for the reduction operation.
-    enum ReduceOperator
+        /// Runs a stage of the merge of size u_k whose pairs span more than a block (u_j >= BLOCK_SIZE): a thread per
+        /// pair.
+        inline const char* k_bitonic_sort_global_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 1) buffer ValBuffer
+{
+    uint b_val_buffer[];
+};
+#endif
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_k;
+layout(location = 2) uniform uint u_j;
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uvec2 pair = get_pair(workgroup_i * NUM_THREADS + gl_LocalInvocationIndex, u_k, u_j);
+    if (pair.y >= u_count) return;
+
+    KEY_TYPE key1 = b_key_buffer[pair.x];
+    KEY_TYPE key2 = b_key_buffer[pair.y];
+    if (precedes(key2, key1))
     {
-        ReduceOperator_Sum = 0,
-        ReduceOperator_Mul,
-        ReduceOperator_Min,
-        ReduceOperator_Max
-    };
+        b_key_buffer[pair.x] = key2;
+        b_key_buffer[pair.y] = key1;
+#ifdef WITH_VALUES
+        uint val = b_val_buffer[pair.x];
+        b_val_buffer[pair.x] = b_val_buffer[pair.y];
+        b_val_buffer[pair.y] = val;
+#endif
+    }
+}
+)";
+    } // namespace detail
 
-    /// A class that implements the reduction operation.
-    class Reduce
+    /// A class that sorts keys (and values) in place by a bitonic sorting network: no scratch buffer is needed,
+    /// contrary to RadixSort. Blocks are sorted on shared memory first; then, every merge runs its stages spanning
+    /// more than a block as global dispatches, and its last stages on shared memory. It takes O(n log^2 n) compares,
+    /// so it's slower than RadixSort on large counts: it's meant for when memory is short.
+    ///
+    /// The sort isn't stable: the order of equal keys isn't preserved. Keys are compared the way RadixSort orders
+    /// them.
+    class BitonicSort
     {
     private:
-        const DataType m_data_type;
-        const ReduceOperator m_operator;
         const size_t m_num_threads;
-        const size_t m_num_items;
 
-        Program m_program;
+        /// The number of keys sorted on shared memory by a workgroup: a pair per thread.
+        const size_t m_block_size;
 
-    public:
-        explicit Reduce(DataType data_type, ReduceOperator operator_) :
-            m_data_type(data_type),
-            m_operator(operator_),
-            m_num_threads(1024),
-            m_num_items(4)
-        {
-            std::string shader_src = "#version 460\n\n";
+        /// The type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or DataType_Double.
+        const DataType m_key_data_type;
 
-            shader_src += std::string("#define DATA_TYPE ") + to_glsl_type_str(m_data_type) + "\n";
-            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
-            shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
+        const SortOrder m_order;
 
-            if (m_operator == ReduceOperator_Sum)
-            {
-                shader_src += "#define OPERATOR(a, b) (a + b)\n";
-                shader_src += "#define SUBGROUP_OPERATION(value) subgroupAdd(value)\n";
-            }
-            else if (m_operator == ReduceOperator_Mul)
-            {
-                shader_src += "#define OPERATOR(a, b) (a * b)\n";
-                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMul(value)\n";
-            }
-            else if (m_operator == ReduceOperator_Min)
-            {
-                shader_src += "#define OPERATOR(a, b) (min(a, b))\n";
-                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMin(value)\n";
-            }
-            else if (m_operator == ReduceOperator_Max)
-            {
-                shader_src += "#define OPERATOR(a, b) (max(a, b))\n";
-                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMax(value)\n";
-            }
-            else
-            {
-                GLU_FAIL("Invalid reduction operator: %d", m_operator);
-            }
+        Program m_local_program;
+        Program m_key_only_local_program;
+        Program m_global_program;
+        Program m_key_only_global_program;
 
-            shader_src += detail::k_reduction_shader_src;
+    public:
+        /// @param key_data_type the type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or
+        ///                      DataType_Double
+        /// @param order the order keys are sorted in
+        explicit BitonicSort(DataType key_data_type = DataType_Uint, SortOrder order = SortOrder_Ascending) :
+            m_num_threads(512),
+            m_block_size(2 * m_num_threads),
+            m_key_data_type(key_data_type),
+            m_order(order)
+        {
+            GLU_CHECK_ARGUMENT(
+                m_key_data_type == DataType_Uint || m_key_data_type == DataType_Int ||
+                    m_key_data_type == DataType_Float || m_key_data_type == DataType_UVec2 ||
+                    m_key_data_type == DataType_Double,
+                "Invalid key data type: %d",
+                m_key_data_type
+            );
 
-            Shader shader(GL_COMPUTE_SHADER);
-            shader.source_from_str(shader_src.c_str());
-            shader.compile();
+            size_t key_size = get_data_type_size(m_key_data_type);
 
-            m_program.attach_shader(shader);
-            m_program.link();
+            std::string shader_src = "#version 460\n\n";
+            shader_src += "#define NUM_THREADS " + std::to_string(m_num_threads) + "\n";
+            shader_src += "#define BLOCK_SIZE " + std::to_string(m_block_size) + "\n";
+            shader_src += std::string("#define KEY_TYPE ") + (key_size == 8 ? "uvec2" : "uint") + "\n";
+            shader_src += "#define KEY_NUM_BITS " + std::to_string(key_size * 8) + "\n";
+            if (m_key_data_type == DataType_Int)
+                shader_src += "#define SIGNED_KEYS\n";
+            else if (m_key_data_type == DataType_Float || m_key_data_type == DataType_Double)
+                shader_src += "#define FLOAT_KEYS\n";
+            if (m_key_data_type != DataType_Uint && m_key_data_type != DataType_UVec2)
+                shader_src += "#define TRANSFORM_KEYS\n";
+            if (m_order == SortOrder_Descending)
+                shader_src += "#define DESCENDING\n";
+            shader_src += detail::k_radix_sort_common_shader;
+            shader_src += detail::k_bitonic_sort_common_shader;
+
+            build_program(m_local_program, shader_src + "#define WITH_VALUES\n" + detail::k_bitonic_sort_local_shader);
+            build_program(m_key_only_local_program, shader_src + detail::k_bitonic_sort_local_shader);
+            build_program(
+                m_global_program, shader_src + "#define WITH_VALUES\n" + detail::k_bitonic_sort_global_shader
+            );
+            build_program(m_key_only_global_program, shader_src + detail::k_bitonic_sort_global_shader);
         }
 
-        ~Reduce() = default;
+        ~BitonicSort() = default;
 
-        void operator()(GLuint buffer, size_t count)
+        [[nodiscard]] DataType key_data_type() const { return m_key_data_type; }
+        [[nodiscard]] SortOrder order() const { return m_order; }
+
+        /// Sorts the given keys (and values) in place.
+        ///
+        /// @param key_buffer the keys (of the key data type)
+        /// @param val_buffer the GLuint values moved along with the keys, or 0 to sort the keys only
+        /// @param count the number of keys (and values)
+        void operator()(GLuint key_buffer, GLuint val_buffer, size_t count)
         {
-            GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
-            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
 
-            m_program.use();
+            if (count <= 1)
+                return;
 
-            glUniform1ui(m_program.get_uniform_location("u_count"), count);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+            bool with_values = val_buffer != 0;
 
-            for (int depth = 0;; depth++)
-            {
-                int step = 1 << (5 * depth);
-                if (step >= count)
-                    break;
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+            if (with_values)
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, val_buffer);
 
-                size_t level_count = count >> (5 * depth);
+            // The network of the next power of 2, whose keys past the count are skipped
+            size_t count_power_of_2 = next_power_of_2(count);
 
-                glUniform1ui(m_program.get_uniform_location("u_depth"), depth);
+            run_local(with_values, count, 0);
 
-                size_t num_workgroups = div_ceil(level_count, m_num_threads);
-                glDispatchCompute(num_workgroups, 1, 1);
-                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            for (size_t k = 2 * m_block_size; k <= count_power_of_2; k *= 2)
+            {
+                for (size_t j = k / 2; j >= m_block_size; j /= 2)
+                    run_global(with_values, count, k, j);
+
+                run_local(with_values, count, k);
             }
         }
+
+    private:
+        void run_local(bool with_values, size_t count, size_t k)
+        {
+            Program& program = with_values ? m_local_program : m_key_only_local_program;
+            program.use();
+
+            glUniform1ui(program.get_uniform_location("u_count"), count);
+            glUniform1ui(program.get_uniform_location("u_k"), k);
+
+            // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(count, m_block_size);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        void run_global(bool with_values, size_t count, size_t k, size_t j)
+        {
+            Program& program = with_values ? m_global_program : m_key_only_global_program;
+            program.use();
+
+            glUniform1ui(program.get_uniform_location("u_count"), count);
+            glUniform1ui(program.get_uniform_location("u_k"), k);
+            glUniform1ui(program.get_uniform_location("u_j"), j);
+
+            // A thread per pair of the network, on two dimensions as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(next_power_of_2(count) / 2, m_num_threads);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
     };
 } // namespace glu
 
-#endif // GLU_REDUCE_HPP
+#endif // GLU_BITONICSORT_HPP
+
 
+#ifndef GLU_BLELLOCHSCAN_HPP
+#define GLU_BLELLOCHSCAN_HPP
+
+#include <algorithm>
+#include <string>
+
+#ifndef GLU_REDUCE_HPP
+#define GLU_REDUCE_HPP
+
+#include <algorithm>
 
 #ifndef GLU_DATA_TYPES_HPP
 #define GLU_DATA_TYPES_HPP
@@ -639,202 +962,59 @@ namespace glu
         // clang-format on
     }
 
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
 } // namespace glu
 
 #endif // GLU_DATA_TYPES_HPP
 
 
-
-namespace glu
-{
-    namespace detail
-    {
-        inline const char* k_upsweep_shader_src = R"(
-#extension GL_KHR_shader_subgroup_shuffle_relative : require
-
-layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
-
-layout(std430, binding = 0) buffer Buffer
-{
-    DATA_TYPE data[];
-};
-
-layout(location = 0) uniform uint u_count;
-layout(location = 1) uniform uint u_step;
-
-void main()
-{
-    uint partition_i = gl_WorkGroupID.y;
-    uint thread_i = gl_WorkGroupID.x * NUM_THREADS + gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
-    uint i = partition_i * u_count + thread_i * u_step + u_step - 1;
-    uint end_i = (partition_i + 1) * u_count;
-    if (i < end_i)
-    {
-        DATA_TYPE lval = subgroupShuffleUp(data[i], 1);
-        DATA_TYPE r = OPERATION(data[i], lval);
-        if (i == end_i - 1)  // Clear last
-        {
-            data[i] = IDENTITY;
-        }
-        else if (gl_SubgroupInvocationID % 2 == 1)
-        {
-            data[i] = r;
-        }
-    }
-}
-)";
-
-        inline const char* k_downsweep_shader_src = R"(
-layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
-
-layout(std430, binding = 0) buffer Buffer
-{
-    DATA_TYPE data[];
-};
-
-layout(location = 0) uniform uint u_count;
-layout(location = 1) uniform uint u_step;
-
-void main()
-{
-    uint partition_i = gl_WorkGroupID.y;
-    uint i = partition_i * u_count + gl_GlobalInvocationID.x * (u_step << 1) + (u_step - 1);
-    uint next_i = i + u_step;
-    uint end_i = (partition_i + 1) * u_count;
-    if (next_i < end_i)
-    {
-        DATA_TYPE tmp = data[i];
-        data[i] = data[next_i];
-        data[next_i] = data[next_i] + tmp;
-    }
-    else if (i < end_i)
-    {
-        data[i] = IDENTITY;
-    }
-}
-)";
-    } // namespace detail
-
-    /// A class that implements Blelloch scan algorithm (exclusive prefix sum).
-    class BlellochScan
-    {
-    private:
-        const DataType m_data_type;
-        const size_t m_num_threads;
-        const size_t m_num_items;
-
-        Program m_upsweep_program;
-        Program m_downsweep_program;
-
-    public:
-        explicit BlellochScan(DataType data_type) :
-            m_data_type(data_type),
-            m_num_threads(1024),
-            m_num_items(4)
-        {
-            std::string shader_src = "#version 460\n\n";
-
-            shader_src += std::string("#define DATA_TYPE ") + to_glsl_type_str(m_data_type) + "\n";
-            shader_src += "#define OPERATION(a, b) (a + b)\n";
-            shader_src += "#define IDENTITY 0\n";
-            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
-            shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
-
-            { // Upsweep program
-                Shader upsweep_shader(GL_COMPUTE_SHADER);
-                upsweep_shader.source_from_str((shader_src + detail::k_upsweep_shader_src).c_str());
-                upsweep_shader.compile();
-
-                m_upsweep_program.attach_shader(upsweep_shader);
-                m_upsweep_program.link();
-            }
-
-            { // Downsweep program
-                Shader downsweep_program(GL_COMPUTE_SHADER);
-                downsweep_program.source_from_str((shader_src + detail::k_downsweep_shader_src).c_str());
-                downsweep_program.compile();
-
-                m_downsweep_program.attach_shader(downsweep_program);
-                m_downsweep_program.link();
-            }
-        }
-
-        ~BlellochScan() = default;
-
-        /// Runs Blelloch exclusive scan on multiple partitions.
-        ///
-        /// @param buffer the input GLuint buffer
-        /// @param count the number of GLuint in the buffer (must be a power of 2)
-        /// @param num_partitions the number of partitions (must be adjacent)
-        void operator()(GLuint buffer, size_t count, size_t num_partitions = 1)
-        {
-            GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
-            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
-            GLU_CHECK_ARGUMENT(is_power_of_2(count), "Count must be a power of 2"); // TODO Remove this requirement
-            GLU_CHECK_ARGUMENT(num_partitions >= 1, "Num of partitions must be >= 1");
-
-            upsweep(buffer, count, num_partitions); // Also clear last
-            downsweep(buffer, count, num_partitions);
-        }
-
-    private:
-        void upsweep(GLuint buffer, size_t count, size_t num_partitions) // Also clear last
-        {
-            m_upsweep_program.use();
-
-            glUniform1ui(m_upsweep_program.get_uniform_location("u_count"), count);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
-
-            int step = 1;
-            int level_count = (int) count;
-            while (true)
-            {
-                glUniform1ui(m_upsweep_program.get_uniform_location("u_step"), step);
-
-                size_t num_workgroups = div_ceil<size_t>(level_count, m_num_threads);
-                glDispatchCompute(num_workgroups, num_partitions, 1);
-                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-
-                step <<= 1;
-
-                level_count >>= 1;
-
-                if (level_count <= 1)
-                    break;
-            }
-        }
-
-        void downsweep(GLuint buffer, size_t count, size_t num_partitions)
-        {
-            m_downsweep_program.use();
-
-            glUniform1ui(m_downsweep_program.get_uniform_location("u_count"), count);
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
-
-            int step = next_power_of_2(int(count)) >> 1;
-            size_t level_count = 1;
-            while (true)
-            {
-                glUniform1ui(m_downsweep_program.get_uniform_location("u_step"), step);
-
-                size_t num_workgroups = div_ceil(level_count, m_num_threads);
-                glDispatchCompute(num_workgroups, num_partitions, 1);
-                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-
-                step >>= 1;
-                level_count <<= 1;
-                if (step == 0)
-                    break;
-            }
-        }
-    };
-} // namespace glu
-
-#endif // GLU_BLELLOCHSCAN_HPP
-
-
-#ifndef GLU_GL_UTILS_HPP
-#define GLU_GL_UTILS_HPP
+#ifndef GLU_GL_UTILS_HPP
+#define GLU_GL_UTILS_HPP
 
 #include <cmath>
 #include <functional>
@@ -1193,233 +1373,4288 @@ namespace glu
 {
     namespace detail
     {
-        inline const char* k_radix_sort_counting_shader = R"(
-layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
-
-layout(std430, binding = 0) readonly buffer KeyBuffer
-{
-    uint b_key_buffer[];
-};
+        inline const char* k_reduction_shader_src = R"(
+#extension GL_KHR_shader_subgroup_arithmetic : require
 
-layout(std430, binding = 1) buffer BlockCountBuffer
-{
-    uint b_block_count_buffer[]; // 16 * NUM_THREADS
-};
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
 
-layout(std430, binding = 2) buffer GlobalCountBuffer
+layout(std430, binding = 0) buffer Buffer
 {
-    uint b_global_count_buffer[];
+    DATA_TYPE data[];
 };
 
 layout(location = 0) uniform uint u_count;
-layout(location = 1) uniform uint u_radix_shift;
-layout(location = 2) uniform uint u_num_blocks_power_of_2;
+layout(location = 1) uniform uint u_depth;
 
 void main()
 {
-    for (uint radix = 0; radix < 16; radix++)
-    {
-        b_block_count_buffer[radix * u_num_blocks_power_of_2 + gl_WorkGroupID.x] = 0;
-    }
-
-    barrier();
-
-    uint i = gl_GlobalInvocationID.x;
+    uint step = 1 << (5 * u_depth);
+    uint subgroup_i = gl_WorkGroupID.x * NUM_THREADS + gl_SubgroupID * gl_SubgroupSize;
+    uint i = (subgroup_i + gl_SubgroupInvocationID) * step;
     if (i < u_count)
     {
-        // Block-wide count on shared memory
-        uint radix = (b_key_buffer[i] >> u_radix_shift) & 0xf;
-        atomicAdd(b_block_count_buffer[radix * u_num_blocks_power_of_2 + gl_WorkGroupID.x], 1);
-    }
-
-    barrier();
-
-    if (gl_LocalInvocationIndex < 16)
-    {
-        uint block_count = b_block_count_buffer[gl_LocalInvocationIndex * u_num_blocks_power_of_2 + gl_WorkGroupID.x];
-        atomicAdd(b_global_count_buffer[gl_LocalInvocationIndex], block_count);
+        DATA_TYPE r = SUBGROUP_OPERATION(data[i]);
+        if (gl_SubgroupInvocationID == 0)
+        {
+            data[i] = r;
+        }
     }
 }
 )";
 
-        inline const char* k_radix_sort_reordering_shader = R"(
+        /// Every workgroup reduces a tile of NUM_THREADS * NUM_ITEMS elements of the source (read from u_src_offset) to
+        /// an element of the destination (written at u_dst_offset + its index). No identity is needed: the threads
+        /// past the count sit out the subgroup operations, which only combine the active invocations.
+        inline const char* k_reduction_to_buffer_shader_src = R"(
 #extension GL_KHR_shader_subgroup_arithmetic : require
 
 layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
 
-layout(std430, binding = 0) readonly buffer SrcKeyBuffer
-{
-    uint b_src_key_buffer[];
-};
-
-layout(std430, binding = 1) readonly buffer SrcValBuffer
-{
-    uint b_src_val_buffer[];
-};
-
-layout(std430, binding = 2) writeonly buffer DstKeyBuffer
-{
-    uint b_dst_key_buffer[];
-};
-
-layout(std430, binding = 3) writeonly buffer DstValBuffer
+layout(std430, binding = 0) readonly buffer SrcBuffer
 {
-    uint b_dst_val_buffer[];
-};
-
-layout(std430, binding = 4) readonly buffer BlockOffsetBuffer
-{
-    uint b_block_offset_buffer[];
+    DATA_TYPE b_src_buffer[];
 };
 
-layout(std430, binding = 5) readonly buffer GlobalCountBuffer
+layout(std430, binding = 1) writeonly buffer DstBuffer
 {
-    uint b_global_count_buffer[];
+    DATA_TYPE b_dst_buffer[];
 };
 
 layout(location = 0) uniform uint u_count;
-layout(location = 1) uniform uint u_radix_shift;
-layout(location = 2) uniform uint u_num_blocks_power_of_2;
+layout(location = 1) uniform uint u_src_offset;
+layout(location = 2) uniform uint u_dst_offset;
 
-shared uint s_global_offset_buffer[16];
-shared uint s_prefix_sum_buffer[NUM_THREADS];
+shared DATA_TYPE s_subgroup_buffer[MAX_NUM_SUBGROUPS];
 
-void prefix_sum()  // Block-wide prefix sum (Blelloch scan)
+void main()
 {
-    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint tile_i = workgroup_i * NUM_THREADS * NUM_ITEMS;
+    if (tile_i >= u_count) return;
 
-    // Upsweep
-    for (uint step = 1; step < NUM_THREADS; step <<= 1)
+    // The threads holding an element are the first ones of the workgroup, filling its first subgroups
+    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+    uint i = tile_i + thread_i;
+    if (i < u_count)
     {
-        if (thread_i % 2 == 1)
+        DATA_TYPE value = b_src_buffer[u_src_offset + i];
+        for (uint item_i = 1; item_i < NUM_ITEMS; item_i++)
         {
-            uint i = thread_i * step + (step - 1);
-            if (i < NUM_THREADS)
-            {
-                s_prefix_sum_buffer[i] = s_prefix_sum_buffer[i] + s_prefix_sum_buffer[i - step];
-            }
+            uint j = i + item_i * NUM_THREADS;
+            if (j < u_count) value = OPERATOR(value, b_src_buffer[u_src_offset + j]);
         }
 
-        barrier();
+        DATA_TYPE r = SUBGROUP_OPERATION(value);
+        if (subgroupElect()) s_subgroup_buffer[gl_SubgroupID] = r;
     }
 
-    // Clear last
-    if (thread_i == NUM_THREADS - 1) s_prefix_sum_buffer[thread_i] = 0;
-
     barrier();
 
-    // Downsweep
-    uint step = NUM_THREADS >> 1;
-    for (; step > 0; step >>= 1)
+    uint num_subgroups = (min(u_count - tile_i, NUM_THREADS) + gl_SubgroupSize - 1) / gl_SubgroupSize;
+    if (gl_SubgroupID == 0 && gl_SubgroupInvocationID < num_subgroups)
     {
-        uint i = thread_i * step + (step - 1);
-        if (i + step < NUM_THREADS && thread_i % 2 == 0)
-        {
-            uint tmp = s_prefix_sum_buffer[i];
-            s_prefix_sum_buffer[i] = s_prefix_sum_buffer[i + step];
-            s_prefix_sum_buffer[i + step] = tmp + s_prefix_sum_buffer[i + step];
-        }
+        DATA_TYPE value = s_subgroup_buffer[gl_SubgroupInvocationID];
+        for (uint j = gl_SubgroupInvocationID + gl_SubgroupSize; j < num_subgroups; j += gl_SubgroupSize)
+            value = OPERATOR(value, s_subgroup_buffer[j]);
 
-        barrier();
+        DATA_TYPE r = SUBGROUP_OPERATION(value);
+        if (subgroupElect()) b_dst_buffer[u_dst_offset + workgroup_i] = r;
     }
 }
-
-void main()
-{
-    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
-    uint i = gl_WorkGroupID.x * NUM_THREADS + thread_i;
-
-    // Prefix sum on global counts to obtain global offsets
-    if (gl_SubgroupID == 0 && gl_SubgroupInvocationID < 16)
-    {
-        uint v = subgroupExclusiveAdd(b_global_count_buffer[gl_SubgroupInvocationID]);
-        s_global_offset_buffer[gl_SubgroupInvocationID] = v;
+)";
     }
 
-    barrier();
-
-    // Reordering
-    for (uint radix = 0; radix < 16; radix++)
+    /// The operators that can be used for the reduction operation.
+    enum ReduceOperator
     {
-        bool should_place = false;
-        if (i < u_count)
-        {
-            should_place = ((b_src_key_buffer[i] >> u_radix_shift) & 0xf) == radix;
-        }
-
-        s_prefix_sum_buffer[thread_i] = should_place ? 1 : 0;
-
-        barrier();
-
-        // Prefix sum on local counts to obtain local offsets
-        prefix_sum();
-
-        if (should_place)
-        {
-            uint di =
-                s_global_offset_buffer[radix] +
-                b_block_offset_buffer[radix * u_num_blocks_power_of_2 + gl_WorkGroupID.x] +
-                s_prefix_sum_buffer[thread_i];
-            b_dst_key_buffer[di] = b_src_key_buffer[i];
-            b_dst_val_buffer[di] = b_src_val_buffer[i];
-        }
-    }
-}
-)";
-    } // namespace detail
+        ReduceOperator_Sum = 0,
+        ReduceOperator_Mul,
+        ReduceOperator_Min,
+        ReduceOperator_Max,
+        ReduceOperator_Or ///< Bitwise OR, only for integer data types
+    };
 
-    class RadixSort
+    /// A class that implements the reduction operation.
+    class Reduce
     {
     private:
-        Program m_count_program;
-        BlellochScan m_blelloch_scan;
-        Program m_reorder_program;
-
-        /// A GLuint buffer of size 16 * NUM_THREADS that stores the counts of radixes per block.
-        ShaderStorageBuffer m_block_count_buffer;
-
-        /// A GLuint buffer of size 16 that stores the global counts of radixes.
-        ShaderStorageBuffer m_global_count_buffer;
+        const DataType m_data_type;
+        const ReduceOperator m_operator;
+        const size_t m_num_threads;
+        const size_t m_num_items;
 
-        ShaderStorageBuffer m_key_scratch_buffer;
-        ShaderStorageBuffer m_val_scratch_buffer;
+        Program m_program;
+        Program m_to_buffer_program;
 
-        const size_t m_num_threads;
+        /// The partial results of the levels of a reduction to a buffer, but the last one: an element per tile.
+        ShaderStorageBuffer m_scratch_buffer;
 
     public:
-        explicit RadixSort() :
-            m_blelloch_scan(DataType_Uint),
-            m_num_threads(1024)
+        explicit Reduce(DataType data_type, ReduceOperator operator_) :
+            m_data_type(data_type),
+            m_operator(operator_),
+            m_num_threads(1024),
+            m_num_items(4)
+        {
+            GLint subgroup_size = 0;
+            glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &subgroup_size);
+            GLU_CHECK_STATE(
+                subgroup_size > 0 && m_num_threads % subgroup_size == 0, "Unsupported subgroup size: %d", subgroup_size
+            );
+
+            std::string shader_src = "#version 460\n\n";
+
+            shader_src += std::string("#define DATA_TYPE ") + to_glsl_type_str(m_data_type) + "\n";
+            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
+            shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
+
+            if (m_operator == ReduceOperator_Sum)
+            {
+                shader_src += "#define OPERATOR(a, b) (a + b)\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupAdd(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Mul)
+            {
+                shader_src += "#define OPERATOR(a, b) (a * b)\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMul(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Min)
+            {
+                shader_src += "#define OPERATOR(a, b) (min(a, b))\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMin(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Max)
+            {
+                shader_src += "#define OPERATOR(a, b) (max(a, b))\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMax(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Or)
+            {
+                GLU_CHECK_ARGUMENT(is_integer_data_type(m_data_type), "OR requires an integer data type");
+
+                shader_src += "#define OPERATOR(a, b) (a | b)\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupOr(value)\n";
+            }
+            else
+            {
+                GLU_FAIL("Invalid reduction operator: %d", m_operator);
+            }
+
+            shader_src += "#define MAX_NUM_SUBGROUPS " + std::to_string(m_num_threads / subgroup_size) + "\n";
+
+            build_program(m_program, shader_src + detail::k_reduction_shader_src);
+            build_program(m_to_buffer_program, shader_src + detail::k_reduction_to_buffer_shader_src);
+        }
+
+        ~Reduce() = default;
+
+        /// Reduces the buffer in place: the result is written to its first element, the others are overwritten.
+        void operator()(GLuint buffer, size_t count)
+        {
+            GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
+            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
+
+            m_program.use();
+
+            glUniform1ui(m_program.get_uniform_location("u_count"), count);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+
+            for (int depth = 0;; depth++)
+            {
+                int step = 1 << (5 * depth);
+                if (step >= count)
+                    break;
+
+                size_t level_count = count >> (5 * depth);
+
+                glUniform1ui(m_program.get_uniform_location("u_depth"), depth);
+
+                size_t num_workgroups = div_ceil(level_count, m_num_threads);
+                glDispatchCompute(num_workgroups, 1, 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            }
+        }
+
+        /// Reduces a range of the input buffer, left untouched, and writes the result to an element of the result
+        /// buffer. Every level reduces tiles of m_num_threads * m_num_items elements to an element of the internal
+        /// scratch buffer, until a single tile remains, whose result is written straight to the result buffer.
+        ///
+        /// @param input_buffer the input buffer (of the data type), only read
+        /// @param offset the index of the first element to reduce
+        /// @param count the number of elements to reduce (offset + count up to 2^31)
+        /// @param result_buffer the buffer the result is written to; it can be the input buffer, outside of the range
+        /// @param result_offset the index of the element of the result buffer the result is written to
+        void operator()(GLuint input_buffer, size_t offset, size_t count, GLuint result_buffer, size_t result_offset)
+        {
+            GLU_CHECK_ARGUMENT(input_buffer, "Invalid input buffer");
+            GLU_CHECK_ARGUMENT(result_buffer, "Invalid result buffer");
+            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
+            GLU_CHECK_ARGUMENT(offset + count <= (size_t(1) << 31), "The range must end within 2^31 elements");
+            GLU_CHECK_ARGUMENT(result_offset < (size_t(1) << 31), "Result offset must be less than 2^31");
+
+            size_t tile_size = m_num_threads * m_num_items;
+
+            // Every level but the last one writes its results after those of the previous level
+            size_t required_count = 0;
+            for (size_t level_count = div_ceil(count, tile_size); level_count > 1;
+                 level_count = div_ceil(level_count, tile_size))
+                required_count += level_count;
+
+            size_t required_size = required_count * get_data_type_size(m_data_type);
+            if (m_scratch_buffer.size() < required_size)
+                m_scratch_buffer.resize(required_size, false);
+
+            m_to_buffer_program.use();
+
+            GLuint src_buffer = input_buffer;
+            size_t src_offset = offset;
+            size_t level_count = count;
+            size_t scratch_offset = 0;
+            while (true)
+            {
+                size_t num_workgroups = div_ceil(level_count, tile_size);
+                bool last_level = num_workgroups == 1;
+
+                GLuint dst_buffer = last_level ? result_buffer : m_scratch_buffer.handle();
+                size_t dst_offset = last_level ? result_offset : scratch_offset;
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src_buffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, dst_buffer);
+
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_count"), level_count);
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_src_offset"), src_offset);
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_dst_offset"), dst_offset);
+
+                // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+                size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+                glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+                if (last_level)
+                    break;
+
+                src_buffer = m_scratch_buffer.handle();
+                src_offset = scratch_offset;
+                level_count = num_workgroups;
+                scratch_offset += num_workgroups;
+            }
+        }
+
+    private:
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_REDUCE_HPP
+
+
+#ifndef GLU_DATA_TYPES_HPP
+#define GLU_DATA_TYPES_HPP
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    enum DataType
+    {
+        DataType_Float = 0,
+        DataType_Double,
+        DataType_Int,
+        DataType_Uint,
+        DataType_Vec2,
+        DataType_Vec4,
+        DataType_DVec2,
+        DataType_DVec4,
+        DataType_UVec2,
+        DataType_UVec4,
+        DataType_IVec2,
+        DataType_IVec4
+    };
+
+    inline const char* to_glsl_type_str(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return "float";
+        else if (data_type == DataType_Double) return "double";
+        else if (data_type == DataType_Int)    return "int";
+        else if (data_type == DataType_Uint)   return "uint";
+        else if (data_type == DataType_Vec2)   return "vec2";
+        else if (data_type == DataType_Vec4)   return "vec4";
+        else if (data_type == DataType_DVec2)  return "dvec2";
+        else if (data_type == DataType_DVec4)  return "dvec4";
+        else if (data_type == DataType_UVec2)  return "uvec2";
+        else if (data_type == DataType_UVec4)  return "uvec4";
+        else if (data_type == DataType_IVec2)  return "ivec2";
+        else if (data_type == DataType_IVec4)  return "ivec4";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+} // namespace glu
+
+#endif // GLU_DATA_TYPES_HPP
+
+
+
+namespace glu
+{
+    namespace detail
+    {
+        /// The exclusive scan of a value per thread of the workgroup: every subgroup scans its values, then the first
+        /// subgroup scans the totals of the subgroups (by chunks of gl_SubgroupSize, if there are more of them).
+        inline const char* k_scan_common_shader_src = R"(
+#extension GL_KHR_shader_subgroup_arithmetic : require
+
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer Buffer
+{
+    DATA_TYPE data[];
+};
+
+layout(std430, binding = 1) buffer BlockSumBuffer
+{
+    DATA_TYPE b_block_sum_buffer[]; // num_partitions * num_blocks
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_num_blocks;
+
+shared DATA_TYPE s_subgroup_buffer[MAX_NUM_SUBGROUPS];
+shared DATA_TYPE s_total;
+
+/// Returns the exclusive scan of the value of this thread, and writes the total of the workgroup to s_total.
+DATA_TYPE workgroup_exclusive_scan(DATA_TYPE value)
+{
+    DATA_TYPE prefix = SUBGROUP_EXCLUSIVE_OPERATION(value);
+    DATA_TYPE subgroup_total = SUBGROUP_OPERATION(value);
+    if (subgroupElect()) s_subgroup_buffer[gl_SubgroupID] = subgroup_total;
+
+    barrier();
+
+    if (gl_SubgroupID == 0)
+    {
+        DATA_TYPE carry = IDENTITY;
+        for (uint base_i = 0; base_i < gl_NumSubgroups; base_i += gl_SubgroupSize)
+        {
+            uint i = base_i + gl_SubgroupInvocationID;
+            DATA_TYPE sum = i < gl_NumSubgroups ? s_subgroup_buffer[i] : IDENTITY;
+            if (i < gl_NumSubgroups) s_subgroup_buffer[i] = OPERATION(carry, SUBGROUP_EXCLUSIVE_OPERATION(sum));
+            carry = OPERATION(carry, SUBGROUP_OPERATION(sum));
+        }
+        if (subgroupElect()) s_total = carry;
+    }
+
+    barrier();
+
+    return OPERATION(s_subgroup_buffer[gl_SubgroupID], prefix);
+}
+)";
+
+        /// Phase 1: every workgroup reduces a tile of NUM_THREADS * NUM_ITEMS elements to its block sum. Items are
+        /// read NUM_THREADS apart, the order doesn't matter here.
+        inline const char* k_scan_reduce_shader_src = R"(
+void main()
+{
+    uint partition_i = gl_WorkGroupID.z;
+    uint block_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (block_i >= u_num_blocks) return; // The 2D dispatch may exceed the blocks (uniform per workgroup)
+
+    uint base_i = partition_i * u_count;
+    uint tile_i = block_i * NUM_THREADS * NUM_ITEMS;
+
+    DATA_TYPE thread_sum = IDENTITY;
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        uint i = tile_i + item_i * NUM_THREADS + gl_LocalInvocationIndex;
+        if (i < u_count) thread_sum = OPERATION(thread_sum, data[base_i + i]);
+    }
+
+    workgroup_exclusive_scan(thread_sum);
+
+    if (gl_LocalInvocationIndex == 0) b_block_sum_buffer[partition_i * u_num_blocks + block_i] = s_total;
+}
+)";
+
+        /// Phase 2: a workgroup per partition scans its block sums, a tile at a time.
+        inline const char* k_scan_block_sums_shader_src = R"(
+void main()
+{
+    uint partition_i = gl_WorkGroupID.z;
+    uint base_i = partition_i * u_num_blocks;
+
+    DATA_TYPE carry = IDENTITY;
+    for (uint tile_i = 0; tile_i < u_num_blocks; tile_i += NUM_THREADS * NUM_ITEMS)
+    {
+        uint i = tile_i + gl_LocalInvocationIndex * NUM_ITEMS;
+
+        DATA_TYPE items[NUM_ITEMS];
+        DATA_TYPE thread_sum = IDENTITY;
+        for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+        {
+            items[item_i] = i + item_i < u_num_blocks ? b_block_sum_buffer[base_i + i + item_i] : IDENTITY;
+            thread_sum = OPERATION(thread_sum, items[item_i]);
+        }
+
+        DATA_TYPE prefix = OPERATION(carry, workgroup_exclusive_scan(thread_sum));
+        for (uint item_i = 0; item_i < NUM_ITEMS && i + item_i < u_num_blocks; item_i++)
+        {
+            b_block_sum_buffer[base_i + i + item_i] = prefix;
+            prefix = OPERATION(prefix, items[item_i]);
+        }
+
+        carry = OPERATION(carry, s_total);
+
+        barrier(); // s_total and s_subgroup_buffer are written again by the next tile
+    }
+}
+)";
+
+        /// Phase 3: every workgroup scans its tile, NUM_ITEMS consecutive elements per thread, starting from the
+        /// scanned sum of the blocks before it. If INCLUSIVE, every element is included in its own prefix.
+        inline const char* k_scan_downsweep_shader_src = R"(
+void main()
+{
+    uint partition_i = gl_WorkGroupID.z;
+    uint block_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (block_i >= u_num_blocks) return;
+
+    uint base_i = partition_i * u_count;
+    uint i = block_i * NUM_THREADS * NUM_ITEMS + gl_LocalInvocationIndex * NUM_ITEMS;
+
+    DATA_TYPE items[NUM_ITEMS];
+    DATA_TYPE thread_sum = IDENTITY;
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        items[item_i] = i + item_i < u_count ? data[base_i + i + item_i] : IDENTITY;
+        thread_sum = OPERATION(thread_sum, items[item_i]);
+    }
+
+    DATA_TYPE block_prefix = b_block_sum_buffer[partition_i * u_num_blocks + block_i];
+    DATA_TYPE prefix = OPERATION(block_prefix, workgroup_exclusive_scan(thread_sum));
+    for (uint item_i = 0; item_i < NUM_ITEMS && i + item_i < u_count; item_i++)
+    {
+#ifdef INCLUSIVE
+        prefix = OPERATION(prefix, items[item_i]);
+        data[base_i + i + item_i] = prefix;
+#else
+        data[base_i + i + item_i] = prefix;
+        prefix = OPERATION(prefix, items[item_i]);
+#endif
+    }
+}
+)";
+
+        /// The definitions of OPERATION, its subgroup operations and its IDENTITY, for the given data type (vector
+        /// types are combined component-wise).
+        inline std::string get_scan_operator_src(DataType data_type, ReduceOperator operator_)
+        {
+            std::string component_type = to_glsl_component_type_str(data_type);
+
+            // The greatest and the lowest component values, the identities of Min and Max
+            std::string greatest, lowest;
+            if (component_type == "float")
+            {
+                greatest = "uintBitsToFloat(0x7f800000u)"; // +inf
+                lowest = "uintBitsToFloat(0xff800000u)";   // -inf
+            }
+            else if (component_type == "double")
+            {
+                greatest = "packDouble2x32(uvec2(0u, 0x7ff00000u))"; // +inf
+                lowest = "packDouble2x32(uvec2(0u, 0xfff00000u))";   // -inf
+            }
+            else if (component_type == "int")
+            {
+                greatest = "0x7fffffff";
+                lowest = "(-0x7fffffff - 1)";
+            }
+            else
+            {
+                greatest = "0xffffffffu";
+                lowest = "0u";
+            }
+
+            std::string src;
+            if (operator_ == ReduceOperator_Sum)
+            {
+                src += "#define OPERATION(a, b) (a + b)\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupAdd(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveAdd(value)\n";
+                src += "#define IDENTITY DATA_TYPE(0)\n";
+            }
+            else if (operator_ == ReduceOperator_Mul)
+            {
+                src += "#define OPERATION(a, b) (a * b)\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupMul(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveMul(value)\n";
+                src += "#define IDENTITY DATA_TYPE(1)\n";
+            }
+            else if (operator_ == ReduceOperator_Min)
+            {
+                src += "#define OPERATION(a, b) (min(a, b))\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupMin(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveMin(value)\n";
+                src += "#define IDENTITY DATA_TYPE(" + greatest + ")\n";
+            }
+            else if (operator_ == ReduceOperator_Max)
+            {
+                src += "#define OPERATION(a, b) (max(a, b))\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupMax(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveMax(value)\n";
+                src += "#define IDENTITY DATA_TYPE(" + lowest + ")\n";
+            }
+            else if (operator_ == ReduceOperator_Or)
+            {
+                GLU_CHECK_ARGUMENT(is_integer_data_type(data_type), "OR requires an integer data type");
+
+                src += "#define OPERATION(a, b) (a | b)\n";
+                src += "#define SUBGROUP_OPERATION(value) subgroupOr(value)\n";
+                src += "#define SUBGROUP_EXCLUSIVE_OPERATION(value) subgroupExclusiveOr(value)\n";
+                src += "#define IDENTITY DATA_TYPE(0)\n";
+            }
+            else
+            {
+                GLU_FAIL("Invalid scan operator: %d", operator_);
+            }
+            return src;
+        }
+    } // namespace detail
+
+    /// The kinds of scan: whether every element is included in its own prefix.
+    enum ScanType
+    {
+        ScanType_Exclusive = 0,
+        ScanType_Inclusive
+    };
+
+    /// A class that implements a prefix scan (by default an exclusive prefix sum), by reduce-then-scan: every block of
+    /// NUM_THREADS * NUM_ITEMS elements is reduced to its sum, the block sums are scanned by a single workgroup, then
+    /// every block is scanned starting from its scanned sum. That's 3 dispatches whatever the count, reading the
+    /// elements twice and writing them once.
+    ///
+    /// Vector data types are scanned component-wise, e.g. DataType_Vec4 runs 4 prefix sums at once.
+    class BlellochScan
+    {
+    private:
+        const DataType m_data_type;
+        const ReduceOperator m_operator;
+        const ScanType m_scan_type;
+        const size_t m_num_threads;
+        const size_t m_num_items;
+
+        Program m_reduce_program;
+        Program m_block_sums_program;
+        Program m_downsweep_program;
+
+        /// The sum of every block, then its exclusive prefix (for every partition).
+        ShaderStorageBuffer m_block_sum_buffer;
+
+    public:
+        /// @param data_type the type of the elements
+        /// @param operator_ the operator of the scan (ReduceOperator_Or only for integer data types)
+        /// @param scan_type whether the scan is exclusive (the first element is the identity) or inclusive
+        explicit BlellochScan(
+            DataType data_type,
+            ReduceOperator operator_ = ReduceOperator_Sum,
+            ScanType scan_type = ScanType_Exclusive
+        ) :
+            m_data_type(data_type),
+            m_operator(operator_),
+            m_scan_type(scan_type),
+            m_num_threads(1024),
+            m_num_items(4)
+        {
+            GLint subgroup_size = 0;
+            glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &subgroup_size);
+            GLU_CHECK_STATE(
+                subgroup_size > 0 && m_num_threads % subgroup_size == 0, "Unsupported subgroup size: %d", subgroup_size
+            );
+
+            std::string shader_src = "#version 460\n\n";
+
+            shader_src += std::string("#define DATA_TYPE ") + to_glsl_type_str(m_data_type) + "\n";
+            shader_src += detail::get_scan_operator_src(m_data_type, m_operator);
+            if (m_scan_type == ScanType_Inclusive)
+                shader_src += "#define INCLUSIVE\n";
+            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
+            shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
+            shader_src += "#define MAX_NUM_SUBGROUPS " + std::to_string(m_num_threads / subgroup_size) + "\n";
+            shader_src += detail::k_scan_common_shader_src;
+
+            build_program(m_reduce_program, shader_src + detail::k_scan_reduce_shader_src);
+            build_program(m_block_sums_program, shader_src + detail::k_scan_block_sums_shader_src);
+            build_program(m_downsweep_program, shader_src + detail::k_scan_downsweep_shader_src);
+        }
+
+        ~BlellochScan() = default;
+
+        /// Runs the scan on multiple partitions, in place.
+        ///
+        /// @param buffer the input buffer (of the data type)
+        /// @param count the number of elements in every partition (up to 2^30)
+        /// @param num_partitions the number of partitions (must be adjacent)
+        void operator()(GLuint buffer, size_t count, size_t num_partitions = 1)
+        {
+            GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
+            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
+            GLU_CHECK_ARGUMENT(count <= (size_t(1) << 30), "Count must be at most 2^30");
+            GLU_CHECK_ARGUMENT(num_partitions >= 1, "Num of partitions must be >= 1");
+
+            size_t num_blocks = div_ceil(count, m_num_threads * m_num_items);
+
+            size_t required_size = num_partitions * num_blocks * get_data_type_size(m_data_type);
+            if (m_block_sum_buffer.size() < required_size)
+                m_block_sum_buffer.resize(required_size, false);
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+            m_block_sum_buffer.bind(1);
+
+            // Blocks on two dimensions, as the guaranteed max workgroup count is 65535; partitions on the third one
+            size_t num_blocks_x = std::min<size_t>(num_blocks, 65535);
+            size_t num_blocks_y = div_ceil(num_blocks, num_blocks_x);
+
+            // ---------------------------------------------------------------- Reduce
+
+            m_reduce_program.use();
+
+            glUniform1ui(m_reduce_program.get_uniform_location("u_count"), count);
+            glUniform1ui(m_reduce_program.get_uniform_location("u_num_blocks"), num_blocks);
+
+            glDispatchCompute(num_blocks_x, num_blocks_y, num_partitions);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // ---------------------------------------------------------------- Scan of block sums
+
+            m_block_sums_program.use();
+
+            glUniform1ui(m_block_sums_program.get_uniform_location("u_num_blocks"), num_blocks);
+
+            glDispatchCompute(1, 1, num_partitions);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // ---------------------------------------------------------------- Downsweep
+
+            m_downsweep_program.use();
+
+            glUniform1ui(m_downsweep_program.get_uniform_location("u_count"), count);
+            glUniform1ui(m_downsweep_program.get_uniform_location("u_num_blocks"), num_blocks);
+
+            glDispatchCompute(num_blocks_x, num_blocks_y, num_partitions);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+    private:
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_BLELLOCHSCAN_HPP
+
+
+#ifndef GLU_MERGE_HPP
+#define GLU_MERGE_HPP
+
+#include <algorithm>
+
+#ifndef GLU_DATA_TYPES_HPP
+#define GLU_DATA_TYPES_HPP
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    enum DataType
+    {
+        DataType_Float = 0,
+        DataType_Double,
+        DataType_Int,
+        DataType_Uint,
+        DataType_Vec2,
+        DataType_Vec4,
+        DataType_DVec2,
+        DataType_DVec4,
+        DataType_UVec2,
+        DataType_UVec4,
+        DataType_IVec2,
+        DataType_IVec4
+    };
+
+    inline const char* to_glsl_type_str(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return "float";
+        else if (data_type == DataType_Double) return "double";
+        else if (data_type == DataType_Int)    return "int";
+        else if (data_type == DataType_Uint)   return "uint";
+        else if (data_type == DataType_Vec2)   return "vec2";
+        else if (data_type == DataType_Vec4)   return "vec4";
+        else if (data_type == DataType_DVec2)  return "dvec2";
+        else if (data_type == DataType_DVec4)  return "dvec4";
+        else if (data_type == DataType_UVec2)  return "uvec2";
+        else if (data_type == DataType_UVec4)  return "uvec4";
+        else if (data_type == DataType_IVec2)  return "ivec2";
+        else if (data_type == DataType_IVec4)  return "ivec4";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+} // namespace glu
+
+#endif // GLU_DATA_TYPES_HPP
+
+
+#ifndef GLU_GL_UTILS_HPP
+#define GLU_GL_UTILS_HPP
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    inline void
+    copy_buffer(GLuint src_buffer, GLuint dst_buffer, size_t size, size_t src_offset = 0, size_t dst_offset = 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, src_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, dst_buffer);
+
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr) src_offset, (GLintptr) dst_offset, (GLsizeiptr) size
+        );
+    }
+
+    /// A RAII wrapper for GL shader.
+    class Shader
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Shader(GLenum type) :
+            m_handle(glCreateShader(type)){};
+        Shader(const Shader&) = delete;
+
+        Shader(Shader&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Shader() { glDeleteShader(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void source_from_str(const std::string& src_str)
+        {
+            const char* src_ptr = src_str.c_str();
+            glShaderSource(m_handle, 1, &src_ptr, nullptr);
+        }
+
+        void source_from_file(const char* src_filepath)
+        {
+            FILE* file = fopen(src_filepath, "rt");
+            GLU_CHECK_STATE(!file, "Failed to shader file: %s", src_filepath);
+
+            fseek(file, 0, SEEK_END);
+            size_t file_size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+
+            std::string src{};
+            src.resize(file_size);
+            fread(src.data(), sizeof(char), file_size, file);
+            source_from_str(src.c_str());
+
+            fclose(file);
+        }
+
+        std::string get_info_log()
+        {
+            GLint log_length = 0;
+            glGetShaderiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetShaderInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void compile()
+        {
+            glCompileShader(m_handle);
+
+            GLint status;
+            glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Shader failed to compile: %s", get_info_log().c_str());
+            }
+        }
+    };
+
+    /// A RAII wrapper for GL program.
+    class Program
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Program() { m_handle = glCreateProgram(); };
+        Program(const Program&) = delete;
+
+        Program(Program&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Program() { glDeleteProgram(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void attach_shader(GLuint shader_handle) { glAttachShader(m_handle, shader_handle); }
+        void attach_shader(const Shader& shader) { glAttachShader(m_handle, shader.handle()); }
+
+        [[nodiscard]] std::string get_info_log() const
+        {
+            GLint log_length = 0;
+            glGetProgramiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetProgramInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void link()
+        {
+            GLint status;
+            glLinkProgram(m_handle);
+            glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Program failed to link: %s", get_info_log().c_str());
+            }
+        }
+
+        void use() { glUseProgram(m_handle); }
+
+        GLint get_uniform_location(const char* uniform_name)
+        {
+            GLint loc = glGetUniformLocation(m_handle, uniform_name);
+            GLU_CHECK_STATE(loc >= 0, "Failed to get uniform location: %s", uniform_name);
+            return loc;
+        }
+    };
+
+    /// A RAII helper class for GL shader storage buffer.
+    class ShaderStorageBuffer
+    {
+    private:
+        GLuint m_handle = 0;
+        size_t m_size = 0;
+
+    public:
+        explicit ShaderStorageBuffer(size_t initial_size = 0)
+        {
+            if (initial_size > 0)
+                resize(initial_size, false);
+        }
+
+        explicit ShaderStorageBuffer(const void* data, size_t size) :
+            m_size(size)
+        {
+            GLU_CHECK_ARGUMENT(data, "");
+            GLU_CHECK_ARGUMENT(size > 0, "");
+
+            glCreateBuffers(1, &m_handle);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, data, GL_DYNAMIC_STORAGE_BIT);
+        }
+
+        template<typename T>
+        explicit ShaderStorageBuffer(const std::vector<T>& data) :
+            ShaderStorageBuffer(data.data(), data.size() * sizeof(T))
+        {
+        }
+
+        ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+        ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            m_size = other.m_size;
+            other.m_handle = 0;
+        }
+
+        ~ShaderStorageBuffer()
+        {
+            if (m_handle)
+                glDeleteBuffers(1, &m_handle);
+        }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        /// Grows or shrinks the buffer. If keep_data, performs an additional copy to maintain the data.
+        void resize(size_t size, bool keep_data = false)
+        {
+            size_t old_size = m_size;
+            GLuint old_handle = m_handle;
+
+            if (old_size != size)
+            {
+                m_size = size;
+
+                glCreateBuffers(1, &m_handle);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+                glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+                if (keep_data)
+                    copy_buffer(old_handle, m_handle, std::min(old_size, size));
+
+                glDeleteBuffers(1, &old_handle);
+            }
+        }
+
+        /// Clears the entire buffer with the given GLuint value (repeated).
+        void clear(GLuint value)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED, GL_UNSIGNED_INT, &value);
+        }
+
+        void write_data(const void* data, size_t size)
+        {
+            GLU_CHECK_ARGUMENT(size <= m_size, "");
+
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+        }
+
+        template<typename T>
+        std::vector<T> get_data() const
+        {
+            GLU_CHECK_ARGUMENT(m_size % sizeof(T) == 0, "Size %zu isn't a multiple of %zu", m_size, sizeof(T));
+
+            std::vector<T> result(m_size / sizeof(T));
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) m_size, result.data());
+            return result;
+        }
+
+        void bind(GLuint index, size_t size = 0, size_t offset = 0)
+        {
+            if (size == 0)
+                size = m_size;
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, m_handle, (GLintptr) offset, (GLsizeiptr) size);
+        }
+    };
+
+    /// Measures elapsed time on GPU for executing the given callback.
+    inline uint64_t measure_gl_elapsed_time(const std::function<void()>& callback)
+    {
+        GLuint query;
+        uint64_t elapsed_time{};
+
+        glGenQueries(1, &query);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        callback();
+
+        glEndQuery(GL_TIME_ELAPSED);
+
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
+        glDeleteQueries(1, &query);
+
+        return elapsed_time;
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_floor(IntegerT n)
+    {
+        return (IntegerT) floor(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_ceil(IntegerT n)
+    {
+        return (IntegerT) ceil(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT div_ceil(IntegerT n, IntegerT d)
+    {
+        return (IntegerT) ceil(double(n) / double(d));
+    }
+
+    template<typename T>
+    bool is_power_of_2(T n)
+    {
+        return (n & (n - 1)) == 0;
+    }
+
+    template<typename IntegerT>
+    IntegerT next_power_of_2(IntegerT n)
+    {
+        n--;
+        n |= n >> 1;
+        n |= n >> 2;
+        n |= n >> 4;
+        n |= n >> 8;
+        n |= n >> 16;
+        n++;
+        return n;
+    }
+
+    template<typename Iterator>
+    void print_stl_container(Iterator begin, Iterator end)
+    {
+        size_t i = 0;
+        for (; begin != end; begin++)
+        {
+            printf("(%zu) %s, ", i, std::to_string(*begin).c_str());
+            i++;
+        }
+        printf("\n");
+    }
+
+    template<typename T>
+    void print_buffer(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<T> data = buffer.get_data<T>();
+        print_stl_container(data.begin(), data.end());
+    }
+
+    inline void print_buffer_hex(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<GLuint> data = buffer.get_data<GLuint>();
+        for (size_t i = 0; i < data.size(); i++)
+            printf("(%zu) %08x, ", i, data[i]);
+        printf("\n");
+    }
+} // namespace glu
+
+#endif // GLU_GL_UTILS_HPP
+
+
+#ifndef GLU_RADIX_SORT_COMMON_HPP
+#define GLU_RADIX_SORT_COMMON_HPP
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Code shared by all the RadixSort shaders. Keys are either uint (32 bits) or uvec2 (64 bits, low bits in x).
+        ///
+        /// Signed and floating-point keys are sorted as unsigned integers after an order-preserving bit transform:
+        /// the sign bit of integers is flipped; the sign bit of positive floats is flipped, and all the bits of
+        /// negative floats. NaNs are cleared of their sign so that they're always placed after +inf.
+        inline const char* k_radix_sort_common_shader = R"(
+#if defined(FLOAT_KEYS) && KEY_NUM_BITS == 64
+const uvec2 k_sign_mask = uvec2(0, 0x80000000u);
+
+bool is_nan(uvec2 key)
+{
+    uint hi = key.y & 0x7fffffffu;
+    return hi > 0x7ff00000u || (hi == 0x7ff00000u && key.x != 0);
+}
+
+uvec2 to_sortable_key(uvec2 key)
+{
+    if (is_nan(key)) key.y &= 0x7fffffffu;
+    return (key.y & 0x80000000u) != 0 ? ~key : key ^ k_sign_mask;
+}
+
+uvec2 from_sortable_key(uvec2 key)
+{
+    return (key.y & 0x80000000u) != 0 ? key ^ k_sign_mask : ~key;
+}
+#elif defined(FLOAT_KEYS)
+uint to_sortable_key(uint key)
+{
+    if ((key & 0x7fffffffu) > 0x7f800000u) key &= 0x7fffffffu; // NaN
+    return (key & 0x80000000u) != 0 ? ~key : key ^ 0x80000000u;
+}
+
+uint from_sortable_key(uint key)
+{
+    return (key & 0x80000000u) != 0 ? key ^ 0x80000000u : ~key;
+}
+#elif defined(SIGNED_KEYS)
+uint to_sortable_key(uint key) { return key ^ 0x80000000u; }
+uint from_sortable_key(uint key) { return key ^ 0x80000000u; }
+#endif
+
+/// Gets the digit of the key starting at the given bit; mask selects the digit bits.
+uint get_radix(KEY_TYPE key, uint shift, uint mask)
+{
+#if KEY_NUM_BITS == 64
+    uint bits = shift < 32 ? (key.x >> shift) : (key.y >> (shift - 32));
+    if (shift > 0 && shift < 32)
+    {
+        bits |= key.y << (32 - shift); // The digit may lie across the two halves (extra bits are masked)
+    }
+    return bits & mask;
+#else
+    return (key >> shift) & mask;
+#endif
+}
+
+/// Gets the digit the key is ranked by: in descending order digits are reversed, so that the largest comes first and
+/// keys with the same digit keep their order (the sort stays stable).
+uint get_key_radix(KEY_TYPE key, uint shift, uint mask)
+{
+#ifdef DESCENDING
+    return mask - get_radix(key, shift, mask);
+#else
+    return get_radix(key, shift, mask);
+#endif
+}
+
+/// Whether key1 is placed strictly before key2 by the sort (keys as stored, not transformed).
+bool precedes(KEY_TYPE key1, KEY_TYPE key2)
+{
+#ifdef TRANSFORM_KEYS
+    key1 = to_sortable_key(key1);
+    key2 = to_sortable_key(key2);
+#endif
+#ifdef DESCENDING
+    KEY_TYPE tmp = key1;
+    key1 = key2;
+    key2 = tmp;
+#endif
+#if KEY_NUM_BITS == 64
+    return key1.y < key2.y || (key1.y == key2.y && key1.x < key2.x);
+#else
+    return key1 < key2;
+#endif
+}
+)";
+    } // namespace detail
+
+    /// The order RadixSort sorts the keys in. Both orders are stable.
+    enum SortOrder
+    {
+        SortOrder_Ascending = 0,
+        SortOrder_Descending
+    };
+} // namespace glu
+
+#endif // GLU_RADIX_SORT_COMMON_HPP
+
+
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Every thread writes NUM_ITEMS consecutive elements of the output. Its first element lies on a diagonal of
+        /// the merge path (the grid of the elements of A by those of B), whose crossing point is found by a binary
+        /// search: how many elements of A and B precede it. The NUM_ITEMS elements are then merged sequentially.
+        inline const char* k_merge_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer AKeyBuffer
+{
+    KEY_TYPE b_a_key_buffer[];
+};
+
+layout(std430, binding = 1) readonly buffer BKeyBuffer
+{
+    KEY_TYPE b_b_key_buffer[];
+};
+
+layout(std430, binding = 2) writeonly buffer DstKeyBuffer
+{
+    KEY_TYPE b_dst_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 3) readonly buffer AValBuffer
+{
+    uint b_a_val_buffer[];
+};
+
+layout(std430, binding = 4) readonly buffer BValBuffer
+{
+    uint b_b_val_buffer[];
+};
+
+layout(std430, binding = 5) writeonly buffer DstValBuffer
+{
+    uint b_dst_val_buffer[];
+};
+#endif
+
+layout(location = 0) uniform uint u_a_count;
+layout(location = 1) uniform uint u_b_count;
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint thread_i = workgroup_i * NUM_THREADS + gl_LocalInvocationIndex;
+
+    uint count = u_a_count + u_b_count;
+    uint diagonal = thread_i * NUM_ITEMS;
+    if (diagonal >= count) return;
+
+    // The number of elements of A preceding the diagonal
+    uint lo = diagonal > u_b_count ? diagonal - u_b_count : 0;
+    uint hi = min(diagonal, u_a_count);
+    while (lo < hi)
+    {
+        uint mid = (lo + hi) / 2;
+        if (precedes(b_b_key_buffer[diagonal - 1 - mid], b_a_key_buffer[mid])) hi = mid;
+        else lo = mid + 1;
+    }
+
+    uint a_i = lo;
+    uint b_i = diagonal - lo;
+
+    uint end_i = min(diagonal + NUM_ITEMS, count);
+    for (uint i = diagonal; i < end_i; i++)
+    {
+        // Keys of A are placed before the equal keys of B (stable merge)
+        bool from_a = b_i >= u_b_count ||
+                      (a_i < u_a_count && !precedes(b_b_key_buffer[b_i], b_a_key_buffer[a_i]));
+        if (from_a)
+        {
+            b_dst_key_buffer[i] = b_a_key_buffer[a_i];
+#ifdef WITH_VALUES
+            b_dst_val_buffer[i] = b_a_val_buffer[a_i];
+#endif
+            a_i++;
+        }
+        else
+        {
+            b_dst_key_buffer[i] = b_b_key_buffer[b_i];
+#ifdef WITH_VALUES
+            b_dst_val_buffer[i] = b_b_val_buffer[b_i];
+#endif
+            b_i++;
+        }
+    }
+}
+)";
+    } // namespace detail
+
+    /// A class that merges two buffers of keys (and values) sorted in the same order into a sorted buffer, with
+    /// merge-path partitioning: every thread finds by a binary search where its part of the output starts in both
+    /// inputs, so that all the threads merge independently. The merge is stable: keys of A are placed before the equal
+    /// keys of B. Keys are compared the way RadixSort orders them.
+    class Merge
+    {
+    private:
+        const size_t m_num_threads;
+
+        /// The number of elements written by every thread.
+        const size_t m_num_items;
+
+        /// The type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or DataType_Double.
+        const DataType m_key_data_type;
+
+        const SortOrder m_order;
+
+        Program m_program;
+        Program m_key_only_program;
+
+    public:
+        /// @param key_data_type the type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or
+        ///                      DataType_Double
+        /// @param order the order both inputs are sorted in
+        explicit Merge(DataType key_data_type = DataType_Uint, SortOrder order = SortOrder_Ascending) :
+            m_num_threads(256),
+            m_num_items(8),
+            m_key_data_type(key_data_type),
+            m_order(order)
+        {
+            GLU_CHECK_ARGUMENT(
+                m_key_data_type == DataType_Uint || m_key_data_type == DataType_Int ||
+                    m_key_data_type == DataType_Float || m_key_data_type == DataType_UVec2 ||
+                    m_key_data_type == DataType_Double,
+                "Invalid key data type: %d",
+                m_key_data_type
+            );
+
+            size_t key_size = get_data_type_size(m_key_data_type);
+
+            std::string shader_src = "#version 460\n\n";
+            shader_src += "#define NUM_THREADS " + std::to_string(m_num_threads) + "\n";
+            shader_src += "#define NUM_ITEMS " + std::to_string(m_num_items) + "\n";
+            shader_src += std::string("#define KEY_TYPE ") + (key_size == 8 ? "uvec2" : "uint") + "\n";
+            shader_src += "#define KEY_NUM_BITS " + std::to_string(key_size * 8) + "\n";
+            if (m_key_data_type == DataType_Int)
+                shader_src += "#define SIGNED_KEYS\n";
+            else if (m_key_data_type == DataType_Float || m_key_data_type == DataType_Double)
+                shader_src += "#define FLOAT_KEYS\n";
+            if (m_key_data_type != DataType_Uint && m_key_data_type != DataType_UVec2)
+                shader_src += "#define TRANSFORM_KEYS\n";
+            if (m_order == SortOrder_Descending)
+                shader_src += "#define DESCENDING\n";
+            shader_src += detail::k_radix_sort_common_shader;
+
+            build_program(m_program, shader_src + "#define WITH_VALUES\n" + detail::k_merge_shader);
+            build_program(m_key_only_program, shader_src + detail::k_merge_shader);
+        }
+
+        ~Merge() = default;
+
+        [[nodiscard]] DataType key_data_type() const { return m_key_data_type; }
+        [[nodiscard]] SortOrder order() const { return m_order; }
+
+        /// Merges A and B into dst, which can't be either of them.
+        ///
+        /// @param a_key_buffer the sorted keys of A
+        /// @param a_val_buffer the GLuint values of A, or 0 to merge the keys only
+        /// @param a_count the number of keys of A
+        /// @param b_key_buffer the sorted keys of B
+        /// @param b_val_buffer the GLuint values of B, or 0 to merge the keys only
+        /// @param b_count the number of keys of B
+        /// @param dst_key_buffer where the a_count + b_count merged keys are written
+        /// @param dst_val_buffer where the merged values are written, or 0 to merge the keys only
+        void operator()(
+            GLuint a_key_buffer,
+            GLuint a_val_buffer,
+            size_t a_count,
+            GLuint b_key_buffer,
+            GLuint b_val_buffer,
+            size_t b_count,
+            GLuint dst_key_buffer,
+            GLuint dst_val_buffer
+        )
+        {
+            GLU_CHECK_ARGUMENT(a_key_buffer, "Invalid A key buffer");
+            GLU_CHECK_ARGUMENT(b_key_buffer, "Invalid B key buffer");
+            GLU_CHECK_ARGUMENT(dst_key_buffer, "Invalid dst key buffer");
+            GLU_CHECK_ARGUMENT(
+                dst_key_buffer != a_key_buffer && dst_key_buffer != b_key_buffer,
+                "Dst key buffer must differ from the inputs"
+            );
+
+            bool with_values = dst_val_buffer != 0;
+            GLU_CHECK_ARGUMENT(
+                with_values == (a_val_buffer != 0) && with_values == (b_val_buffer != 0),
+                "Either all the value buffers or none must be given"
+            );
+
+            size_t count = a_count + b_count;
+            if (count == 0)
+                return;
+
+            Program& program = with_values ? m_program : m_key_only_program;
+            program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, a_key_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, b_key_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, dst_key_buffer);
+            if (with_values)
+            {
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, a_val_buffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, b_val_buffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, dst_val_buffer);
+            }
+
+            glUniform1ui(program.get_uniform_location("u_a_count"), a_count);
+            glUniform1ui(program.get_uniform_location("u_b_count"), b_count);
+
+            // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(div_ceil(count, m_num_items), m_num_threads);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+    private:
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_MERGE_HPP
+
+
+#ifndef GLU_REDUCE_HPP
+#define GLU_REDUCE_HPP
+
+#include <algorithm>
+
+#ifndef GLU_DATA_TYPES_HPP
+#define GLU_DATA_TYPES_HPP
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    enum DataType
+    {
+        DataType_Float = 0,
+        DataType_Double,
+        DataType_Int,
+        DataType_Uint,
+        DataType_Vec2,
+        DataType_Vec4,
+        DataType_DVec2,
+        DataType_DVec4,
+        DataType_UVec2,
+        DataType_UVec4,
+        DataType_IVec2,
+        DataType_IVec4
+    };
+
+    inline const char* to_glsl_type_str(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return "float";
+        else if (data_type == DataType_Double) return "double";
+        else if (data_type == DataType_Int)    return "int";
+        else if (data_type == DataType_Uint)   return "uint";
+        else if (data_type == DataType_Vec2)   return "vec2";
+        else if (data_type == DataType_Vec4)   return "vec4";
+        else if (data_type == DataType_DVec2)  return "dvec2";
+        else if (data_type == DataType_DVec4)  return "dvec4";
+        else if (data_type == DataType_UVec2)  return "uvec2";
+        else if (data_type == DataType_UVec4)  return "uvec4";
+        else if (data_type == DataType_IVec2)  return "ivec2";
+        else if (data_type == DataType_IVec4)  return "ivec4";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+
+    /// Gets the GLSL type of the components of the given data type (the type itself for scalars).
+    inline const char* to_glsl_component_type_str(DataType data_type)
+    {
+        if (data_type == DataType_Float || data_type == DataType_Vec2 || data_type == DataType_Vec4)
+            return "float";
+        else if (data_type == DataType_Double || data_type == DataType_DVec2 || data_type == DataType_DVec4)
+            return "double";
+        else if (data_type == DataType_Int || data_type == DataType_IVec2 || data_type == DataType_IVec4)
+            return "int";
+        else if (data_type == DataType_Uint || data_type == DataType_UVec2 || data_type == DataType_UVec4)
+            return "uint";
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+    }
+
+    /// Checks whether the given data type is made of (signed or unsigned) integers.
+    inline bool is_integer_data_type(DataType data_type)
+    {
+        return data_type == DataType_Int || data_type == DataType_Uint || data_type == DataType_UVec2 ||
+               data_type == DataType_UVec4 || data_type == DataType_IVec2 || data_type == DataType_IVec4;
+    }
+
+    /// Gets the size in bytes of a value of the given data type (as laid out in a std430 array).
+    inline size_t get_data_type_size(DataType data_type)
+    {
+        // clang-format off
+        if (data_type == DataType_Float)       return 4;
+        else if (data_type == DataType_Double) return 8;
+        else if (data_type == DataType_Int)    return 4;
+        else if (data_type == DataType_Uint)   return 4;
+        else if (data_type == DataType_Vec2)   return 8;
+        else if (data_type == DataType_Vec4)   return 16;
+        else if (data_type == DataType_DVec2)  return 16;
+        else if (data_type == DataType_DVec4)  return 32;
+        else if (data_type == DataType_UVec2)  return 8;
+        else if (data_type == DataType_UVec4)  return 16;
+        else if (data_type == DataType_IVec2)  return 8;
+        else if (data_type == DataType_IVec4)  return 16;
+        else
+        {
+            GLU_FAIL("Invalid data type: %d", data_type);
+        }
+        // clang-format on
+    }
+} // namespace glu
+
+#endif // GLU_DATA_TYPES_HPP
+
+
+#ifndef GLU_GL_UTILS_HPP
+#define GLU_GL_UTILS_HPP
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    inline void
+    copy_buffer(GLuint src_buffer, GLuint dst_buffer, size_t size, size_t src_offset = 0, size_t dst_offset = 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, src_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, dst_buffer);
+
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr) src_offset, (GLintptr) dst_offset, (GLsizeiptr) size
+        );
+    }
+
+    /// A RAII wrapper for GL shader.
+    class Shader
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Shader(GLenum type) :
+            m_handle(glCreateShader(type)){};
+        Shader(const Shader&) = delete;
+
+        Shader(Shader&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Shader() { glDeleteShader(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void source_from_str(const std::string& src_str)
+        {
+            const char* src_ptr = src_str.c_str();
+            glShaderSource(m_handle, 1, &src_ptr, nullptr);
+        }
+
+        void source_from_file(const char* src_filepath)
+        {
+            FILE* file = fopen(src_filepath, "rt");
+            GLU_CHECK_STATE(!file, "Failed to shader file: %s", src_filepath);
+
+            fseek(file, 0, SEEK_END);
+            size_t file_size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+
+            std::string src{};
+            src.resize(file_size);
+            fread(src.data(), sizeof(char), file_size, file);
+            source_from_str(src.c_str());
+
+            fclose(file);
+        }
+
+        std::string get_info_log()
+        {
+            GLint log_length = 0;
+            glGetShaderiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetShaderInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void compile()
+        {
+            glCompileShader(m_handle);
+
+            GLint status;
+            glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Shader failed to compile: %s", get_info_log().c_str());
+            }
+        }
+    };
+
+    /// A RAII wrapper for GL program.
+    class Program
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Program() { m_handle = glCreateProgram(); };
+        Program(const Program&) = delete;
+
+        Program(Program&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Program() { glDeleteProgram(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void attach_shader(GLuint shader_handle) { glAttachShader(m_handle, shader_handle); }
+        void attach_shader(const Shader& shader) { glAttachShader(m_handle, shader.handle()); }
+
+        [[nodiscard]] std::string get_info_log() const
+        {
+            GLint log_length = 0;
+            glGetProgramiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetProgramInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void link()
+        {
+            GLint status;
+            glLinkProgram(m_handle);
+            glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Program failed to link: %s", get_info_log().c_str());
+            }
+        }
+
+        void use() { glUseProgram(m_handle); }
+
+        GLint get_uniform_location(const char* uniform_name)
+        {
+            GLint loc = glGetUniformLocation(m_handle, uniform_name);
+            GLU_CHECK_STATE(loc >= 0, "Failed to get uniform location: %s", uniform_name);
+            return loc;
+        }
+    };
+
+    /// A RAII helper class for GL shader storage buffer.
+    class ShaderStorageBuffer
+    {
+    private:
+        GLuint m_handle = 0;
+        size_t m_size = 0;
+
+    public:
+        explicit ShaderStorageBuffer(size_t initial_size = 0)
+        {
+            if (initial_size > 0)
+                resize(initial_size, false);
+        }
+
+        explicit ShaderStorageBuffer(const void* data, size_t size) :
+            m_size(size)
+        {
+            GLU_CHECK_ARGUMENT(data, "");
+            GLU_CHECK_ARGUMENT(size > 0, "");
+
+            glCreateBuffers(1, &m_handle);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, data, GL_DYNAMIC_STORAGE_BIT);
+        }
+
+        template<typename T>
+        explicit ShaderStorageBuffer(const std::vector<T>& data) :
+            ShaderStorageBuffer(data.data(), data.size() * sizeof(T))
+        {
+        }
+
+        ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+        ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            m_size = other.m_size;
+            other.m_handle = 0;
+        }
+
+        ~ShaderStorageBuffer()
+        {
+            if (m_handle)
+                glDeleteBuffers(1, &m_handle);
+        }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        /// Grows or shrinks the buffer. If keep_data, performs an additional copy to maintain the data.
+        void resize(size_t size, bool keep_data = false)
+        {
+            size_t old_size = m_size;
+            GLuint old_handle = m_handle;
+
+            if (old_size != size)
+            {
+                m_size = size;
+
+                glCreateBuffers(1, &m_handle);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+                glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+                if (keep_data)
+                    copy_buffer(old_handle, m_handle, std::min(old_size, size));
+
+                glDeleteBuffers(1, &old_handle);
+            }
+        }
+
+        /// Clears the entire buffer with the given GLuint value (repeated).
+        void clear(GLuint value)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED, GL_UNSIGNED_INT, &value);
+        }
+
+        void write_data(const void* data, size_t size)
+        {
+            GLU_CHECK_ARGUMENT(size <= m_size, "");
+
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+        }
+
+        template<typename T>
+        std::vector<T> get_data() const
+        {
+            GLU_CHECK_ARGUMENT(m_size % sizeof(T) == 0, "Size %zu isn't a multiple of %zu", m_size, sizeof(T));
+
+            std::vector<T> result(m_size / sizeof(T));
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) m_size, result.data());
+            return result;
+        }
+
+        void bind(GLuint index, size_t size = 0, size_t offset = 0)
+        {
+            if (size == 0)
+                size = m_size;
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, m_handle, (GLintptr) offset, (GLsizeiptr) size);
+        }
+    };
+
+    /// Measures elapsed time on GPU for executing the given callback.
+    inline uint64_t measure_gl_elapsed_time(const std::function<void()>& callback)
+    {
+        GLuint query;
+        uint64_t elapsed_time{};
+
+        glGenQueries(1, &query);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        callback();
+
+        glEndQuery(GL_TIME_ELAPSED);
+
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
+        glDeleteQueries(1, &query);
+
+        return elapsed_time;
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_floor(IntegerT n)
+    {
+        return (IntegerT) floor(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_ceil(IntegerT n)
+    {
+        return (IntegerT) ceil(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT div_ceil(IntegerT n, IntegerT d)
+    {
+        return (IntegerT) ceil(double(n) / double(d));
+    }
+
+    template<typename T>
+    bool is_power_of_2(T n)
+    {
+        return (n & (n - 1)) == 0;
+    }
+
+    template<typename IntegerT>
+    IntegerT next_power_of_2(IntegerT n)
+    {
+        n--;
+        n |= n >> 1;
+        n |= n >> 2;
+        n |= n >> 4;
+        n |= n >> 8;
+        n |= n >> 16;
+        n++;
+        return n;
+    }
+
+    template<typename Iterator>
+    void print_stl_container(Iterator begin, Iterator end)
+    {
+        size_t i = 0;
+        for (; begin != end; begin++)
+        {
+            printf("(%zu) %s, ", i, std::to_string(*begin).c_str());
+            i++;
+        }
+        printf("\n");
+    }
+
+    template<typename T>
+    void print_buffer(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<T> data = buffer.get_data<T>();
+        print_stl_container(data.begin(), data.end());
+    }
+
+    inline void print_buffer_hex(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<GLuint> data = buffer.get_data<GLuint>();
+        for (size_t i = 0; i < data.size(); i++)
+            printf("(%zu) %08x, ", i, data[i]);
+        printf("\n");
+    }
+} // namespace glu
+
+#endif // GLU_GL_UTILS_HPP
+
+
+
+namespace glu
+{
+    namespace detail
+    {
+        inline const char* k_reduction_shader_src = R"(
+#extension GL_KHR_shader_subgroup_arithmetic : require
+
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer Buffer
+{
+    DATA_TYPE data[];
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_depth;
+
+void main()
+{
+    uint step = 1 << (5 * u_depth);
+    uint subgroup_i = gl_WorkGroupID.x * NUM_THREADS + gl_SubgroupID * gl_SubgroupSize;
+    uint i = (subgroup_i + gl_SubgroupInvocationID) * step;
+    if (i < u_count)
+    {
+        DATA_TYPE r = SUBGROUP_OPERATION(data[i]);
+        if (gl_SubgroupInvocationID == 0)
+        {
+            data[i] = r;
+        }
+    }
+}
+)";
+
+        /// Every workgroup reduces a tile of NUM_THREADS * NUM_ITEMS elements of the source (read from u_src_offset) to
+        /// an element of the destination (written at u_dst_offset + its index). No identity is needed: the threads
+        /// past the count sit out the subgroup operations, which only combine the active invocations.
+        inline const char* k_reduction_to_buffer_shader_src = R"(
+#extension GL_KHR_shader_subgroup_arithmetic : require
+
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer SrcBuffer
+{
+    DATA_TYPE b_src_buffer[];
+};
+
+layout(std430, binding = 1) writeonly buffer DstBuffer
+{
+    DATA_TYPE b_dst_buffer[];
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_src_offset;
+layout(location = 2) uniform uint u_dst_offset;
+
+shared DATA_TYPE s_subgroup_buffer[MAX_NUM_SUBGROUPS];
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint tile_i = workgroup_i * NUM_THREADS * NUM_ITEMS;
+    if (tile_i >= u_count) return;
+
+    // The threads holding an element are the first ones of the workgroup, filling its first subgroups
+    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+    uint i = tile_i + thread_i;
+    if (i < u_count)
+    {
+        DATA_TYPE value = b_src_buffer[u_src_offset + i];
+        for (uint item_i = 1; item_i < NUM_ITEMS; item_i++)
+        {
+            uint j = i + item_i * NUM_THREADS;
+            if (j < u_count) value = OPERATOR(value, b_src_buffer[u_src_offset + j]);
+        }
+
+        DATA_TYPE r = SUBGROUP_OPERATION(value);
+        if (subgroupElect()) s_subgroup_buffer[gl_SubgroupID] = r;
+    }
+
+    barrier();
+
+    uint num_subgroups = (min(u_count - tile_i, NUM_THREADS) + gl_SubgroupSize - 1) / gl_SubgroupSize;
+    if (gl_SubgroupID == 0 && gl_SubgroupInvocationID < num_subgroups)
+    {
+        DATA_TYPE value = s_subgroup_buffer[gl_SubgroupInvocationID];
+        for (uint j = gl_SubgroupInvocationID + gl_SubgroupSize; j < num_subgroups; j += gl_SubgroupSize)
+            value = OPERATOR(value, s_subgroup_buffer[j]);
+
+        DATA_TYPE r = SUBGROUP_OPERATION(value);
+        if (subgroupElect()) b_dst_buffer[u_dst_offset + workgroup_i] = r;
+    }
+}
+)";
+    }
+
+    /// The operators that can be used for the reduction operation.
+    enum ReduceOperator
+    {
+        ReduceOperator_Sum = 0,
+        ReduceOperator_Mul,
+        ReduceOperator_Min,
+        ReduceOperator_Max,
+        ReduceOperator_Or ///< Bitwise OR, only for integer data types
+    };
+
+    /// A class that implements the reduction operation.
+    class Reduce
+    {
+    private:
+        const DataType m_data_type;
+        const ReduceOperator m_operator;
+        const size_t m_num_threads;
+        const size_t m_num_items;
+
+        Program m_program;
+        Program m_to_buffer_program;
+
+        /// The partial results of the levels of a reduction to a buffer, but the last one: an element per tile.
+        ShaderStorageBuffer m_scratch_buffer;
+
+    public:
+        explicit Reduce(DataType data_type, ReduceOperator operator_) :
+            m_data_type(data_type),
+            m_operator(operator_),
+            m_num_threads(1024),
+            m_num_items(4)
+        {
+            GLint subgroup_size = 0;
+            glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &subgroup_size);
+            GLU_CHECK_STATE(
+                subgroup_size > 0 && m_num_threads % subgroup_size == 0, "Unsupported subgroup size: %d", subgroup_size
+            );
+
+            std::string shader_src = "#version 460\n\n";
+
+            shader_src += std::string("#define DATA_TYPE ") + to_glsl_type_str(m_data_type) + "\n";
+            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
+            shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
+
+            if (m_operator == ReduceOperator_Sum)
+            {
+                shader_src += "#define OPERATOR(a, b) (a + b)\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupAdd(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Mul)
+            {
+                shader_src += "#define OPERATOR(a, b) (a * b)\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMul(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Min)
+            {
+                shader_src += "#define OPERATOR(a, b) (min(a, b))\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMin(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Max)
+            {
+                shader_src += "#define OPERATOR(a, b) (max(a, b))\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupMax(value)\n";
+            }
+            else if (m_operator == ReduceOperator_Or)
+            {
+                GLU_CHECK_ARGUMENT(is_integer_data_type(m_data_type), "OR requires an integer data type");
+
+                shader_src += "#define OPERATOR(a, b) (a | b)\n";
+                shader_src += "#define SUBGROUP_OPERATION(value) subgroupOr(value)\n";
+            }
+            else
+            {
+                GLU_FAIL("Invalid reduction operator: %d", m_operator);
+            }
+
+            shader_src += "#define MAX_NUM_SUBGROUPS " + std::to_string(m_num_threads / subgroup_size) + "\n";
+
+            build_program(m_program, shader_src + detail::k_reduction_shader_src);
+            build_program(m_to_buffer_program, shader_src + detail::k_reduction_to_buffer_shader_src);
+        }
+
+        ~Reduce() = default;
+
+        /// Reduces the buffer in place: the result is written to its first element, the others are overwritten.
+        void operator()(GLuint buffer, size_t count)
+        {
+            GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
+            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
+
+            m_program.use();
+
+            glUniform1ui(m_program.get_uniform_location("u_count"), count);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+
+            for (int depth = 0;; depth++)
+            {
+                int step = 1 << (5 * depth);
+                if (step >= count)
+                    break;
+
+                size_t level_count = count >> (5 * depth);
+
+                glUniform1ui(m_program.get_uniform_location("u_depth"), depth);
+
+                size_t num_workgroups = div_ceil(level_count, m_num_threads);
+                glDispatchCompute(num_workgroups, 1, 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            }
+        }
+
+        /// Reduces a range of the input buffer, left untouched, and writes the result to an element of the result
+        /// buffer. Every level reduces tiles of m_num_threads * m_num_items elements to an element of the internal
+        /// scratch buffer, until a single tile remains, whose result is written straight to the result buffer.
+        ///
+        /// @param input_buffer the input buffer (of the data type), only read
+        /// @param offset the index of the first element to reduce
+        /// @param count the number of elements to reduce (offset + count up to 2^31)
+        /// @param result_buffer the buffer the result is written to; it can be the input buffer, outside of the range
+        /// @param result_offset the index of the element of the result buffer the result is written to
+        void operator()(GLuint input_buffer, size_t offset, size_t count, GLuint result_buffer, size_t result_offset)
+        {
+            GLU_CHECK_ARGUMENT(input_buffer, "Invalid input buffer");
+            GLU_CHECK_ARGUMENT(result_buffer, "Invalid result buffer");
+            GLU_CHECK_ARGUMENT(count > 0, "Count must be greater than zero");
+            GLU_CHECK_ARGUMENT(offset + count <= (size_t(1) << 31), "The range must end within 2^31 elements");
+            GLU_CHECK_ARGUMENT(result_offset < (size_t(1) << 31), "Result offset must be less than 2^31");
+
+            size_t tile_size = m_num_threads * m_num_items;
+
+            // Every level but the last one writes its results after those of the previous level
+            size_t required_count = 0;
+            for (size_t level_count = div_ceil(count, tile_size); level_count > 1;
+                 level_count = div_ceil(level_count, tile_size))
+                required_count += level_count;
+
+            size_t required_size = required_count * get_data_type_size(m_data_type);
+            if (m_scratch_buffer.size() < required_size)
+                m_scratch_buffer.resize(required_size, false);
+
+            m_to_buffer_program.use();
+
+            GLuint src_buffer = input_buffer;
+            size_t src_offset = offset;
+            size_t level_count = count;
+            size_t scratch_offset = 0;
+            while (true)
+            {
+                size_t num_workgroups = div_ceil(level_count, tile_size);
+                bool last_level = num_workgroups == 1;
+
+                GLuint dst_buffer = last_level ? result_buffer : m_scratch_buffer.handle();
+                size_t dst_offset = last_level ? result_offset : scratch_offset;
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src_buffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, dst_buffer);
+
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_count"), level_count);
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_src_offset"), src_offset);
+                glUniform1ui(m_to_buffer_program.get_uniform_location("u_dst_offset"), dst_offset);
+
+                // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+                size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+                glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+                if (last_level)
+                    break;
+
+                src_buffer = m_scratch_buffer.handle();
+                src_offset = scratch_offset;
+                level_count = num_workgroups;
+                scratch_offset += num_workgroups;
+            }
+        }
+
+    private:
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_REDUCE_HPP
+
+
+#ifndef GLU_GL_UTILS_HPP
+#define GLU_GL_UTILS_HPP
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef GLU_ERRORS_HPP
+#define GLU_ERRORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// TODO mark if (!condition_) as unlikely
+#define GLU_CHECK_STATE(condition_, ...)                                                                                   \
+    {                                                                                                                  \
+        if (!(condition_))                                                                                             \
+        {                                                                                                              \
+            fprintf(stderr, __VA_ARGS__);                                                                              \
+            exit(1);                                                                                                   \
+        }                                                                                                              \
+    }
+
+#define GLU_CHECK_ARGUMENT(condition_, ...) GLU_CHECK_STATE(condition_, __VA_ARGS__)
+#define GLU_FAIL(...) GLU_CHECK_STATE(false, __VA_ARGS__)
+
+#endif
+
+
+
+namespace glu
+{
+    inline void
+    copy_buffer(GLuint src_buffer, GLuint dst_buffer, size_t size, size_t src_offset = 0, size_t dst_offset = 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, src_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, dst_buffer);
+
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr) src_offset, (GLintptr) dst_offset, (GLsizeiptr) size
+        );
+    }
+
+    /// A RAII wrapper for GL shader.
+    class Shader
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Shader(GLenum type) :
+            m_handle(glCreateShader(type)){};
+        Shader(const Shader&) = delete;
+
+        Shader(Shader&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Shader() { glDeleteShader(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void source_from_str(const std::string& src_str)
+        {
+            const char* src_ptr = src_str.c_str();
+            glShaderSource(m_handle, 1, &src_ptr, nullptr);
+        }
+
+        void source_from_file(const char* src_filepath)
+        {
+            FILE* file = fopen(src_filepath, "rt");
+            GLU_CHECK_STATE(!file, "Failed to shader file: %s", src_filepath);
+
+            fseek(file, 0, SEEK_END);
+            size_t file_size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+
+            std::string src{};
+            src.resize(file_size);
+            fread(src.data(), sizeof(char), file_size, file);
+            source_from_str(src.c_str());
+
+            fclose(file);
+        }
+
+        std::string get_info_log()
+        {
+            GLint log_length = 0;
+            glGetShaderiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetShaderInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void compile()
+        {
+            glCompileShader(m_handle);
+
+            GLint status;
+            glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Shader failed to compile: %s", get_info_log().c_str());
+            }
+        }
+    };
+
+    /// A RAII wrapper for GL program.
+    class Program
+    {
+    private:
+        GLuint m_handle;
+
+    public:
+        explicit Program() { m_handle = glCreateProgram(); };
+        Program(const Program&) = delete;
+
+        Program(Program&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            other.m_handle = 0;
+        }
+
+        ~Program() { glDeleteProgram(m_handle); }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+
+        void attach_shader(GLuint shader_handle) { glAttachShader(m_handle, shader_handle); }
+        void attach_shader(const Shader& shader) { glAttachShader(m_handle, shader.handle()); }
+
+        [[nodiscard]] std::string get_info_log() const
+        {
+            GLint log_length = 0;
+            glGetProgramiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+
+            std::vector<GLchar> log(log_length);
+            glGetProgramInfoLog(m_handle, log_length, nullptr, log.data());
+            return {log.begin(), log.end()};
+        }
+
+        void link()
+        {
+            GLint status;
+            glLinkProgram(m_handle);
+            glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+            if (!status)
+            {
+                GLU_CHECK_STATE(status, "Program failed to link: %s", get_info_log().c_str());
+            }
+        }
+
+        void use() { glUseProgram(m_handle); }
+
+        GLint get_uniform_location(const char* uniform_name)
+        {
+            GLint loc = glGetUniformLocation(m_handle, uniform_name);
+            GLU_CHECK_STATE(loc >= 0, "Failed to get uniform location: %s", uniform_name);
+            return loc;
+        }
+    };
+
+    /// A RAII helper class for GL shader storage buffer.
+    class ShaderStorageBuffer
+    {
+    private:
+        GLuint m_handle = 0;
+        size_t m_size = 0;
+
+    public:
+        explicit ShaderStorageBuffer(size_t initial_size = 0)
+        {
+            if (initial_size > 0)
+                resize(initial_size, false);
+        }
+
+        explicit ShaderStorageBuffer(const void* data, size_t size) :
+            m_size(size)
+        {
+            GLU_CHECK_ARGUMENT(data, "");
+            GLU_CHECK_ARGUMENT(size > 0, "");
+
+            glCreateBuffers(1, &m_handle);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, data, GL_DYNAMIC_STORAGE_BIT);
+        }
+
+        template<typename T>
+        explicit ShaderStorageBuffer(const std::vector<T>& data) :
+            ShaderStorageBuffer(data.data(), data.size() * sizeof(T))
+        {
+        }
+
+        ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+        ShaderStorageBuffer(ShaderStorageBuffer&& other) noexcept
+        {
+            m_handle = other.m_handle;
+            m_size = other.m_size;
+            other.m_handle = 0;
+        }
+
+        ~ShaderStorageBuffer()
+        {
+            if (m_handle)
+                glDeleteBuffers(1, &m_handle);
+        }
+
+        [[nodiscard]] GLuint handle() const { return m_handle; }
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        /// Grows or shrinks the buffer. If keep_data, performs an additional copy to maintain the data.
+        void resize(size_t size, bool keep_data = false)
+        {
+            size_t old_size = m_size;
+            GLuint old_handle = m_handle;
+
+            if (old_size != size)
+            {
+                m_size = size;
+
+                glCreateBuffers(1, &m_handle);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+                glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) m_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+                if (keep_data)
+                    copy_buffer(old_handle, m_handle, std::min(old_size, size));
+
+                glDeleteBuffers(1, &old_handle);
+            }
+        }
+
+        /// Clears the entire buffer with the given GLuint value (repeated).
+        void clear(GLuint value)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED, GL_UNSIGNED_INT, &value);
+        }
+
+        void write_data(const void* data, size_t size)
+        {
+            GLU_CHECK_ARGUMENT(size <= m_size, "");
+
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+        }
+
+        template<typename T>
+        std::vector<T> get_data() const
+        {
+            GLU_CHECK_ARGUMENT(m_size % sizeof(T) == 0, "Size %zu isn't a multiple of %zu", m_size, sizeof(T));
+
+            std::vector<T> result(m_size / sizeof(T));
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr) m_size, result.data());
+            return result;
+        }
+
+        void bind(GLuint index, size_t size = 0, size_t offset = 0)
+        {
+            if (size == 0)
+                size = m_size;
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, m_handle, (GLintptr) offset, (GLsizeiptr) size);
+        }
+    };
+
+    /// Measures elapsed time on GPU for executing the given callback.
+    inline uint64_t measure_gl_elapsed_time(const std::function<void()>& callback)
+    {
+        GLuint query;
+        uint64_t elapsed_time{};
+
+        glGenQueries(1, &query);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        callback();
+
+        glEndQuery(GL_TIME_ELAPSED);
+
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
+        glDeleteQueries(1, &query);
+
+        return elapsed_time;
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_floor(IntegerT n)
+    {
+        return (IntegerT) floor(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT log32_ceil(IntegerT n)
+    {
+        return (IntegerT) ceil(double(log2(n)) / 5.0);
+    }
+
+    template<typename IntegerT>
+    IntegerT div_ceil(IntegerT n, IntegerT d)
+    {
+        return (IntegerT) ceil(double(n) / double(d));
+    }
+
+    template<typename T>
+    bool is_power_of_2(T n)
+    {
+        return (n & (n - 1)) == 0;
+    }
+
+    template<typename IntegerT>
+    IntegerT next_power_of_2(IntegerT n)
+    {
+        n--;
+        n |= n >> 1;
+        n |= n >> 2;
+        n |= n >> 4;
+        n |= n >> 8;
+        n |= n >> 16;
+        n++;
+        return n;
+    }
+
+    template<typename Iterator>
+    void print_stl_container(Iterator begin, Iterator end)
+    {
+        size_t i = 0;
+        for (; begin != end; begin++)
+        {
+            printf("(%zu) %s, ", i, std::to_string(*begin).c_str());
+            i++;
+        }
+        printf("\n");
+    }
+
+    template<typename T>
+    void print_buffer(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<T> data = buffer.get_data<T>();
+        print_stl_container(data.begin(), data.end());
+    }
+
+    inline void print_buffer_hex(const ShaderStorageBuffer& buffer)
+    {
+        std::vector<GLuint> data = buffer.get_data<GLuint>();
+        for (size_t i = 0; i < data.size(); i++)
+            printf("(%zu) %08x, ", i, data[i]);
+        printf("\n");
+    }
+} // namespace glu
+
+#endif // GLU_GL_UTILS_HPP
+
+
+#ifndef GLU_RADIX_SORT_COMMON_HPP
+#define GLU_RADIX_SORT_COMMON_HPP
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Code shared by all the RadixSort shaders. Keys are either uint (32 bits) or uvec2 (64 bits, low bits in x).
+        ///
+        /// Signed and floating-point keys are sorted as unsigned integers after an order-preserving bit transform:
+        /// the sign bit of integers is flipped; the sign bit of positive floats is flipped, and all the bits of
+        /// negative floats. NaNs are cleared of their sign so that they're always placed after +inf.
+        inline const char* k_radix_sort_common_shader = R"(
+#if defined(FLOAT_KEYS) && KEY_NUM_BITS == 64
+const uvec2 k_sign_mask = uvec2(0, 0x80000000u);
+
+bool is_nan(uvec2 key)
+{
+    uint hi = key.y & 0x7fffffffu;
+    return hi > 0x7ff00000u || (hi == 0x7ff00000u && key.x != 0);
+}
+
+uvec2 to_sortable_key(uvec2 key)
+{
+    if (is_nan(key)) key.y &= 0x7fffffffu;
+    return (key.y & 0x80000000u) != 0 ? ~key : key ^ k_sign_mask;
+}
+
+uvec2 from_sortable_key(uvec2 key)
+{
+    return (key.y & 0x80000000u) != 0 ? key ^ k_sign_mask : ~key;
+}
+#elif defined(FLOAT_KEYS)
+uint to_sortable_key(uint key)
+{
+    if ((key & 0x7fffffffu) > 0x7f800000u) key &= 0x7fffffffu; // NaN
+    return (key & 0x80000000u) != 0 ? ~key : key ^ 0x80000000u;
+}
+
+uint from_sortable_key(uint key)
+{
+    return (key & 0x80000000u) != 0 ? key ^ 0x80000000u : ~key;
+}
+#elif defined(SIGNED_KEYS)
+uint to_sortable_key(uint key) { return key ^ 0x80000000u; }
+uint from_sortable_key(uint key) { return key ^ 0x80000000u; }
+#endif
+
+/// Gets the digit of the key starting at the given bit; mask selects the digit bits.
+uint get_radix(KEY_TYPE key, uint shift, uint mask)
+{
+#if KEY_NUM_BITS == 64
+    uint bits = shift < 32 ? (key.x >> shift) : (key.y >> (shift - 32));
+    if (shift > 0 && shift < 32)
+    {
+        bits |= key.y << (32 - shift); // The digit may lie across the two halves (extra bits are masked)
+    }
+    return bits & mask;
+#else
+    return (key >> shift) & mask;
+#endif
+}
+
+/// Gets the digit the key is ranked by: in descending order digits are reversed, so that the largest comes first and
+/// keys with the same digit keep their order (the sort stays stable).
+uint get_key_radix(KEY_TYPE key, uint shift, uint mask)
+{
+#ifdef DESCENDING
+    return mask - get_radix(key, shift, mask);
+#else
+    return get_radix(key, shift, mask);
+#endif
+}
+
+/// Whether key1 is placed strictly before key2 by the sort (keys as stored, not transformed).
+bool precedes(KEY_TYPE key1, KEY_TYPE key2)
+{
+#ifdef TRANSFORM_KEYS
+    key1 = to_sortable_key(key1);
+    key2 = to_sortable_key(key2);
+#endif
+#ifdef DESCENDING
+    KEY_TYPE tmp = key1;
+    key1 = key2;
+    key2 = tmp;
+#endif
+#if KEY_NUM_BITS == 64
+    return key1.y < key2.y || (key1.y == key2.y && key1.x < key2.x);
+#else
+    return key1 < key2;
+#endif
+}
+)";
+    } // namespace detail
+
+    /// The order RadixSort sorts the keys in. Both orders are stable.
+    enum SortOrder
+    {
+        SortOrder_Ascending = 0,
+        SortOrder_Descending
+    };
+} // namespace glu
+
+#endif // GLU_RADIX_SORT_COMMON_HPP
+
+
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Counts the radixes of a block of NUM_THREADS keys. Every thread counts NUM_ITEMS keys read with uvec4 loads,
+        /// the counts are accumulated on shared memory and flushed to global memory once per block.
+        inline const char* k_radix_sort_counting_shader = R"(
+#define NUM_COUNTING_THREADS (NUM_THREADS / NUM_ITEMS)
+#define NUM_KEYS_PER_VEC (128 / KEY_NUM_BITS)
+
+layout(local_size_x = NUM_COUNTING_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+layout(std430, binding = 0) readonly buffer KeyVecBuffer
+{
+    uvec4 b_key_vec_buffer[]; // Same buffer, read NUM_KEYS_PER_VEC keys at a time
+};
+
+layout(std430, binding = 1) writeonly buffer BlockCountBuffer
+{
+    uint b_block_count_buffer[]; // RADIX_SIZE * num_blocks
+};
+
+layout(std430, binding = 2) buffer GlobalCountBuffer
+{
+    uint b_global_count_buffer[];
+};
+
+layout(std430, binding = 3) readonly buffer VaryingBitsBuffer
+{
+    KEY_TYPE b_varying_bits; // The bits that aren't the same for all keys
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_radix_shift;
+layout(location = 2) uniform uint u_num_blocks;
+#if defined(TRANSFORM_KEYS) || defined(EXTRACT_KEY)
+layout(location = 3) uniform bool u_first_step;
+#endif
+layout(location = 5) uniform uint u_radix_mask;
+
+shared uint s_count_buffer[RADIX_SIZE];
+
+void count_key(KEY_TYPE key)
+{
+#ifdef TRANSFORM_KEYS
+    if (u_first_step) key = to_sortable_key(key);
+#endif
+    atomicAdd(s_count_buffer[get_key_radix(key, u_radix_shift, u_radix_mask)], 1);
+}
+
+KEY_TYPE get_vec_key(uvec4 vec, uint j)
+{
+#if KEY_NUM_BITS == 64
+    return uvec2(vec[j * 2], vec[j * 2 + 1]);
+#else
+    return vec[j];
+#endif
+}
+
+void main()
+{
+    if (get_radix(b_varying_bits, u_radix_shift, u_radix_mask) == 0)
+    {
+        return; // Every key has the same digit, the step is skipped
+    }
+
+    for (uint radix = gl_LocalInvocationIndex; radix < RADIX_SIZE; radix += NUM_COUNTING_THREADS)
+    {
+        s_count_buffer[radix] = 0;
+    }
+
+    barrier();
+
+    // Block-wide count on shared memory; consecutive threads read consecutive vectors
+    uint block_vec_i = gl_WorkGroupID.x * (NUM_THREADS / NUM_KEYS_PER_VEC);
+    for (uint vec_j = gl_LocalInvocationIndex; vec_j < NUM_THREADS / NUM_KEYS_PER_VEC; vec_j += NUM_COUNTING_THREADS)
+    {
+        uint vec_i = block_vec_i + vec_j;
+        uint i = vec_i * NUM_KEYS_PER_VEC;
+#ifdef EXTRACT_KEY
+        if (u_first_step)
+        {
+            // The keys of the first step are computed from the records
+            for (uint j = 0; j < NUM_KEYS_PER_VEC && i + j < u_count; j++) count_key(extract_key(i + j));
+        }
+        else
+#endif
+        if (i + NUM_KEYS_PER_VEC <= u_count)
+        {
+            uvec4 vec = b_key_vec_buffer[vec_i];
+            for (uint j = 0; j < NUM_KEYS_PER_VEC; j++) count_key(get_vec_key(vec, j));
+        }
+        else
+        {
+            // Tail of the key buffer: a vector load could read out of bounds
+            for (uint j = 0; j < NUM_KEYS_PER_VEC && i + j < u_count; j++) count_key(b_key_buffer[i + j]);
+        }
+    }
+
+    barrier();
+
+    for (uint radix = gl_LocalInvocationIndex; radix < RADIX_SIZE; radix += NUM_COUNTING_THREADS)
+    {
+        uint block_count = s_count_buffer[radix];
+        b_block_count_buffer[radix * u_num_blocks + gl_WorkGroupID.x] = block_count;
+        if (block_count > 0) atomicAdd(b_global_count_buffer[radix], block_count);
+    }
+}
+)";
+
+        /// Ranks the keys of a block of NUM_THREADS keys by their radix.
+        inline const char* k_radix_sort_rank_shader = R"(
+shared uint s_block_count_buffer[RADIX_SIZE];
+shared uint s_local_offset_buffer[RADIX_SIZE]; // Where the keys of every radix begin once the block is sorted
+shared uint s_prefix_sum_buffer[NUM_THREADS];
+
+// The count (then the offset) of every radix within every subgroup, radix-major, two 16-bit values per element
+shared uint s_subgroup_count_buffer[RADIX_SIZE * MAX_NUM_SUBGROUPS / 2];
+
+void prefix_sum()  // Block-wide prefix sum (Blelloch scan)
+{
+    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+
+    // Upsweep
+    for (uint step = 1; step < NUM_THREADS; step <<= 1)
+    {
+        if (thread_i % 2 == 1)
+        {
+            uint i = thread_i * step + (step - 1);
+            if (i < NUM_THREADS)
+            {
+                s_prefix_sum_buffer[i] = s_prefix_sum_buffer[i] + s_prefix_sum_buffer[i - step];
+            }
+        }
+
+        barrier();
+    }
+
+    // Clear last
+    if (thread_i == NUM_THREADS - 1) s_prefix_sum_buffer[thread_i] = 0;
+
+    barrier();
+
+    // Downsweep
+    uint step = NUM_THREADS >> 1;
+    for (; step > 0; step >>= 1)
+    {
+        uint i = thread_i * step + (step - 1);
+        if (i + step < NUM_THREADS && thread_i % 2 == 0)
+        {
+            uint tmp = s_prefix_sum_buffer[i];
+            s_prefix_sum_buffer[i] = s_prefix_sum_buffer[i + step];
+            s_prefix_sum_buffer[i + step] = tmp + s_prefix_sum_buffer[i + step];
+        }
+
+        barrier();
+    }
+}
+
+uint get_subgroup_count(uint radix, uint subgroup_i)
+{
+    uint j = radix * MAX_NUM_SUBGROUPS + subgroup_i;
+    return (s_subgroup_count_buffer[j / 2] >> ((j % 2) * 16)) & 0xffff;
+}
+
+/// Computes the index of the key within the block once its keys are stably sorted by radix (invocations without key
+/// have to pass RADIX_SIZE). Also stores in s_block_count_buffer the number of keys of the block for every radix, and
+/// in s_local_offset_buffer where they begin.
+uint rank_key(uint thread_i, uint key_radix)
+{
+    for (uint j = thread_i; j < RADIX_SIZE * MAX_NUM_SUBGROUPS / 2; j += NUM_THREADS)
+    {
+        s_subgroup_count_buffer[j] = 0;
+    }
+
+    barrier();
+
+    // Match the invocations of the subgroup having the same radix, a ballot per bit (the bit NUM_BITS_PER_STEP is
+    // only set for invocations without key)
+    uvec4 match = subgroupBallot(true);
+    for (uint bit = 0; bit <= NUM_BITS_PER_STEP; bit++)
+    {
+        bool is_set = ((key_radix >> bit) & 1) != 0;
+        uvec4 ballot = subgroupBallot(is_set);
+        match &= is_set ? ballot : ~ballot;
+    }
+
+    uint subgroup_rank = subgroupBallotExclusiveBitCount(match);
+    if (key_radix < RADIX_SIZE && subgroup_rank == 0)
+    {
+        // The first invocation of every radix publishes the count of the subgroup
+        uint j = key_radix * MAX_NUM_SUBGROUPS + gl_SubgroupID;
+        atomicOr(s_subgroup_count_buffer[j / 2], subgroupBallotBitCount(match) << ((j % 2) * 16));
+    }
+
+    barrier();
+
+    // Exclusive prefix sum on the subgroup counts of every radix, a thread per radix
+    uint block_count = 0;
+    if (thread_i < RADIX_SIZE)
+    {
+        for (uint j = thread_i * MAX_NUM_SUBGROUPS / 2; j < (thread_i + 1) * MAX_NUM_SUBGROUPS / 2; j++)
+        {
+            uint counts = s_subgroup_count_buffer[j];
+            uint lo_count = counts & 0xffff;
+            uint hi_count = counts >> 16;
+            s_subgroup_count_buffer[j] = block_count | ((block_count + lo_count) << 16);
+            block_count += lo_count + hi_count;
+        }
+        s_block_count_buffer[thread_i] = block_count;
+    }
+
+    // Exclusive prefix sum on the block counts of radixes
+    s_prefix_sum_buffer[thread_i] = block_count;
+
+    barrier();
+
+    prefix_sum();
+
+    if (thread_i < RADIX_SIZE)
+    {
+        s_local_offset_buffer[thread_i] = s_prefix_sum_buffer[thread_i];
+    }
+
+    barrier();
+
+    if (key_radix >= RADIX_SIZE) return 0;
+    return s_local_offset_buffer[key_radix] + get_subgroup_count(key_radix, gl_SubgroupID) + subgroup_rank;
+}
+)";
+
+        /// Code shared by the shaders that move keys (and values) to their sorted position within a step.
+        inline const char* k_radix_sort_scatter_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer SrcKeyBuffer
+{
+    KEY_TYPE b_src_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = VAL_BINDING) readonly buffer SrcValBuffer
+{
+    uint data[];
+} b_src_val_buffers[NUM_VAL_BUFFERS];
+#endif
+
+layout(std430, binding = 2) writeonly buffer DstKeyBuffer
+{
+    KEY_TYPE b_dst_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = VAL_BINDING + NUM_VAL_BUFFERS) writeonly buffer DstValBuffer
+{
+    uint data[];
+} b_dst_val_buffers[NUM_VAL_BUFFERS];
+#endif
+
+layout(std430, binding = 6) readonly buffer VaryingBitsBuffer
+{
+    KEY_TYPE b_varying_bits; // The bits that aren't the same for all keys
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_radix_shift;
+#if defined(TRANSFORM_KEYS) || defined(EXTRACT_KEY)
+layout(location = 3) uniform bool u_first_step;
+#endif
+#ifdef TRANSFORM_KEYS
+layout(location = 4) uniform bool u_last_step;
+#endif
+layout(location = 5) uniform uint u_radix_mask;
+#ifdef WITH_VALUES
+layout(location = 7) uniform bool u_iota_values; // Values are their index (argsort's first step)
+#endif
+
+shared uint s_global_offset_buffer[RADIX_SIZE];
+shared uint s_scatter_offset_buffer[RADIX_SIZE]; // dst index - local index, for every radix
+
+shared KEY_TYPE s_key_staging_buffer[NUM_THREADS];
+#ifdef WITH_VALUES
+shared uint s_val_staging_buffer[NUM_THREADS];
+#endif
+
+/// Computes s_global_offset_buffer by a prefix sum on the global counts of radixes. Every thread gives the count of
+/// the radix equal to its index (0 if out of range).
+void compute_global_offsets(uint thread_i, uint global_count)
+{
+    s_prefix_sum_buffer[thread_i] = global_count;
+
+    barrier();
+
+    prefix_sum();
+
+    if (thread_i < RADIX_SIZE)
+    {
+        s_global_offset_buffer[thread_i] = s_prefix_sum_buffer[thread_i];
+    }
+
+    barrier();
+}
+
+bool is_constant_radix()
+{
+    return get_radix(b_varying_bits, u_radix_shift, u_radix_mask) == 0;
+}
+
+KEY_TYPE load_key(uint i)
+{
+#ifdef EXTRACT_KEY
+    KEY_TYPE key = u_first_step ? extract_key(i) : b_src_key_buffer[i];
+#else
+    KEY_TYPE key = b_src_key_buffer[i];
+#endif
+#ifdef TRANSFORM_KEYS
+    if (u_first_step) key = to_sortable_key(key);
+#endif
+    return key;
+}
+
+#ifdef WITH_VALUES
+uint load_val(uint val_buffer_i, uint i)
+{
+    return u_iota_values ? i : b_src_val_buffers[val_buffer_i].data[i];
+}
+#endif
+
+void store_key(KEY_TYPE key, uint di)
+{
+#ifdef TRANSFORM_KEYS
+    b_dst_key_buffer[di] = u_last_step ? from_sortable_key(key) : key;
+#else
+    b_dst_key_buffer[di] = key;
+#endif
+}
+
+/// Moves the i-th key and value to the same index, for steps whose radix is constant.
+void copy_key(uint i)
+{
+    store_key(load_key(i), i);
+#ifdef WITH_VALUES
+    for (uint v = 0; v < NUM_VAL_BUFFERS; v++) b_dst_val_buffers[v].data[i] = load_val(v, i);
+#endif
+}
+
+/// Moves the i-th key (already loaded) to the shared memory, at the index given by rank_key.
+void stage_key(KEY_TYPE key, uint local_i)
+{
+    s_key_staging_buffer[local_i] = key;
+}
+
+/// Moves the staged keys to their dst index, then the values of the i-th keys, a value buffer at a time through the
+/// shared memory. Keys having the same radix are consecutive both in the shared memory and in the dst buffer, so that
+/// consecutive invocations mostly write consecutive elements. Requires s_scatter_offset_buffer and a barrier after
+/// staging.
+void scatter_staged_keys(uint thread_i, uint num_block_keys, uint i, uint local_i)
+{
+    uint di = 0;
+    if (thread_i < num_block_keys)
+    {
+        KEY_TYPE key = s_key_staging_buffer[thread_i];
+        di = s_scatter_offset_buffer[get_key_radix(key, u_radix_shift, u_radix_mask)] + thread_i;
+        store_key(key, di);
+    }
+
+#ifdef WITH_VALUES
+    for (uint v = 0; v < NUM_VAL_BUFFERS; v++)
+    {
+        if (v > 0) barrier(); // The previous value buffer was read
+
+        if (thread_i < num_block_keys) s_val_staging_buffer[local_i] = load_val(v, i);
+
+        barrier();
+
+        if (thread_i < num_block_keys) b_dst_val_buffers[v].data[di] = s_val_staging_buffer[thread_i];
+    }
+#endif
+}
+)";
+
+        inline const char* k_radix_sort_reordering_shader = R"(
+layout(std430, binding = 4) readonly buffer BlockOffsetBuffer
+{
+    uint b_block_offset_buffer[];
+};
+
+layout(std430, binding = 5) readonly buffer GlobalCountBuffer
+{
+    uint b_global_count_buffer[];
+};
+
+layout(location = 2) uniform uint u_num_blocks;
+
+void main()
+{
+    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+    uint i = gl_WorkGroupID.x * NUM_THREADS + thread_i;
+
+    if (is_constant_radix())
+    {
+        // Every key has the same digit: a stable sort keeps the order as is
+        if (i < u_count) copy_key(i);
+        return;
+    }
+
+    // Prefix sum on global counts to obtain global offsets
+    compute_global_offsets(thread_i, thread_i < RADIX_SIZE ? b_global_count_buffer[thread_i] : 0);
+
+    KEY_TYPE key;
+    uint key_radix = RADIX_SIZE; // Out of range for invocations without key
+    if (i < u_count)
+    {
+        key = load_key(i);
+        key_radix = get_key_radix(key, u_radix_shift, u_radix_mask);
+    }
+
+    // Reordering
+    uint local_i = rank_key(thread_i, key_radix);
+    if (i < u_count) stage_key(key, local_i);
+
+    if (thread_i < RADIX_SIZE)
+    {
+        uint block_offset = b_block_offset_buffer[thread_i * u_num_blocks + gl_WorkGroupID.x];
+        s_scatter_offset_buffer[thread_i] =
+            s_global_offset_buffer[thread_i] + block_offset - s_local_offset_buffer[thread_i];
+    }
+
+    barrier();
+
+    scatter_staged_keys(thread_i, min(u_count - gl_WorkGroupID.x * NUM_THREADS, uint(NUM_THREADS)), i, local_i);
+}
+)";
+
+        /// OneSweep: counts the radixes of all the steps in a single pass over the keys.
+        inline const char* k_radix_sort_onesweep_histogram_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+layout(std430, binding = 1) buffer GlobalCountBuffer
+{
+    uint b_global_count_buffer[]; // RADIX_SIZE * num_steps
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_begin_bit;
+layout(location = 2) uniform uint u_end_bit;
+layout(location = 3) uniform uint u_num_steps;
+
+shared uint s_count_buffer[RADIX_SIZE * MAX_NUM_STEPS];
+
+void main()
+{
+    for (uint j = gl_LocalInvocationIndex; j < RADIX_SIZE * u_num_steps; j += NUM_THREADS)
+    {
+        s_count_buffer[j] = 0;
+    }
+
+    barrier();
+
+    uint i = gl_GlobalInvocationID.x;
+    if (i < u_count)
+    {
+#ifdef EXTRACT_KEY
+        KEY_TYPE key = extract_key(i);
+#else
+        KEY_TYPE key = b_key_buffer[i];
+#endif
+#ifdef TRANSFORM_KEYS
+        key = to_sortable_key(key);
+#endif
+        for (uint step = 0; step < u_num_steps; step++)
+        {
+            uint shift = u_begin_bit + step * NUM_BITS_PER_STEP;
+            uint mask = (1u << min(uint(NUM_BITS_PER_STEP), u_end_bit - shift)) - 1;
+            atomicAdd(s_count_buffer[step * RADIX_SIZE + get_key_radix(key, shift, mask)], 1);
+        }
+    }
+
+    barrier();
+
+    for (uint j = gl_LocalInvocationIndex; j < RADIX_SIZE * u_num_steps; j += NUM_THREADS)
+    {
+        if (s_count_buffer[j] > 0) atomicAdd(b_global_count_buffer[j], s_count_buffer[j]);
+    }
+}
+)";
+
+        /// OneSweep: runs a step in a single dispatch. The offsets of a block are obtained by the counts of the
+        /// preceding blocks, read through decoupled look-back: every block publishes its counts as soon as they're
+        /// known, and its inclusive prefix as soon as its predecessors have published theirs. Blocks are ordered by the
+        /// time they start (not by gl_WorkGroupID), so that a block only waits for blocks that are already running.
+        inline const char* k_radix_sort_onesweep_shader = R"(
+#define FLAG_NOT_READY 0u
+#define FLAG_AGGREGATE (1u << 30)
+#define FLAG_PREFIX (2u << 30)
+#define FLAG_MASK (3u << 30)
+#define VALUE_MASK ((1u << 30) - 1)
+
+layout(std430, binding = 4) coherent buffer StatusBuffer
+{
+    uint b_status_buffer[]; // RADIX_SIZE * num_blocks
+};
+
+layout(std430, binding = 5) readonly buffer GlobalCountBuffer
+{
+    uint b_global_count_buffer[]; // RADIX_SIZE * num_steps
+};
+
+layout(std430, binding = 7) buffer PartitionCounterBuffer
+{
+    uint b_partition_counter_buffer[]; // num_steps
+};
+
+layout(location = 6) uniform uint u_step;
+
+shared uint s_partition_i;
+
+void main()
+{
+    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+
+    if (is_constant_radix())
+    {
+        // Every key has the same digit: a stable sort keeps the order as is
+        uint i = gl_WorkGroupID.x * NUM_THREADS + thread_i;
+        if (i < u_count) copy_key(i);
+        return;
+    }
+
+    if (thread_i == 0)
+    {
+        s_partition_i = atomicAdd(b_partition_counter_buffer[u_step], 1);
+    }
+
+    uint global_count = thread_i < RADIX_SIZE ? b_global_count_buffer[u_step * RADIX_SIZE + thread_i] : 0;
+    compute_global_offsets(thread_i, global_count); // Also makes s_partition_i visible
+
+    uint partition_i = s_partition_i;
+    uint i = partition_i * NUM_THREADS + thread_i;
+
+    KEY_TYPE key;
+    uint key_radix = RADIX_SIZE; // Out of range for invocations without key
+    if (i < u_count)
+    {
+        key = load_key(i);
+        key_radix = get_key_radix(key, u_radix_shift, u_radix_mask);
+    }
+
+    uint local_i = rank_key(thread_i, key_radix);
+    if (i < u_count) stage_key(key, local_i);
+
+    // Decoupled look-back: a thread per radix
+    if (thread_i < RADIX_SIZE)
+    {
+        uint block_count = s_block_count_buffer[thread_i];
+        uint status_i = partition_i * RADIX_SIZE + thread_i;
+
+        uint exclusive_prefix = 0;
+        if (partition_i == 0)
+        {
+            atomicExchange(b_status_buffer[status_i], FLAG_PREFIX | block_count);
+        }
+        else
+        {
+            atomicExchange(b_status_buffer[status_i], FLAG_AGGREGATE | block_count);
+
+            int prev_partition_i = int(partition_i) - 1;
+            while (prev_partition_i >= 0)
+            {
+                uint status = atomicOr(b_status_buffer[prev_partition_i * RADIX_SIZE + thread_i], 0);
+                uint flag = status & FLAG_MASK;
+                if (flag == FLAG_NOT_READY) continue; // Spin until the preceding block publishes its count
+
+                exclusive_prefix += status & VALUE_MASK;
+                if (flag == FLAG_PREFIX) break;
+                prev_partition_i--;
+            }
+
+            atomicExchange(b_status_buffer[status_i], FLAG_PREFIX | (exclusive_prefix + block_count));
+        }
+
+        // The exclusive prefix is the block offset of the radix
+        s_scatter_offset_buffer[thread_i] =
+            s_global_offset_buffer[thread_i] + exclusive_prefix - s_local_offset_buffer[thread_i];
+    }
+
+    barrier();
+
+    scatter_staged_keys(thread_i, min(u_count - partition_i * NUM_THREADS, uint(NUM_THREADS)), i, local_i);
+}
+)";
+
+        /// Sorts up to LOCAL_SORT_CAPACITY keys (and values) with a single workgroup, keeping them on shared memory for
+        /// all the steps. Every step ranks the keys by tiles of NUM_THREADS, in order, so that the sort is stable.
+        /// If SEGMENTED, every workgroup sorts a segment; segments that don't fit are listed to be sorted afterwards by
+        /// the segment programs.
+        /// If WINDOWED, every workgroup sorts a window of LOCAL_SORT_CAPACITY keys listed by the inversion shader.
+        inline const char* k_radix_sort_local_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = VAL_BINDING) buffer ValBuffer
+{
+    uint data[];
+} b_val_buffers[NUM_VAL_BUFFERS];
+#endif
+
+#ifdef SEGMENTED
+layout(std430, binding = 2) readonly buffer SegmentOffsetBuffer
+{
+    uint b_segment_offset_buffer[]; // num_segments + 1
+};
+
+layout(std430, binding = 3) buffer LargeSegmentBuffer
+{
+    uint b_num_large_segments;
+    uvec2 b_large_segment_buffer[]; // The begin and end of every large segment
+};
+
+layout(location = 3) uniform uint u_num_segments;
+#else
+layout(location = 0) uniform uint u_count;
+#endif
+#ifdef WINDOWED
+layout(std430, binding = 3) readonly buffer WindowBuffer
+{
+    uint b_num_windows;
+    uint b_num_inversions;
+    uint b_window_buffer[]; // The index of the first key of every window
+};
+#endif
+layout(location = 1) uniform uint u_begin_bit;
+layout(location = 2) uniform uint u_end_bit;
+#ifdef WITH_VALUES
+layout(location = 7) uniform bool u_iota_values; // Values are their index (argsort)
+#endif
+
+shared KEY_TYPE s_key_buffer[2 * LOCAL_SORT_CAPACITY]; // Two halves, swapped at every step
+#ifdef WITH_VALUES
+shared uint s_val_buffer[NUM_VAL_BUFFERS * 2 * LOCAL_SORT_CAPACITY]; // Two halves per value buffer
+#endif
+shared uint s_offset_buffer[RADIX_SIZE]; // Where the next keys of every radix are placed
+
+void main()
+{
+    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+
+#ifdef SEGMENTED
+    uint segment_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (segment_i >= u_num_segments) return;
+
+    uint base_i = b_segment_offset_buffer[segment_i];
+    uint count = b_segment_offset_buffer[segment_i + 1] - base_i;
+    if (count > LOCAL_SORT_CAPACITY)
+    {
+        if (thread_i == 0) b_large_segment_buffer[atomicAdd(b_num_large_segments, 1)] = uvec2(base_i, base_i + count);
+        return;
+    }
+#elif defined(WINDOWED)
+    uint window_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (window_i >= b_num_windows) return;
+
+    uint base_i = b_window_buffer[window_i];
+    uint count = min(uint(LOCAL_SORT_CAPACITY), u_count - base_i);
+#else
+    uint base_i = 0;
+    uint count = u_count;
+#endif
+
+    for (uint i = thread_i; i < count; i += NUM_THREADS)
+    {
+#ifdef EXTRACT_KEY
+        KEY_TYPE key = extract_key(i); // Not segmented
+#else
+        KEY_TYPE key = b_key_buffer[base_i + i];
+#endif
+#ifdef TRANSFORM_KEYS
+        key = to_sortable_key(key);
+#endif
+        s_key_buffer[i] = key;
+#ifdef WITH_VALUES
+        for (uint v = 0; v < NUM_VAL_BUFFERS; v++)
+        {
+            s_val_buffer[v * 2 * LOCAL_SORT_CAPACITY + i] = u_iota_values ? i : b_val_buffers[v].data[base_i + i];
+        }
+#endif
+    }
+
+    uint src = 0;
+    for (uint shift = u_begin_bit; shift < u_end_bit; shift += NUM_BITS_PER_STEP)
+    {
+        uint mask = (1u << min(uint(NUM_BITS_PER_STEP), u_end_bit - shift)) - 1;
+        uint dst = LOCAL_SORT_CAPACITY - src;
+
+        // Count of radixes
+        if (thread_i < RADIX_SIZE) s_offset_buffer[thread_i] = 0;
+
+        barrier();
+
+        for (uint i = thread_i; i < count; i += NUM_THREADS)
+        {
+            atomicAdd(s_offset_buffer[get_key_radix(s_key_buffer[src + i], shift, mask)], 1);
+        }
+
+        barrier();
+
+        // Prefix sum on counts to obtain offsets
+        s_prefix_sum_buffer[thread_i] = thread_i < RADIX_SIZE ? s_offset_buffer[thread_i] : 0;
+
+        barrier();
+
+        prefix_sum();
+
+        if (thread_i < RADIX_SIZE) s_offset_buffer[thread_i] = s_prefix_sum_buffer[thread_i];
+
+        barrier();
+
+        // Reordering
+        for (uint tile_i = 0; tile_i < count; tile_i += NUM_THREADS)
+        {
+            uint i = tile_i + thread_i;
+
+            KEY_TYPE key;
+            uint key_radix = RADIX_SIZE; // Out of range for invocations without key
+            if (i < count)
+            {
+                key = s_key_buffer[src + i];
+                key_radix = get_key_radix(key, shift, mask);
+            }
+
+            uint local_i = rank_key(thread_i, key_radix);
+            if (i < count)
+            {
+                uint di = dst + s_offset_buffer[key_radix] + local_i - s_local_offset_buffer[key_radix];
+                s_key_buffer[di] = key;
+#ifdef WITH_VALUES
+                for (uint v = 0; v < NUM_VAL_BUFFERS; v++)
+                {
+                    uint val_buffer_i = v * 2 * LOCAL_SORT_CAPACITY;
+                    s_val_buffer[val_buffer_i + di] = s_val_buffer[val_buffer_i + src + i];
+                }
+#endif
+            }
+
+            barrier();
+
+            if (thread_i < RADIX_SIZE) s_offset_buffer[thread_i] += s_block_count_buffer[thread_i];
+
+            barrier();
+        }
+
+        src = dst;
+    }
+
+    for (uint i = thread_i; i < count; i += NUM_THREADS)
+    {
+        KEY_TYPE key = s_key_buffer[src + i];
+#ifdef TRANSFORM_KEYS
+        key = from_sortable_key(key);
+#endif
+        b_key_buffer[base_i + i] = key;
+#ifdef WITH_VALUES
+        for (uint v = 0; v < NUM_VAL_BUFFERS; v++)
+        {
+            b_val_buffers[v].data[base_i + i] = s_val_buffer[v * 2 * LOCAL_SORT_CAPACITY + src + i];
+        }
+#endif
+    }
+}
+)";
+
+        /// The blocks of the large segments of sort_segments, listed upfront so that no block spans two segments. The
+        /// counts of a segment are laid out radix-major in its own region of the block count buffer, regions back to
+        /// back: a single scan over all of them gives every block the offsets of its radixes within its segment.
+        inline const char* k_radix_sort_segment_common_shader = R"(
+struct SegmentBlock
+{
+    uint begin; // The index of the first key of the block
+    uint end; // One past the index of its last key
+    uint count_i; // The index of the count of its radix 0, followed by those of the next radixes every stride
+    uint stride; // The number of blocks of its segment
+    uint dst_offset; // Added to the scanned counts: its segment offset minus the keys of the previous segments
+};
+
+layout(std430, binding = 5) readonly buffer SegmentBlockBuffer
+{
+    SegmentBlock b_segment_block_buffer[];
+};
+
+layout(location = 8) uniform uint u_num_segment_blocks;
+
+uint get_segment_block_i()
+{
+    return gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+}
+)";
+
+        /// Counts the radixes of a block of a large segment, a key per thread.
+        inline const char* k_radix_sort_segment_counting_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+layout(std430, binding = 1) writeonly buffer BlockCountBuffer
+{
+    uint b_block_count_buffer[];
+};
+
+layout(location = 1) uniform uint u_radix_shift;
+#ifdef TRANSFORM_KEYS
+layout(location = 3) uniform bool u_first_step;
+#endif
+layout(location = 5) uniform uint u_radix_mask;
+
+shared uint s_count_buffer[RADIX_SIZE];
+
+void main()
+{
+    uint block_i = get_segment_block_i();
+    if (block_i >= u_num_segment_blocks) return;
+
+    SegmentBlock block = b_segment_block_buffer[block_i];
+
+    for (uint radix = gl_LocalInvocationIndex; radix < RADIX_SIZE; radix += NUM_THREADS)
+    {
+        s_count_buffer[radix] = 0;
+    }
+
+    barrier();
+
+    uint i = block.begin + gl_LocalInvocationIndex;
+    if (i < block.end)
+    {
+        KEY_TYPE key = b_key_buffer[i];
+#ifdef TRANSFORM_KEYS
+        if (u_first_step) key = to_sortable_key(key);
+#endif
+        atomicAdd(s_count_buffer[get_key_radix(key, u_radix_shift, u_radix_mask)], 1);
+    }
+
+    barrier();
+
+    for (uint radix = gl_LocalInvocationIndex; radix < RADIX_SIZE; radix += NUM_THREADS)
+    {
+        b_block_count_buffer[block.count_i + radix * block.stride] = s_count_buffer[radix];
+    }
+}
+)";
+
+        /// Moves the keys (and values) of a block of a large segment to their sorted position within the segment.
+        inline const char* k_radix_sort_segment_reordering_shader = R"(
+layout(std430, binding = 4) readonly buffer BlockOffsetBuffer
+{
+    uint b_block_offset_buffer[]; // The scanned block counts
+};
+
+void main()
+{
+    uint block_i = get_segment_block_i();
+    if (block_i >= u_num_segment_blocks) return;
+
+    SegmentBlock block = b_segment_block_buffer[block_i];
+
+    uint thread_i = gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+    uint i = block.begin + thread_i;
+
+    KEY_TYPE key;
+    uint key_radix = RADIX_SIZE; // Out of range for invocations without key
+    if (i < block.end)
+    {
+        key = load_key(i);
+        key_radix = get_key_radix(key, u_radix_shift, u_radix_mask);
+    }
+
+    uint local_i = rank_key(thread_i, key_radix);
+    if (i < block.end) stage_key(key, local_i);
+
+    if (thread_i < RADIX_SIZE)
+    {
+        uint block_offset = b_block_offset_buffer[block.count_i + thread_i * block.stride];
+        s_scatter_offset_buffer[thread_i] = block.dst_offset + block_offset - s_local_offset_buffer[thread_i];
+    }
+
+    barrier();
+
+    scatter_staged_keys(thread_i, block.end - block.begin, i, local_i);
+}
+)";
+
+        /// Copies the keys (and values) of a block of a large segment as they are, to bring back the sorted segments
+        /// from the scratch buffers after an odd number of steps.
+        inline const char* k_radix_sort_segment_copy_shader = R"(
+void main()
+{
+    uint block_i = get_segment_block_i();
+    if (block_i >= u_num_segment_blocks) return;
+
+    SegmentBlock block = b_segment_block_buffer[block_i];
+
+    uint i = block.begin + gl_LocalInvocationIndex;
+    if (i < block.end) copy_key(i);
+}
+)";
+
+        /// Computes which bits differ from the first key among the keys of every workgroup (NUM_THREADS keys): every
+        /// key is XOR-ed with the first one, and the results are OR-reduced to a key per workgroup. OR-reducing these
+        /// gives the bits that aren't the same for all keys.
+        inline const char* k_radix_sort_key_diff_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+layout(std430, binding = 1) writeonly buffer KeyDiffBuffer
+{
+    KEY_TYPE b_key_diff_buffer[]; // A key per workgroup
+};
+
+layout(location = 0) uniform uint u_count;
+
+shared uint s_key_diff[KEY_NUM_BITS / 32];
+
+KEY_TYPE load_key(uint i)
+{
+#ifdef EXTRACT_KEY
+    KEY_TYPE key = extract_key(i);
+#else
+    KEY_TYPE key = b_key_buffer[i];
+#endif
+#ifdef TRANSFORM_KEYS
+    key = to_sortable_key(key);
+#endif
+    return key;
+}
+
+void main()
+{
+    if (gl_LocalInvocationIndex < KEY_NUM_BITS / 32) s_key_diff[gl_LocalInvocationIndex] = 0;
+
+    barrier();
+
+    uint i = gl_GlobalInvocationID.x;
+    if (i < u_count)
+    {
+        KEY_TYPE key_diff = subgroupOr(load_key(i) ^ load_key(0));
+        if (subgroupElect())
+        {
+#if KEY_NUM_BITS == 64
+            atomicOr(s_key_diff[0], key_diff.x);
+            atomicOr(s_key_diff[1], key_diff.y);
+#else
+            atomicOr(s_key_diff[0], key_diff);
+#endif
+        }
+    }
+
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0)
+    {
+#if KEY_NUM_BITS == 64
+        b_key_diff_buffer[gl_WorkGroupID.x] = uvec2(s_key_diff[0], s_key_diff[1]);
+#else
+        b_key_diff_buffer[gl_WorkGroupID.x] = s_key_diff[0];
+#endif
+    }
+}
+)";
+
+        /// Counts the adjacent keys out of order (inversions), and lists the windows of u_window_size keys (starting
+        /// at u_window_offset) holding an inversion, so that sorting them fixes it.
+        inline const char* k_radix_sort_inversion_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+layout(std430, binding = 1) buffer WindowBuffer
+{
+    uint b_num_windows;
+    uint b_num_inversions;
+    uint b_window_buffer[];
+};
+
+layout(std430, binding = 2) buffer WindowFlagBuffer
+{
+    uint b_window_flag_buffer[]; // Whether every window is listed
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_window_size;
+layout(location = 2) uniform uint u_window_offset;
+
+void list_window(uint window_i)
+{
+    if (atomicExchange(b_window_flag_buffer[window_i], 1) == 0)
+    {
+        b_window_buffer[atomicAdd(b_num_windows, 1)] = u_window_offset + window_i * u_window_size;
+    }
+}
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint i = workgroup_i * NUM_THREADS + gl_LocalInvocationIndex;
+
+    bool is_inversion = i + 1 < u_count && precedes(b_key_buffer[i + 1], b_key_buffer[i]);
+
+    uvec4 inversion_ballot = subgroupBallot(is_inversion);
+    if (subgroupElect())
+    {
+        uint num_inversions = subgroupBallotBitCount(inversion_ballot);
+        if (num_inversions > 0) atomicAdd(b_num_inversions, num_inversions);
+    }
+
+    // Inversions across two windows are left to the windows of the other offset
+    uint window_i = (i - u_window_offset) / u_window_size;
+    bool is_window_inversion =
+        is_inversion && i >= u_window_offset && window_i == (i + 1 - u_window_offset) / u_window_size;
+
+    // A subgroup spans at most two windows: its first and last inversions list them
+    uvec4 window_ballot = subgroupBallot(is_window_inversion);
+    if (is_window_inversion &&
+        (gl_SubgroupInvocationID == subgroupBallotFindLSB(window_ballot) ||
+         gl_SubgroupInvocationID == subgroupBallotFindMSB(window_ballot)))
+    {
+        list_window(window_i);
+    }
+}
+)";
+    } // namespace detail
+
+    /// The algorithms RadixSort can run every step with.
+    enum RadixSortEngine
+    {
+        /// Every step runs a counting dispatch, a prefix sum on the counts of every block (BlellochScan) and a
+        /// reordering dispatch.
+        RadixSortEngine_MultiPass = 0,
+
+        /// The radixes of all the steps are counted upfront by a single dispatch, then every step runs a single
+        /// dispatch whose blocks obtain their offsets through decoupled look-back. Requires the blocks of a dispatch
+        /// to make forward progress while others are waiting, otherwise RadixSortEngine_MultiPass is used.
+        RadixSortEngine_OneSweep
+    };
+
+    /// The key bits [begin_bit, end_bit) a RadixSort orders keys by. Bits outside of the range are ignored: keys that
+    /// only differ there keep their order. Every step sorts num_bits_per_step bits of the range.
+    struct BitRange
+    {
+        /// The least significant key bit to sort by.
+        size_t begin_bit = 0;
+
+        /// One past the most significant key bit to sort by, 0 for the key width.
+        size_t end_bit = 0;
+    };
+
+    /// The options of a RadixSort; callers only set the fields they change, e.g.:
+    ///
+    /// RadixSortOptions options;
+    /// options.key_data_type = DataType_Float;
+    /// options.order = SortOrder_Descending;
+    /// RadixSort radix_sort(options);
+    struct RadixSortOptions
+    {
+        /// The number of bits sorted by every step, in [1, 8]. Larger values require fewer steps (i.e. fewer reads
+        /// and writes of the keys and values) but larger histograms.
+        size_t num_bits_per_step = 4;
+
+        /// The type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 (unsigned 64-bit keys)
+        /// or DataType_Double.
+        DataType key_data_type = DataType_Uint;
+
+        /// If set, the keys are OR-reduced on the GPU before sorting, in order to find the digits that are the same
+        /// for all keys. No CPU readback is performed, so the steps of such digits still run: their counting exits
+        /// at once and their reordering copies the keys (and values) as they are, but the scan of the block counts
+        /// (MultiPass) isn't skipped. A constant step costs about a copy, against a full read and write of the keys
+        /// (and values) for a sorted one, and the detection costs a read of the keys: with few constant digits, this
+        /// mode can cost more than it saves. Use a BitRange when the bits are known upfront.
+        bool skip_constant_digits = false;
+
+        /// The algorithm to run the steps with. RadixSortEngine_MultiPass always runs as requested.
+        RadixSortEngine engine = RadixSortEngine_MultiPass;
+
+        /// If set, RadixSortEngine_OneSweep runs even if is_onesweep_supported() doesn't recognize the device: the
+        /// caller guarantees the forward progress of its blocks (otherwise the sort may hang).
+        bool force_engine = false;
+
+        /// The number of value buffers (e.g. the columns of a structure of arrays) moved along with the keys by the
+        /// same steps.
+        size_t num_val_buffers = 1;
+
+        /// The order of the sorted keys; in descending order the digits are ranked in reverse, so that no pass
+        /// inverting the keys is required.
+        SortOrder order = SortOrder_Ascending;
+
+        /// If not empty, the GLSL source of a `KEY_TYPE extract_key(uint index)` function (KEY_TYPE is uint for
+        /// 32-bit keys, uvec2 for 64-bit ones; floats are given as their bits). It's called by the first step instead
+        /// of reading the key buffer, typically reading a buffer of records declared at `binding = RECORD_BINDING`.
+        /// Such a RadixSort only sorts through sort_records.
+        std::string key_extraction_src;
+    };
+
+    class RadixSort
+    {
+    private:
+        /// The binding of the first value buffer; src value buffers are followed by dst value buffers.
+        static constexpr GLuint k_val_binding = 8;
+
+        /// The max number of times sort_adaptive sorts the windows holding inversions before sorting all the keys.
+        static constexpr size_t k_max_fix_up_rounds = 4;
+
+        Program m_count_program;
+        BlellochScan m_blelloch_scan;
+        Program m_reorder_program;
+        Program m_key_only_reorder_program;
+        Program m_onesweep_histogram_program;
+        Program m_onesweep_program;
+        Program m_key_only_onesweep_program;
+        Program m_local_sort_program;
+        Program m_key_only_local_sort_program;
+        Program m_segmented_sort_program;
+        Program m_key_only_segmented_sort_program;
+        Program m_segment_count_program;
+        Program m_segment_reorder_program;
+        Program m_key_only_segment_reorder_program;
+        Program m_segment_copy_program;
+        Program m_key_only_segment_copy_program;
+        Program m_key_diff_program;
+        Program m_inversion_program;
+        Program m_window_sort_program;
+        Program m_key_only_window_sort_program;
+        Reduce m_or_reduce;
+        std::unique_ptr<Merge> m_merge; // Built by the first sort_and_merge
+        std::unique_ptr<BitonicSort> m_bitonic_sort; // Built by the first sort over the memory budget
+
+        /// A GLuint buffer of size RADIX_SIZE * num_blocks that stores the counts of radixes per block.
+        /// With RadixSortEngine_OneSweep, it's the status buffer used for decoupled look-back.
+        ShaderStorageBuffer m_block_count_buffer;
+
+        /// A GLuint buffer of size RADIX_SIZE that stores the global counts of radixes.
+        /// With RadixSortEngine_OneSweep, it stores the global counts of every step (RADIX_SIZE * num_steps).
+        ShaderStorageBuffer m_global_count_buffer;
+
+        /// With RadixSortEngine_OneSweep, a GLuint per step that assigns block indices in the order blocks start.
+        ShaderStorageBuffer m_partition_counter_buffer;
+
+        /// A single key whose bits are set where keys differ. Steps whose digit is zero here are skipped.
+        ShaderStorageBuffer m_varying_bits_buffer;
+
+        ShaderStorageBuffer m_key_scratch_buffer;
+        std::vector<ShaderStorageBuffer> m_val_scratch_buffers; // One per value buffer
+
+        /// The number of segments too large to be sorted on shared memory, followed by their begin and end.
+        ShaderStorageBuffer m_large_segment_buffer;
+
+        /// The blocks of the large segments (see k_radix_sort_segment_common_shader).
+        ShaderStorageBuffer m_segment_block_buffer;
+
+        /// The number of windows to sort, the number of inversions, then the index of the first key of every window.
+        ShaderStorageBuffer m_window_buffer;
+
+        /// A GLuint per window, set once the window is listed.
+        ShaderStorageBuffer m_window_flag_buffer;
+
+        const size_t m_num_threads;
+
+        /// The number of keys counted by every thread of the counting program (a block counts m_num_threads keys).
+        const size_t m_num_items;
+
+        /// The type of the keys: DataType_Uint, DataType_Int, DataType_Float (32-bit keys), DataType_UVec2 or
+        /// DataType_Double (64-bit keys, low bits first).
+        const DataType m_key_data_type;
+
+        /// Whether keys have to be transformed to unsigned integers preserving their order (signed and float keys).
+        const bool m_transform_keys;
+
+        /// The size of a key in bytes.
+        const size_t m_key_size;
+
+        /// The number of key bits that are sorted on every step (i.e. the size of a digit).
+        const size_t m_num_bits_per_step;
+
+        /// The number of different digits a step can encounter: 2^num_bits_per_step.
+        const size_t m_radix_size;
+
+        /// The number of steps required to sort the whole key: ceil(key bits / num_bits_per_step).
+        const size_t m_num_steps;
+
+        /// Whether the bits that are the same for all keys are detected before sorting, to skip their steps.
+        const bool m_skip_constant_digits;
+
+        /// The number of GLuint value buffers moved along with the keys.
+        const size_t m_num_val_buffers;
+
+        /// The engine in use (after falling back if the requested one isn't supported).
+        const RadixSortEngine m_engine;
+
+        /// Whether keys are sorted in ascending or descending order.
+        const SortOrder m_order;
+
+        /// Whether the keys of the first step are computed by a user extract_key function instead of being read.
+        const bool m_extract_keys;
+
+        /// Up to this count, keys (and values) are sorted by a single workgroup on shared memory.
+        size_t m_local_sort_capacity = 0;
+        size_t m_key_only_local_sort_capacity = 0;
+
+        /// The max size of the internal buffers in bytes, 0 for no limit (see set_memory_budget).
+        size_t m_memory_budget = 0;
+
+    public:
+        /// @param options the options of the sort, fixed once its programs are built
+        explicit RadixSort(const RadixSortOptions& options = {}) :
+            m_blelloch_scan(DataType_Uint),
+            m_or_reduce(
+                get_data_type_size(options.key_data_type) == 8 ? DataType_UVec2 : DataType_Uint, ReduceOperator_Or
+            ),
+            m_num_threads(1024),
+            m_num_items(4),
+            m_key_data_type(options.key_data_type),
+            m_transform_keys(options.key_data_type != DataType_Uint && options.key_data_type != DataType_UVec2),
+            m_key_size(get_data_type_size(options.key_data_type)),
+            m_num_bits_per_step(options.num_bits_per_step),
+            m_radix_size(size_t(1) << options.num_bits_per_step),
+            m_num_steps(div_ceil<size_t>(m_key_size * 8, options.num_bits_per_step)),
+            m_skip_constant_digits(options.skip_constant_digits),
+            m_num_val_buffers(options.num_val_buffers),
+            m_engine(
+                options.engine == RadixSortEngine_OneSweep && !options.force_engine && !is_onesweep_supported()
+                    ? RadixSortEngine_MultiPass
+                    : options.engine
+            ),
+            m_order(options.order),
+            m_extract_keys(!options.key_extraction_src.empty())
         {
             GLU_CHECK_ARGUMENT(is_power_of_2(m_num_threads), "Num threads must be a power of 2");
+            GLU_CHECK_ARGUMENT(is_power_of_2(m_num_items), "Num items must be a power of 2");
+            GLU_CHECK_ARGUMENT(
+                m_key_data_type == DataType_Uint || m_key_data_type == DataType_Int ||
+                    m_key_data_type == DataType_Float || m_key_data_type == DataType_UVec2 ||
+                    m_key_data_type == DataType_Double,
+                "Invalid key data type: %d",
+                m_key_data_type
+            );
+            GLU_CHECK_ARGUMENT(
+                m_num_bits_per_step >= 1 && m_num_bits_per_step <= 8, "Num bits per step must be in [1, 8]"
+            );
+            GLU_CHECK_ARGUMENT(m_num_val_buffers >= 1, "Num val buffers must be at least 1");
+
+            // The OneSweep program uses the most buffers: keys (2), status, global counts, varying bits, partition
+            // counters and the values (2 * num_val_buffers), bound from k_val_binding, then the records (if any)
+            size_t num_record_buffers = m_extract_keys ? 1 : 0;
+            GLint max_storage_blocks = 0;
+            glGetIntegerv(GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS, &max_storage_blocks);
+            GLint max_storage_bindings = 0;
+            glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &max_storage_bindings);
+            GLU_CHECK_STATE(
+                size_t(max_storage_blocks) >= 6 + 2 * m_num_val_buffers + num_record_buffers &&
+                    size_t(max_storage_bindings) >= record_binding() + num_record_buffers,
+                "Too many val buffers: %zu (max storage blocks: %d, max storage bindings: %d)",
+                m_num_val_buffers,
+                max_storage_blocks,
+                max_storage_bindings
+            );
+
+            m_val_scratch_buffers.resize(m_num_val_buffers);
+
+            m_global_count_buffer.resize(m_radix_size * m_num_steps * sizeof(GLuint));
+            m_partition_counter_buffer.resize(m_num_steps * sizeof(GLuint));
+
+            m_varying_bits_buffer.resize(m_key_size);
+            m_varying_bits_buffer.clear(0xffffffff); // All the steps are run unless skip_constant_digits
+
+            // Keys are ranked by subgroup ballots, with a histogram per subgroup
+            GLint subgroup_size = 0;
+            glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &subgroup_size);
+            GLU_CHECK_STATE(
+                subgroup_size > 0 && subgroup_size <= 128 && m_num_threads % subgroup_size == 0,
+                "Unsupported subgroup size: %d",
+                subgroup_size
+            );
+
+            GLint subgroup_features = 0;
+            glGetIntegerv(GL_SUBGROUP_SUPPORTED_FEATURES_KHR, &subgroup_features);
+            GLU_CHECK_STATE(subgroup_features & GL_SUBGROUP_FEATURE_BALLOT_BIT_KHR, "Subgroup ballot isn't supported");
+
+            size_t max_num_subgroups = std::max<size_t>(m_num_threads / subgroup_size, 2);
+
+            std::string shader_src = "#version 460\n";
+            shader_src += "#extension GL_KHR_shader_subgroup_ballot : require\n";
+            shader_src += "#extension GL_KHR_shader_subgroup_arithmetic : require\n\n";
+            shader_src += "#define NUM_THREADS " + std::to_string(m_num_threads) + "\n";
+            shader_src += "#define MAX_NUM_SUBGROUPS " + std::to_string(max_num_subgroups) + "\n";
+            shader_src += "#define NUM_ITEMS " + std::to_string(m_num_items) + "\n";
+            shader_src += "#define NUM_BITS_PER_STEP " + std::to_string(m_num_bits_per_step) + "\n";
+            shader_src += "#define RADIX_SIZE " + std::to_string(m_radix_size) + "\n";
+            shader_src += std::string("#define KEY_TYPE ") + (m_key_size == 8 ? "uvec2" : "uint") + "\n";
+            shader_src += "#define KEY_NUM_BITS " + std::to_string(m_key_size * 8) + "\n";
+            shader_src += "#define MAX_NUM_STEPS " + std::to_string(m_num_steps) + "\n";
+            shader_src += "#define NUM_VAL_BUFFERS " + std::to_string(m_num_val_buffers) + "\n";
+            shader_src += "#define VAL_BINDING " + std::to_string(k_val_binding) + "\n";
+            if (m_key_data_type == DataType_Int)
+                shader_src += "#define SIGNED_KEYS\n";
+            else if (m_key_data_type == DataType_Float || m_key_data_type == DataType_Double)
+                shader_src += "#define FLOAT_KEYS\n";
+            if (m_transform_keys)
+                shader_src += "#define TRANSFORM_KEYS\n";
+            if (m_order == SortOrder_Descending)
+                shader_src += "#define DESCENDING\n";
+            shader_src += detail::k_radix_sort_common_shader;
+
+            // The programs reading the unsorted keys call extract_key instead (the segmented ones never do)
+            std::string key_src = shader_src;
+            if (m_extract_keys)
+            {
+                key_src += "#define EXTRACT_KEY\n";
+                key_src += "#define RECORD_BINDING " + std::to_string(record_binding()) + "\n";
+                key_src += options.key_extraction_src + "\n";
+            }
 
-            m_global_count_buffer.resize(16 * sizeof(GLuint));
+            std::string rank_src = detail::k_radix_sort_rank_shader;
+            std::string scatter_src = rank_src + detail::k_radix_sort_scatter_shader;
+            std::string with_values_src = "#define WITH_VALUES\n" + scatter_src;
+
+            build_program(m_count_program, key_src + detail::k_radix_sort_counting_shader);
+            build_program(m_reorder_program, key_src + with_values_src + detail::k_radix_sort_reordering_shader);
+            build_program(m_key_only_reorder_program, key_src + scatter_src + detail::k_radix_sort_reordering_shader);
+            build_program(m_key_diff_program, key_src + detail::k_radix_sort_key_diff_shader);
+            build_program(m_inversion_program, shader_src + detail::k_radix_sort_inversion_shader);
+
+            // Segment programs: sort_segments never extracts keys
+            std::string segment_src = detail::k_radix_sort_segment_common_shader;
+            std::string segment_scatter_src = shader_src + scatter_src + segment_src;
+            std::string segment_with_values_src = shader_src + with_values_src + segment_src;
+            build_program(
+                m_segment_count_program, shader_src + segment_src + detail::k_radix_sort_segment_counting_shader
+            );
+            build_program(
+                m_segment_reorder_program, segment_with_values_src + detail::k_radix_sort_segment_reordering_shader
+            );
+            build_program(
+                m_key_only_segment_reorder_program, segment_scatter_src + detail::k_radix_sort_segment_reordering_shader
+            );
+            build_program(m_segment_copy_program, segment_with_values_src + detail::k_radix_sort_segment_copy_shader);
+            build_program(
+                m_key_only_segment_copy_program, segment_scatter_src + detail::k_radix_sort_segment_copy_shader
+            );
+
+            if (m_engine == RadixSortEngine_OneSweep)
+            {
+                build_program(m_onesweep_histogram_program, key_src + detail::k_radix_sort_onesweep_histogram_shader);
+                build_program(m_onesweep_program, key_src + with_values_src + detail::k_radix_sort_onesweep_shader);
+                build_program(
+                    m_key_only_onesweep_program, key_src + scatter_src + detail::k_radix_sort_onesweep_shader
+                );
+            }
 
-            std::string shader_src = "#version 460\n\n";
-            shader_src += "#define NUM_THREADS " + std::to_string(m_num_threads) + "\n";
+            // Local sort programs: as many keys as fit the shared memory left by the ranking (twice, to ping-pong)
+            GLint max_shared_memory_size = 0;
+            glGetIntegerv(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, &max_shared_memory_size);
 
-            { // Counting program
-                Shader shader(GL_COMPUTE_SHADER);
-                shader.source_from_str(shader_src + detail::k_radix_sort_counting_shader);
-                shader.compile();
+            size_t rank_shared_memory_size =
+                (3 * m_radix_size + m_num_threads + m_radix_size * max_num_subgroups / 2) * sizeof(GLuint);
+            size_t free_shared_memory_size =
+                size_t(max_shared_memory_size) - std::min<size_t>(max_shared_memory_size, rank_shared_memory_size);
 
-                m_count_program.attach_shader(shader.handle());
-                m_count_program.link();
-            }
+            m_local_sort_capacity = free_shared_memory_size / (2 * (m_key_size + m_num_val_buffers * sizeof(GLuint)));
+            m_local_sort_capacity -= m_local_sort_capacity % m_num_threads;
 
-            { // Reordering program
-                Shader shader(GL_COMPUTE_SHADER);
-                shader.source_from_str(shader_src + detail::k_radix_sort_reordering_shader);
-                shader.compile();
+            m_key_only_local_sort_capacity = free_shared_memory_size / (2 * m_key_size);
+            m_key_only_local_sort_capacity -= m_key_only_local_sort_capacity % m_num_threads;
+
+            if (m_local_sort_capacity > 0)
+            {
+                std::string define_src = "#define LOCAL_SORT_CAPACITY " + std::to_string(m_local_sort_capacity) + "\n";
+                std::string local_sort_src = define_src + rank_src + detail::k_radix_sort_local_shader;
+                build_program(m_local_sort_program, key_src + "#define WITH_VALUES\n" + local_sort_src);
+                build_program(
+                    m_segmented_sort_program, shader_src + "#define WITH_VALUES\n#define SEGMENTED\n" + local_sort_src
+                );
+                build_program(
+                    m_window_sort_program, shader_src + "#define WITH_VALUES\n#define WINDOWED\n" + local_sort_src
+                );
+            }
 
-                m_reorder_program.attach_shader(shader.handle());
-                m_reorder_program.link();
+            if (m_key_only_local_sort_capacity > 0)
+            {
+                std::string define_src =
+                    "#define LOCAL_SORT_CAPACITY " + std::to_string(m_key_only_local_sort_capacity) + "\n";
+                std::string local_sort_src = define_src + rank_src + detail::k_radix_sort_local_shader;
+                build_program(m_key_only_local_sort_program, key_src + local_sort_src);
+                build_program(m_key_only_segmented_sort_program, shader_src + "#define SEGMENTED\n" + local_sort_src);
+                build_program(m_key_only_window_sort_program, shader_src + "#define WINDOWED\n" + local_sort_src);
             }
         }
 
         ~RadixSort() = default;
 
-        void prepare_internal_buffers(size_t count)
+        [[nodiscard]] DataType key_data_type() const { return m_key_data_type; }
+        [[nodiscard]] size_t num_bits_per_step() const { return m_num_bits_per_step; }
+        [[nodiscard]] size_t num_steps() const { return m_num_steps; }
+        [[nodiscard]] size_t num_key_bits() const { return m_key_size * 8; }
+        [[nodiscard]] RadixSortEngine engine() const { return m_engine; }
+        [[nodiscard]] SortOrder order() const { return m_order; }
+
+        /// The binding of the record buffer read by extract_key (RECORD_BINDING), right after the value buffers.
+        [[nodiscard]] GLuint record_binding() const { return k_val_binding + 2 * m_num_val_buffers; }
+
+        /// The max count sorted in a single dispatch, on shared memory (depends on GL_MAX_COMPUTE_SHARED_MEMORY_SIZE).
+        [[nodiscard]] size_t local_sort_capacity(bool with_values = true) const
+        {
+            return with_values ? m_local_sort_capacity : m_key_only_local_sort_capacity;
+        }
+
+        /// Checks whether RadixSortEngine_OneSweep can run on the current device. There's no way to query whether
+        /// the blocks of a dispatch make forward progress while others spin-wait; NVIDIA and AMD GPUs are known to.
+        /// The vendor strings are matched exactly; RadixSortOptions::force_engine overrides a misdetection.
+        static bool is_onesweep_supported()
+        {
+            const char* vendor = reinterpret_cast<const char*>(glGetString(GL_VENDOR));
+            if (vendor == nullptr)
+                return false;
+
+            std::string vendor_str(vendor);
+            return vendor_str == "NVIDIA Corporation" || vendor_str == "ATI Technologies Inc." || vendor_str == "AMD";
+        }
+
+        /// Limits the memory of the internal buffers: sorts whose scratch buffers would exceed memory_budget bytes run
+        /// a BitonicSort in place instead, which needs no scratch buffer but is slower and not stable. That's only
+        /// possible when sorting by the whole key with at most a single value buffer (not argsort nor sort_records);
+        /// other sorts run as usual.
+        ///
+        /// @param memory_budget the max size in bytes, 0 for no limit (the default)
+        void set_memory_budget(size_t memory_budget) { m_memory_budget = memory_budget; }
+
+        [[nodiscard]] size_t memory_budget() const { return m_memory_budget; }
+
+        /// The size in bytes of the internal buffers required to sort the given number of keys.
+        [[nodiscard]] size_t required_internal_buffers_size(size_t count, bool with_values = true) const
+        {
+            size_t size = required_block_count_buffer_size(count) + required_key_scratch_buffer_size(count);
+            if (with_values)
+                size += m_num_val_buffers * required_val_scratch_buffer_size(count);
+            return size;
+        }
+
+        /// Allocates the internal buffers required to sort the given number of keys, so that they're not allocated
+        /// while sorting. The value scratch buffer is only allocated if with_values is set.
+        void prepare_internal_buffers(size_t count, bool with_values = true)
         {
             { // Prepare block count buffer
                 size_t required_size = required_block_count_buffer_size(count);
@@ -1443,98 +5678,813 @@ void main()
                 }
             }
 
-            { // Prepare val scratch buffer
+            if (with_values)
+            { // Prepare val scratch buffers
                 size_t required_size = required_val_scratch_buffer_size(count);
-                if (m_val_scratch_buffer.size() < required_size)
+                for (ShaderStorageBuffer& val_scratch_buffer : m_val_scratch_buffers)
                 {
-                    m_val_scratch_buffer.resize(required_size, false);
+                    if (val_scratch_buffer.size() < required_size)
+                    {
+                        val_scratch_buffer.resize(required_size, false);
 #ifdef GLU_VERBOSE
-                    printf("[RadixSort] Val scratch buffer reallocated to: %zu\n", required_size);
+                        printf("[RadixSort] Val scratch buffer reallocated to: %zu\n", required_size);
 #endif
+                    }
                 }
             }
         }
 
-        void operator()(GLuint key_buffer, GLuint val_buffer, size_t count, size_t num_steps = 0)
+        /// Sorts the given key and value buffers by key.
+        ///
+        /// @param key_buffer the buffer of the keys (of the key data type)
+        /// @param val_buffer the GLuint buffer of the values
+        /// @param count the number of keys (and values)
+        /// @param bit_range the key bits to sort by, the whole key by default
+        void operator()(GLuint key_buffer, GLuint val_buffer, size_t count, BitRange bit_range = {})
         {
             GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
             GLU_CHECK_ARGUMENT(val_buffer, "Invalid value buffer");
+            GLU_CHECK_ARGUMENT(m_num_val_buffers == 1, "Expected %zu value buffers", m_num_val_buffers);
+            GLU_CHECK_STATE(!m_extract_keys, "Keys are extracted from records, use sort_records");
 
-            if (count <= 1)
+            sort(key_buffer, &val_buffer, count, bit_range);
+        }
+
+        /// Sorts the given key buffer and moves all the value buffers along with it, in the same steps.
+        ///
+        /// @param key_buffer the buffer of the keys (of the key data type)
+        /// @param val_buffers the GLuint value buffers, as many as num_val_buffers
+        /// @param count the number of keys (and values in every value buffer)
+        /// @param bit_range the key bits to sort by, the whole key by default
+        void operator()(
+            GLuint key_buffer,
+            const std::vector<GLuint>& val_buffers,
+            size_t count,
+            BitRange bit_range = {}
+        )
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+            GLU_CHECK_ARGUMENT(
+                val_buffers.size() == m_num_val_buffers,
+                "Expected %zu value buffers, got %zu",
+                m_num_val_buffers,
+                val_buffers.size()
+            );
+            for (GLuint val_buffer : val_buffers)
+                GLU_CHECK_ARGUMENT(val_buffer, "Invalid value buffer");
+            GLU_CHECK_STATE(!m_extract_keys, "Keys are extracted from records, use sort_records");
+
+            sort(key_buffer, val_buffers.data(), count, bit_range);
+        }
+
+        /// Sorts the given key buffer. No value is moved along with the keys, and no value scratch buffer is needed.
+        ///
+        /// @param key_buffer the buffer of the keys (of the key data type)
+        /// @param count the number of keys
+        /// @param bit_range the key bits to sort by, the whole key by default
+        void operator()(GLuint key_buffer, size_t count, BitRange bit_range = {})
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+            GLU_CHECK_STATE(!m_extract_keys, "Keys are extracted from records, use sort_records");
+
+            sort(key_buffer, nullptr, count, bit_range);
+        }
+
+        /// Sorts the given key buffer and writes to index_buffer the (stable) permutation that sorts it, i.e. the
+        /// original index of every sorted key. Indices are generated while sorting, no index buffer has to be
+        /// uploaded. The permutation can be applied to other buffers with Gather.
+        ///
+        /// @param key_buffer the buffer of the keys (of the key data type), sorted in place
+        /// @param index_buffer the GLuint buffer where the count indices are written
+        /// @param count the number of keys
+        /// @param bit_range the key bits to sort by, the whole key by default
+        void argsort(GLuint key_buffer, GLuint index_buffer, size_t count, BitRange bit_range = {})
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+            GLU_CHECK_ARGUMENT(index_buffer, "Invalid index buffer");
+            GLU_CHECK_ARGUMENT(m_num_val_buffers == 1, "Argsort requires a single value buffer");
+            GLU_CHECK_STATE(!m_extract_keys, "Keys are extracted from records, use sort_records");
+
+            if (count == 1)
+            {
+                GLuint index = 0;
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, index_buffer);
+                glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &index);
+                return;
+            }
+
+            sort(key_buffer, &index_buffer, count, bit_range, true);
+        }
+
+        /// Sorts the records of record_buffer by the keys extract_key computes from them: the first step calls
+        /// extract_key instead of reading the keys, so that no key buffer has to be written beforehand. Requires a
+        /// RadixSort built with a key_extraction_src.
+        ///
+        /// @param record_buffer the buffer extract_key reads, bound at record_binding()
+        /// @param key_buffer the buffer where the count sorted keys are written (its content is ignored)
+        /// @param index_buffer the GLuint buffer where the index of the record of every sorted key is written, or 0
+        /// @param count the number of records
+        /// @param bit_range the key bits to sort by, the whole key by default
+        void sort_records(
+            GLuint record_buffer,
+            GLuint key_buffer,
+            GLuint index_buffer,
+            size_t count,
+            BitRange bit_range = {}
+        )
+        {
+            GLU_CHECK_ARGUMENT(record_buffer, "Invalid record buffer");
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+            GLU_CHECK_ARGUMENT(!index_buffer || m_num_val_buffers == 1, "Indices require a single value buffer");
+            GLU_CHECK_STATE(m_extract_keys, "No key_extraction_src was given");
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, record_binding(), record_buffer);
+
+            sort(key_buffer, index_buffer ? &index_buffer : nullptr, count, bit_range, index_buffer != 0);
+        }
+
+        /// Sorts the delta keys (and values), then merges them into the given keys, already sorted by this RadixSort:
+        /// once done, the count + delta_count keys are sorted. Existing keys are placed before the equal delta keys.
+        /// When the delta is small, this is much cheaper than sorting all the keys again: the existing keys are read
+        /// and written once by the merge (then copied back), instead of once per step.
+        ///
+        /// @param key_buffer the count sorted keys, with room for count + delta_count keys
+        /// @param val_buffer the GLuint values of the keys (with the same room), or 0 to merge the keys only
+        /// @param count the number of sorted keys
+        /// @param delta_key_buffer the keys to add, sorted in place
+        /// @param delta_val_buffer the GLuint values of the keys to add, or 0 to merge the keys only
+        /// @param delta_count the number of keys to add
+        void sort_and_merge(
+            GLuint key_buffer,
+            GLuint val_buffer,
+            size_t count,
+            GLuint delta_key_buffer,
+            GLuint delta_val_buffer,
+            size_t delta_count
+        )
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+            GLU_CHECK_ARGUMENT(delta_key_buffer, "Invalid delta key buffer");
+            GLU_CHECK_ARGUMENT(
+                (val_buffer != 0) == (delta_val_buffer != 0), "Either both value buffers or none must be given"
+            );
+            GLU_CHECK_STATE(!m_extract_keys, "Keys are extracted from records, use sort_records");
+
+            bool with_values = val_buffer != 0;
+            GLU_CHECK_ARGUMENT(!with_values || m_num_val_buffers == 1, "Merging requires a single value buffer");
+
+            if (delta_count == 0)
+                return;
+
+            sort(delta_key_buffer, with_values ? &delta_val_buffer : nullptr, delta_count, {});
+
+            if (!m_merge)
+                m_merge = std::make_unique<Merge>(m_key_data_type, m_order);
+
+            size_t merged_count = count + delta_count;
+            prepare_internal_buffers(merged_count, with_values);
+
+            GLuint val_scratch_buffer = with_values ? m_val_scratch_buffers[0].handle() : 0;
+            (*m_merge)(
+                key_buffer,
+                val_buffer,
+                count,
+                delta_key_buffer,
+                delta_val_buffer,
+                delta_count,
+                m_key_scratch_buffer.handle(),
+                val_scratch_buffer
+            );
+
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+            copy_buffer(m_key_scratch_buffer.handle(), key_buffer, merged_count * m_key_size);
+            if (with_values)
+                copy_buffer(val_scratch_buffer, val_buffer, merged_count * sizeof(GLuint));
+        }
+
+        /// Sorts keys (and values) that are expected to be nearly sorted. A dispatch counts the adjacent keys out of
+        /// order (inversions) and lists the windows of local_sort_capacity() keys holding one: if there are few of
+        /// them, only those windows are sorted, each on shared memory, then the check runs again with windows shifted
+        /// by half their size, so that inversions across two windows are fixed as well. If there are too many
+        /// inversions, or they persist after k_max_fix_up_rounds rounds (keys far from their place), a full sort runs
+        /// instead. Every check reads back its counts (a CPU-GPU sync point). The result is the same as sort's.
+        ///
+        /// @param key_buffer the keys
+        /// @param val_buffer the GLuint values, or 0 to sort the keys only
+        /// @param count the number of keys (and values)
+        /// @param max_inversion_ratio above this ratio of inversions per key, the keys are fully sorted right away
+        void sort_adaptive(GLuint key_buffer, GLuint val_buffer, size_t count, float max_inversion_ratio = 0.01f)
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+            GLU_CHECK_STATE(!m_extract_keys, "Keys are extracted from records, use sort_records");
+
+            bool with_values = val_buffer != 0;
+            GLU_CHECK_ARGUMENT(!with_values || m_num_val_buffers == 1, "Expected %zu value buffers", m_num_val_buffers);
+
+            // Small counts are sorted by a single local sort anyway
+            size_t window_size = local_sort_capacity(with_values);
+            if (count <= window_size || window_size < 2)
+            {
+                sort(key_buffer, with_values ? &val_buffer : nullptr, count, {});
+                return;
+            }
+
+            size_t max_num_windows = div_ceil(count, window_size) + 1;
+            if (m_window_buffer.size() < (2 + max_num_windows) * sizeof(GLuint))
+                m_window_buffer.resize((2 + max_num_windows) * sizeof(GLuint), false);
+            if (m_window_flag_buffer.size() < max_num_windows * sizeof(GLuint))
+                m_window_flag_buffer.resize(max_num_windows * sizeof(GLuint), false);
+
+            for (size_t round = 0;; round++)
+            {
+                size_t window_offset = (round % 2) * (window_size / 2);
+
+                // ---------------------------------------------------------------- Check
+
+                m_window_buffer.clear(0);
+                m_window_flag_buffer.clear(0);
+
+                m_inversion_program.use();
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+                m_window_buffer.bind(1);
+                m_window_flag_buffer.bind(2);
+
+                glUniform1ui(m_inversion_program.get_uniform_location("u_count"), count);
+                glUniform1ui(m_inversion_program.get_uniform_location("u_window_size"), window_size);
+                glUniform1ui(m_inversion_program.get_uniform_location("u_window_offset"), window_offset);
+
+                size_t num_workgroups = div_ceil(count, m_num_threads);
+                size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+                glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+                GLuint counts[2]{}; // The number of windows, then the number of inversions
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_window_buffer.handle());
+                glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counts), counts);
+
+                if (counts[1] == 0)
+                    return;
+
+                if ((round == 0 && counts[1] > max_inversion_ratio * count) || round == k_max_fix_up_rounds)
+                    break;
+
+                if (counts[0] == 0)
+                    continue; // Inversions are all across windows
+
+                // ---------------------------------------------------------------- Fix-up
+
+                Program& program = with_values ? m_window_sort_program : m_key_only_window_sort_program;
+                program.use();
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+                if (with_values)
+                    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_val_binding, val_buffer);
+                m_window_buffer.bind(3);
+
+                glUniform1ui(program.get_uniform_location("u_count"), count);
+                glUniform1ui(program.get_uniform_location("u_begin_bit"), 0);
+                glUniform1ui(program.get_uniform_location("u_end_bit"), num_key_bits());
+                if (with_values)
+                    glUniform1ui(program.get_uniform_location("u_iota_values"), false);
+
+                // A workgroup per window, on two dimensions as the guaranteed max workgroup count is 65535
+                size_t num_windows = counts[0];
+                size_t num_windows_x = std::min<size_t>(num_windows, 65535);
+                glDispatchCompute(num_windows_x, div_ceil(num_windows, num_windows_x), 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            }
+
+            sort(key_buffer, with_values ? &val_buffer : nullptr, count, {});
+        }
+
+        /// Sorts independently every segment of the keys (and values). Segments are back to back: the i-th one spans
+        /// [segment_offsets[i], segment_offsets[i + 1]). Segments up to local_sort_capacity() are sorted by a
+        /// workgroup each, all in a single dispatch. Larger ones are listed by that dispatch and read back (a single
+        /// CPU-GPU sync point), then sorted all together by the multi-pass steps, over blocks that never span two
+        /// segments.
+        ///
+        /// @param key_buffer the keys
+        /// @param val_buffer the GLuint values, or 0 to sort the keys only
+        /// @param segment_offset_buffer a GLuint buffer of num_segments + 1 offsets, non-decreasing
+        /// @param num_segments the number of segments
+        /// @param bit_range the key bits to sort by, the whole key by default
+        void sort_segments(
+            GLuint key_buffer,
+            GLuint val_buffer,
+            GLuint segment_offset_buffer,
+            size_t num_segments,
+            BitRange bit_range = {}
+        )
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+            GLU_CHECK_ARGUMENT(segment_offset_buffer, "Invalid segment offset buffer");
+            GLU_CHECK_STATE(!m_extract_keys, "Keys are extracted from records, use sort_records");
+
+            size_t begin_bit = bit_range.begin_bit;
+            size_t end_bit = bit_range.end_bit == 0 ? num_key_bits() : bit_range.end_bit;
+
+            GLU_CHECK_ARGUMENT(
+                begin_bit < end_bit && end_bit <= num_key_bits(), "Invalid bit range: [%zu, %zu)", begin_bit, end_bit
+            );
+
+            if (num_segments == 0)
+                return;
+
+            bool with_values = val_buffer != 0;
+
+            GLU_CHECK_ARGUMENT(!with_values || m_num_val_buffers == 1, "Segments require a single value buffer");
+            GLU_CHECK_STATE(local_sort_capacity(with_values) > 0, "Not enough shared memory to sort segments");
+
+            // ---------------------------------------------------------------- Small segments
+
+            size_t required_size = (2 * num_segments + 2) * sizeof(GLuint);
+            if (m_large_segment_buffer.size() < required_size)
+                m_large_segment_buffer.resize(required_size, false);
+
+            m_large_segment_buffer.clear(0);
+
+            Program& program = with_values ? m_segmented_sort_program : m_key_only_segmented_sort_program;
+            program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+            if (with_values)
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_val_binding, val_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, segment_offset_buffer);
+            m_large_segment_buffer.bind(3);
+
+            glUniform1ui(program.get_uniform_location("u_num_segments"), num_segments);
+            glUniform1ui(program.get_uniform_location("u_begin_bit"), begin_bit);
+            glUniform1ui(program.get_uniform_location("u_end_bit"), end_bit);
+
+            // A workgroup per segment, on two dimensions as the guaranteed max workgroup count is 65535
+            size_t num_workgroups_x = std::min<size_t>(num_segments, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_segments, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+            // ---------------------------------------------------------------- Large segments
+
+            GLuint num_large_segments = 0;
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_large_segment_buffer.handle());
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &num_large_segments);
+            if (num_large_segments == 0)
+                return;
+
+            std::vector<GLuint> large_segments(2 * num_large_segments); // Begin and end of every large segment
+            size_t large_segments_size = large_segments.size() * sizeof(GLuint);
+            glGetBufferSubData(
+                GL_SHADER_STORAGE_BUFFER, 2 * sizeof(GLuint), large_segments_size, large_segments.data()
+            );
+
+            sort_large_segments(key_buffer, val_buffer, large_segments, begin_bit, end_bit);
+        }
+
+    private:
+        /// Sorts the keys and, if val_buffers isn't null, the num_val_buffers values. If iota_values, the values are
+        /// initialized to their index instead of being read.
+        void sort(
+            GLuint key_buffer,
+            const GLuint* val_buffers,
+            size_t count,
+            BitRange bit_range,
+            bool iota_values = false
+        )
+        {
+            size_t begin_bit = bit_range.begin_bit;
+            size_t end_bit = bit_range.end_bit == 0 ? num_key_bits() : bit_range.end_bit;
+
+            GLU_CHECK_ARGUMENT(
+                begin_bit < end_bit && end_bit <= num_key_bits(), "Invalid bit range: [%zu, %zu)", begin_bit, end_bit
+            );
+
+            if (count == 0 || (count == 1 && !m_extract_keys))
                 return; // Hey, that's already sorted x)
 
-            prepare_internal_buffers(count);
+            size_t num_steps = div_ceil(end_bit - begin_bit, m_num_bits_per_step);
+
+            bool with_values = val_buffers != nullptr;
+
+            if (count <= local_sort_capacity(with_values))
+            {
+                local_sort(key_buffer, val_buffers, count, begin_bit, end_bit, iota_values);
+                return;
+            }
+
+            // Over the memory budget, the keys are sorted in place if nothing requires a radix sort
+            bool whole_key = begin_bit == 0 && end_bit == num_key_bits();
+            if (m_memory_budget > 0 && required_internal_buffers_size(count, with_values) > m_memory_budget &&
+                whole_key && (!with_values || m_num_val_buffers == 1) && !iota_values && !m_extract_keys)
+            {
+                if (!m_bitonic_sort)
+                    m_bitonic_sort = std::make_unique<BitonicSort>(m_key_data_type, m_order);
+
+                (*m_bitonic_sort)(key_buffer, with_values ? val_buffers[0] : 0, count);
+                return;
+            }
+
+            prepare_internal_buffers(count, with_values);
 
-            size_t num_blocks = div_ceil(count, size_t(1024));
-            size_t num_blocks_power_of_2 = next_power_of_2(num_blocks); // Required by BlellochScan
+            if (m_skip_constant_digits)
+                find_varying_bits(key_buffer, count);
 
             GLuint key_buffers[]{key_buffer, m_key_scratch_buffer.handle()};
-            GLuint val_buffers[]{val_buffer, m_val_scratch_buffer.handle()};
 
-            for (int step = 0; step < 8;)
+            std::vector<GLuint> val_scratch_buffers;
+            for (const ShaderStorageBuffer& val_scratch_buffer : m_val_scratch_buffers)
+                val_scratch_buffers.push_back(val_scratch_buffer.handle());
+            const GLuint* val_buffer_sets[]{val_buffers, val_scratch_buffers.data()};
+
+            if (m_engine == RadixSortEngine_OneSweep)
+                count_all_steps(key_buffer, count, begin_bit, end_bit, num_steps);
+
+            for (size_t step = 0; step < num_steps; step++)
             {
-                // ---------------------------------------------------------------- Counting
+                StepParams params{};
+                params.src_key_buffer = key_buffers[step % 2];
+                params.src_val_buffers = val_buffer_sets[step % 2];
+                params.dst_key_buffer = key_buffers[(step + 1) % 2];
+                params.dst_val_buffers = val_buffer_sets[(step + 1) % 2];
+                params.with_values = with_values;
+                params.count = count;
+                params.step = step;
+                params.radix_shift = begin_bit + step * m_num_bits_per_step;
+                params.radix_mask = (1u << std::min(m_num_bits_per_step, end_bit - params.radix_shift)) - 1;
+                params.first_step = step == 0;
+                params.last_step = step == num_steps - 1;
+                params.iota_values = iota_values && step == 0;
+
+                if (m_engine == RadixSortEngine_OneSweep)
+                    run_onesweep_step(params);
+                else
+                    run_multi_pass_step(params);
+            }
+
+            // An odd number of steps leaves the sorted data in the scratch buffers
+            if (num_steps % 2 == 1)
+            {
+                glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+                copy_buffer(m_key_scratch_buffer.handle(), key_buffer, count * m_key_size);
+                for (size_t v = 0; with_values && v < m_num_val_buffers; v++)
+                    copy_buffer(val_scratch_buffers[v], val_buffers[v], count * sizeof(GLuint));
+            }
+        }
+
+        void local_sort(
+            GLuint key_buffer,
+            const GLuint* val_buffers,
+            size_t count,
+            size_t begin_bit,
+            size_t end_bit,
+            bool iota_values
+        )
+        {
+            bool with_values = val_buffers != nullptr;
+
+            Program& local_sort_program = with_values ? m_local_sort_program : m_key_only_local_sort_program;
+            local_sort_program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+            for (size_t v = 0; with_values && v < m_num_val_buffers; v++)
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_val_binding + v, val_buffers[v]);
+
+            glUniform1ui(local_sort_program.get_uniform_location("u_count"), count);
+            glUniform1ui(local_sort_program.get_uniform_location("u_begin_bit"), begin_bit);
+            glUniform1ui(local_sort_program.get_uniform_location("u_end_bit"), end_bit);
+            if (with_values)
+                glUniform1ui(local_sort_program.get_uniform_location("u_iota_values"), iota_values);
+
+            glDispatchCompute(1, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        struct StepParams
+        {
+            GLuint src_key_buffer;
+            const GLuint* src_val_buffers;
+            GLuint dst_key_buffer;
+            const GLuint* dst_val_buffers;
+            bool with_values;
+            size_t count;
+            size_t step;
+            GLuint radix_shift;
+            GLuint radix_mask;
+            bool first_step;
+            bool last_step;
+            bool iota_values;
+        };
+
+        /// Sets the uniforms shared by the programs that include k_radix_sort_scatter_shader.
+        void set_scatter_uniforms(Program& program, const StepParams& params)
+        {
+            glUniform1ui(program.get_uniform_location("u_count"), params.count);
+            glUniform1ui(program.get_uniform_location("u_radix_shift"), params.radix_shift);
+            glUniform1ui(program.get_uniform_location("u_radix_mask"), params.radix_mask);
+            if (m_transform_keys || m_extract_keys)
+                glUniform1ui(program.get_uniform_location("u_first_step"), params.first_step);
+            if (m_transform_keys)
+                glUniform1ui(program.get_uniform_location("u_last_step"), params.last_step);
+            if (params.with_values)
+                glUniform1ui(program.get_uniform_location("u_iota_values"), params.iota_values);
+        }
+
+        /// Binds the buffers shared by the programs that include k_radix_sort_scatter_shader.
+        void bind_scatter_buffers(const StepParams& params)
+        {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, params.src_key_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, params.dst_key_buffer);
+            for (size_t v = 0; params.with_values && v < m_num_val_buffers; v++)
+            {
+                GLuint src_binding = k_val_binding + v;
+                GLuint dst_binding = k_val_binding + m_num_val_buffers + v;
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, src_binding, params.src_val_buffers[v]);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, dst_binding, params.dst_val_buffers[v]);
+            }
+            m_varying_bits_buffer.bind(6);
+        }
+
+        void run_multi_pass_step(const StepParams& params)
+        {
+            size_t num_blocks = div_ceil(params.count, m_num_threads);
+
+            // ---------------------------------------------------------------- Counting
+
+            // The block counts aren't cleared: every block writes all its counts (unless the digit is constant, in
+            // which case the reordering ignores them). The global counts are accumulated by atomics
+            m_global_count_buffer.clear(0);
+
+            m_count_program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, params.src_key_buffer);
+            m_block_count_buffer.bind(1);
+            m_global_count_buffer.bind(2);
+            m_varying_bits_buffer.bind(3);
+
+            glUniform1ui(m_count_program.get_uniform_location("u_count"), params.count);
+            glUniform1ui(m_count_program.get_uniform_location("u_radix_shift"), params.radix_shift);
+            glUniform1ui(m_count_program.get_uniform_location("u_radix_mask"), params.radix_mask);
+            if (m_transform_keys || m_extract_keys)
+                glUniform1ui(m_count_program.get_uniform_location("u_first_step"), params.first_step);
+            glUniform1ui(m_count_program.get_uniform_location("u_num_blocks"), num_blocks);
+
+            glDispatchCompute(num_blocks, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // ---------------------------------------------------------------- Prefix sum
+
+            m_blelloch_scan(m_block_count_buffer.handle(), num_blocks, m_radix_size);
+
+            // ---------------------------------------------------------------- Reordering
+
+            Program& reorder_program = params.with_values ? m_reorder_program : m_key_only_reorder_program;
+            reorder_program.use();
+
+            bind_scatter_buffers(params);
+            m_block_count_buffer.bind(4);
+            m_global_count_buffer.bind(5);
 
-                m_block_count_buffer.clear(0);
-                m_global_count_buffer.clear(0);
+            set_scatter_uniforms(reorder_program, params);
+            glUniform1ui(reorder_program.get_uniform_location("u_num_blocks"), num_blocks);
 
-                m_count_program.use();
+            glDispatchCompute(num_blocks, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        /// OneSweep: counts the radixes of all the steps in m_global_count_buffer.
+        void count_all_steps(GLuint key_buffer, size_t count, size_t begin_bit, size_t end_bit, size_t num_steps)
+        {
+            m_global_count_buffer.clear(0);
+            m_partition_counter_buffer.clear(0);
+
+            m_onesweep_histogram_program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+            m_global_count_buffer.bind(1);
+
+            glUniform1ui(m_onesweep_histogram_program.get_uniform_location("u_count"), count);
+            glUniform1ui(m_onesweep_histogram_program.get_uniform_location("u_begin_bit"), begin_bit);
+            glUniform1ui(m_onesweep_histogram_program.get_uniform_location("u_end_bit"), end_bit);
+            glUniform1ui(m_onesweep_histogram_program.get_uniform_location("u_num_steps"), num_steps);
+
+            glDispatchCompute(div_ceil(count, m_num_threads), 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        void run_onesweep_step(const StepParams& params)
+        {
+            size_t num_blocks = div_ceil(params.count, m_num_threads);
+
+            m_block_count_buffer.clear(0); // Status of every block: not ready
+
+            Program& onesweep_program = params.with_values ? m_onesweep_program : m_key_only_onesweep_program;
+            onesweep_program.use();
+
+            bind_scatter_buffers(params);
+            m_block_count_buffer.bind(4);
+            m_global_count_buffer.bind(5);
+            m_partition_counter_buffer.bind(7);
+
+            set_scatter_uniforms(onesweep_program, params);
+            glUniform1ui(onesweep_program.get_uniform_location("u_step"), params.step);
+
+            glDispatchCompute(num_blocks, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        /// Sorts the large segments of sort_segments (begin and end pairs) all together: every step counts the radixes
+        /// of all their blocks, scans the counts of all the segments at once and moves the keys of every block within
+        /// its segment, as run_multi_pass_step does for a single sort.
+        void sort_large_segments(
+            GLuint key_buffer,
+            GLuint val_buffer,
+            const std::vector<GLuint>& large_segments,
+            size_t begin_bit,
+            size_t end_bit
+        )
+        {
+            bool with_values = val_buffer != 0;
+
+            // ---------------------------------------------------------------- Blocks
+
+            std::vector<GLuint> segment_blocks; // Five GLuint per block, see SegmentBlock
+            size_t num_counts = 0; // The counts of the previous segments
+            size_t num_keys = 0; // The keys of the previous segments, i.e. the scanned count at the segment start
+            size_t max_end = 0;
+            for (size_t s = 0; s < large_segments.size(); s += 2)
+            {
+                size_t begin = large_segments[s];
+                size_t end = large_segments[s + 1];
+                size_t num_blocks = div_ceil(end - begin, m_num_threads);
+                for (size_t block_i = 0; block_i < num_blocks; block_i++)
+                {
+                    size_t block_begin = begin + block_i * m_num_threads;
+                    segment_blocks.push_back(block_begin);
+                    segment_blocks.push_back(std::min(block_begin + m_num_threads, end));
+                    segment_blocks.push_back(num_counts + block_i);
+                    segment_blocks.push_back(num_blocks);
+                    segment_blocks.push_back(GLuint(begin - num_keys)); // May wrap around: the scanned count is added
+                }
+
+                num_counts += m_radix_size * num_blocks;
+                num_keys += end - begin;
+                max_end = std::max(max_end, end);
+            }
+
+            size_t num_segment_blocks = segment_blocks.size() / 5;
+
+            size_t required_size = segment_blocks.size() * sizeof(GLuint);
+            if (m_segment_block_buffer.size() < required_size)
+                m_segment_block_buffer.resize(required_size, false);
+            m_segment_block_buffer.write_data(segment_blocks.data(), required_size);
+
+            prepare_internal_buffers(max_end, with_values);
+
+            required_size = num_counts * sizeof(GLuint);
+            if (m_block_count_buffer.size() < required_size)
+                m_block_count_buffer.resize(required_size, false);
+
+            GLuint key_buffers[]{key_buffer, m_key_scratch_buffer.handle()};
+            GLuint val_buffers[]{val_buffer, with_values ? m_val_scratch_buffers[0].handle() : 0};
+
+            // Blocks on two dimensions, as the guaranteed max workgroup count is 65535
+            size_t num_workgroups_x = std::min<size_t>(num_segment_blocks, 65535);
+            size_t num_workgroups_y = div_ceil(num_segment_blocks, num_workgroups_x);
 
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffers[step % 2]);
+            size_t num_steps = div_ceil(end_bit - begin_bit, m_num_bits_per_step);
+            for (size_t step = 0; step < num_steps; step++)
+            {
+                StepParams params{};
+                params.src_key_buffer = key_buffers[step % 2];
+                params.src_val_buffers = &val_buffers[step % 2];
+                params.dst_key_buffer = key_buffers[(step + 1) % 2];
+                params.dst_val_buffers = &val_buffers[(step + 1) % 2];
+                params.with_values = with_values;
+                params.radix_shift = begin_bit + step * m_num_bits_per_step;
+                params.radix_mask = (1u << std::min(m_num_bits_per_step, end_bit - params.radix_shift)) - 1;
+                params.first_step = step == 0;
+                params.last_step = step == num_steps - 1;
+
+                // ---------------------------------------------------------------- Counting
+
+                m_segment_count_program.use();
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, params.src_key_buffer);
                 m_block_count_buffer.bind(1);
-                m_global_count_buffer.bind(2);
+                m_segment_block_buffer.bind(5);
 
-                glUniform1ui(m_count_program.get_uniform_location("u_count"), count);
-                glUniform1ui(m_count_program.get_uniform_location("u_radix_shift"), step << 2);
-                glUniform1ui(m_count_program.get_uniform_location("u_num_blocks_power_of_2"), num_blocks_power_of_2);
+                glUniform1ui(m_segment_count_program.get_uniform_location("u_radix_shift"), params.radix_shift);
+                glUniform1ui(m_segment_count_program.get_uniform_location("u_radix_mask"), params.radix_mask);
+                if (m_transform_keys)
+                    glUniform1ui(m_segment_count_program.get_uniform_location("u_first_step"), params.first_step);
+                glUniform1ui(m_segment_count_program.get_uniform_location("u_num_segment_blocks"), num_segment_blocks);
 
-                glDispatchCompute(num_blocks, 1, 1);
+                glDispatchCompute(num_workgroups_x, num_workgroups_y, 1);
                 glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
                 // ---------------------------------------------------------------- Prefix sum
 
-                m_blelloch_scan(m_block_count_buffer.handle(), num_blocks_power_of_2, 16);
+                m_blelloch_scan(m_block_count_buffer.handle(), num_counts);
 
                 // ---------------------------------------------------------------- Reordering
 
-                m_reorder_program.use();
+                Program& program = with_values ? m_segment_reorder_program : m_key_only_segment_reorder_program;
+                program.use();
 
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffers[step % 2]);
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, val_buffers[step % 2]);
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, key_buffers[(step + 1) % 2]);
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, val_buffers[(step + 1) % 2]);
+                bind_scatter_buffers(params);
                 m_block_count_buffer.bind(4);
-                m_global_count_buffer.bind(5);
+                m_segment_block_buffer.bind(5);
 
-                glUniform1ui(m_reorder_program.get_uniform_location("u_count"), count);
-                glUniform1ui(m_reorder_program.get_uniform_location("u_radix_shift"), step << 2);
-                glUniform1ui(m_reorder_program.get_uniform_location("u_num_blocks_power_of_2"), num_blocks_power_of_2);
+                glUniform1ui(program.get_uniform_location("u_radix_shift"), params.radix_shift);
+                glUniform1ui(program.get_uniform_location("u_radix_mask"), params.radix_mask);
+                set_segment_scatter_uniforms(program, params, num_segment_blocks);
 
-                glDispatchCompute(num_blocks, 1, 1);
+                glDispatchCompute(num_workgroups_x, num_workgroups_y, 1);
                 glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            }
+
+            // An odd number of steps leaves the sorted segments in the scratch buffers
+            if (num_steps % 2 == 1)
+            {
+                StepParams params{};
+                params.src_key_buffer = key_buffers[1];
+                params.src_val_buffers = &val_buffers[1];
+                params.dst_key_buffer = key_buffers[0];
+                params.dst_val_buffers = &val_buffers[0];
+                params.with_values = with_values;
 
-                ++step;
-                if (step == num_steps || step == 8) break;
+                Program& program = with_values ? m_segment_copy_program : m_key_only_segment_copy_program;
+                program.use();
+
+                bind_scatter_buffers(params);
+                m_segment_block_buffer.bind(5);
+
+                set_segment_scatter_uniforms(program, params, num_segment_blocks);
+
+                glDispatchCompute(num_workgroups_x, num_workgroups_y, 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
             }
         }
 
-    private:
-        [[nodiscard]] static size_t required_block_count_buffer_size(size_t count)
+        /// Sets the uniforms shared by the segment programs that include k_radix_sort_scatter_shader (the reordering
+        /// and the copy, which ignores the radix).
+        void set_segment_scatter_uniforms(Program& program, const StepParams& params, size_t num_segment_blocks)
+        {
+            if (m_transform_keys)
+            {
+                glUniform1ui(program.get_uniform_location("u_first_step"), params.first_step);
+                glUniform1ui(program.get_uniform_location("u_last_step"), params.last_step);
+            }
+            if (params.with_values)
+                glUniform1ui(program.get_uniform_location("u_iota_values"), false);
+            glUniform1ui(program.get_uniform_location("u_num_segment_blocks"), num_segment_blocks);
+        }
+
+        /// Stores in the varying bits buffer the bits that differ among the keys, entirely on the GPU: every block of
+        /// keys is XOR-ed with the first key and OR-reduced to a key (at the start of the key scratch buffer), then
+        /// these are OR-reduced to the varying bits buffer. Only a key per block is written.
+        void find_varying_bits(GLuint key_buffer, size_t count)
+        {
+            size_t num_blocks = div_ceil(count, m_num_threads);
+
+            m_key_diff_program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+            m_key_scratch_buffer.bind(1);
+
+            glUniform1ui(m_key_diff_program.get_uniform_location("u_count"), count);
+
+            glDispatchCompute(num_blocks, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            m_or_reduce(m_key_scratch_buffer.handle(), 0, num_blocks, m_varying_bits_buffer.handle(), 0);
+        }
+
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+
+        [[nodiscard]] size_t required_block_count_buffer_size(size_t count) const
         {
-            size_t num_blocks = div_ceil(count, size_t(1024));
-            size_t num_blocks_power_of_2 = next_power_of_2(num_blocks); // Required by BlellochScan
+            size_t num_blocks = div_ceil(count, m_num_threads);
 
-            return next_power_of_2(16 * num_blocks_power_of_2) * sizeof(GLuint);
+            return m_radix_size * num_blocks * sizeof(GLuint);
         }
 
-        [[nodiscard]] static size_t required_key_scratch_buffer_size(size_t count)
+        [[nodiscard]] size_t required_key_scratch_buffer_size(size_t count) const
         {
-            return next_power_of_2(count) * sizeof(GLuint);
+            return count * m_key_size;
         }
 
         [[nodiscard]] static size_t required_val_scratch_buffer_size(size_t count)
         {
-            return next_power_of_2(count) * sizeof(GLuint);
+            return count * sizeof(GLuint);
         }
     };
 } // namespace glu
@@ -33,6 +33,13 @@ if __name__ == "__main__":
     def p(filename: str):
         return path.join(script_dir, "glu/%s" % filename), path.join(script_dir, "dist/%s" % filename)
 
+    generate_standalone_header(*p("BitonicSort.hpp"))
     generate_standalone_header(*p("BlellochScan.hpp"))
+    generate_standalone_header(*p("CountingSort.hpp"))
+    generate_standalone_header(*p("Gather.hpp"))
+    generate_standalone_header(*p("Merge.hpp"))
+    generate_standalone_header(*p("MultiKeyRadixSort.hpp"))
+    generate_standalone_header(*p("RadixSelect.hpp"))
     generate_standalone_header(*p("RadixSort.hpp"))
     generate_standalone_header(*p("Reduce.hpp"))
+    generate_standalone_header(*p("SegmentedScan.hpp"))
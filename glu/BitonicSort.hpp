@@ -0,0 +1,301 @@
+#ifndef GLU_BITONICSORT_HPP
+#define GLU_BITONICSORT_HPP
+
+#include <algorithm>
+
+#include "data_types.hpp"
+#include "gl_utils.hpp"
+#include "radix_sort_common.hpp"
+
+namespace glu
+{
+    namespace detail
+    {
+        /// The compare-and-swap of the bitonic network: every stage pairs the elements of index i and i ^ j (or, on
+        /// the first stage of a merge of size k, i and i ^ (k - 1), which flips the second half so that all the pairs
+        /// are ordered the same way). Keys past the count behave as the greatest ones: their pairs are skipped, so the
+        /// network sorts any count as if it was padded to a power of 2.
+        inline const char* k_bitonic_sort_common_shader = R"(
+/// The indices of the p-th pair of a stage, the first one being less than the second one.
+uvec2 get_pair(uint p, uint k, uint j)
+{
+    uint i = (p / j) * 2 * j + p % j;
+    return uvec2(i, j == k / 2 ? i ^ (k - 1) : i + j);
+}
+)";
+
+        /// Sorts every block of BLOCK_SIZE keys (and values) on shared memory if u_k is zero. Otherwise, runs the
+        /// stages of the merge of size u_k whose pairs lie within a block (j < BLOCK_SIZE).
+        inline const char* k_bitonic_sort_local_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 1) buffer ValBuffer
+{
+    uint b_val_buffer[];
+};
+#endif
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_k;
+
+shared KEY_TYPE s_key_buffer[BLOCK_SIZE];
+#ifdef WITH_VALUES
+shared uint s_val_buffer[BLOCK_SIZE];
+#endif
+
+void compare_and_swap(uint base_i, uint k, uint j)
+{
+    uvec2 pair = get_pair(gl_LocalInvocationIndex, k, j);
+    if (base_i + pair.y < u_count && precedes(s_key_buffer[pair.y], s_key_buffer[pair.x]))
+    {
+        KEY_TYPE key = s_key_buffer[pair.x];
+        s_key_buffer[pair.x] = s_key_buffer[pair.y];
+        s_key_buffer[pair.y] = key;
+#ifdef WITH_VALUES
+        uint val = s_val_buffer[pair.x];
+        s_val_buffer[pair.x] = s_val_buffer[pair.y];
+        s_val_buffer[pair.y] = val;
+#endif
+    }
+
+    barrier();
+}
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint base_i = workgroup_i * BLOCK_SIZE;
+    if (base_i >= u_count) return;
+
+    for (uint i = gl_LocalInvocationIndex; i < BLOCK_SIZE && base_i + i < u_count; i += NUM_THREADS)
+    {
+        s_key_buffer[i] = b_key_buffer[base_i + i];
+#ifdef WITH_VALUES
+        s_val_buffer[i] = b_val_buffer[base_i + i];
+#endif
+    }
+
+    barrier();
+
+    if (u_k == 0)
+    {
+        for (uint k = 2; k <= BLOCK_SIZE; k *= 2)
+        {
+            for (uint j = k / 2; j > 0; j /= 2) compare_and_swap(base_i, k, j);
+        }
+    }
+    else
+    {
+        for (uint j = BLOCK_SIZE / 2; j > 0; j /= 2) compare_and_swap(base_i, u_k, j);
+    }
+
+    for (uint i = gl_LocalInvocationIndex; i < BLOCK_SIZE && base_i + i < u_count; i += NUM_THREADS)
+    {
+        b_key_buffer[base_i + i] = s_key_buffer[i];
+#ifdef WITH_VALUES
+        b_val_buffer[base_i + i] = s_val_buffer[i];
+#endif
+    }
+}
+)";
+
+        /// Runs a stage of the merge of size u_k whose pairs span more than a block (u_j >= BLOCK_SIZE): a thread per
+        /// pair.
+        inline const char* k_bitonic_sort_global_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 1) buffer ValBuffer
+{
+    uint b_val_buffer[];
+};
+#endif
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_k;
+layout(location = 2) uniform uint u_j;
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uvec2 pair = get_pair(workgroup_i * NUM_THREADS + gl_LocalInvocationIndex, u_k, u_j);
+    if (pair.y >= u_count) return;
+
+    KEY_TYPE key1 = b_key_buffer[pair.x];
+    KEY_TYPE key2 = b_key_buffer[pair.y];
+    if (precedes(key2, key1))
+    {
+        b_key_buffer[pair.x] = key2;
+        b_key_buffer[pair.y] = key1;
+#ifdef WITH_VALUES
+        uint val = b_val_buffer[pair.x];
+        b_val_buffer[pair.x] = b_val_buffer[pair.y];
+        b_val_buffer[pair.y] = val;
+#endif
+    }
+}
+)";
+    } // namespace detail
+
+    /// A class that sorts keys (and values) in place by a bitonic sorting network: no scratch buffer is needed,
+    /// contrary to RadixSort. Blocks are sorted on shared memory first; then, every merge runs its stages spanning
+    /// more than a block as global dispatches, and its last stages on shared memory. It takes O(n log^2 n) compares,
+    /// so it's slower than RadixSort on large counts: it's meant for when memory is short.
+    ///
+    /// The sort isn't stable: the order of equal keys isn't preserved. Keys are compared the way RadixSort orders
+    /// them.
+    class BitonicSort
+    {
+    private:
+        const size_t m_num_threads;
+
+        /// The number of keys sorted on shared memory by a workgroup: a pair per thread.
+        const size_t m_block_size;
+
+        /// The type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or DataType_Double.
+        const DataType m_key_data_type;
+
+        const SortOrder m_order;
+
+        Program m_local_program;
+        Program m_key_only_local_program;
+        Program m_global_program;
+        Program m_key_only_global_program;
+
+    public:
+        /// @param key_data_type the type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or
+        ///                      DataType_Double
+        /// @param order the order keys are sorted in
+        explicit BitonicSort(DataType key_data_type = DataType_Uint, SortOrder order = SortOrder_Ascending) :
+            m_num_threads(512),
+            m_block_size(2 * m_num_threads),
+            m_key_data_type(key_data_type),
+            m_order(order)
+        {
+            GLU_CHECK_ARGUMENT(
+                m_key_data_type == DataType_Uint || m_key_data_type == DataType_Int ||
+                    m_key_data_type == DataType_Float || m_key_data_type == DataType_UVec2 ||
+                    m_key_data_type == DataType_Double,
+                "Invalid key data type: %d",
+                m_key_data_type
+            );
+
+            size_t key_size = get_data_type_size(m_key_data_type);
+
+            std::string shader_src = "#version 460\n\n";
+            shader_src += "#define NUM_THREADS " + std::to_string(m_num_threads) + "\n";
+            shader_src += "#define BLOCK_SIZE " + std::to_string(m_block_size) + "\n";
+            shader_src += std::string("#define KEY_TYPE ") + (key_size == 8 ? "uvec2" : "uint") + "\n";
+            shader_src += "#define KEY_NUM_BITS " + std::to_string(key_size * 8) + "\n";
+            if (m_key_data_type == DataType_Int)
+                shader_src += "#define SIGNED_KEYS\n";
+            else if (m_key_data_type == DataType_Float || m_key_data_type == DataType_Double)
+                shader_src += "#define FLOAT_KEYS\n";
+            if (m_key_data_type != DataType_Uint && m_key_data_type != DataType_UVec2)
+                shader_src += "#define TRANSFORM_KEYS\n";
+            if (m_order == SortOrder_Descending)
+                shader_src += "#define DESCENDING\n";
+            shader_src += detail::k_radix_sort_common_shader;
+            shader_src += detail::k_bitonic_sort_common_shader;
+
+            build_program(m_local_program, shader_src + "#define WITH_VALUES\n" + detail::k_bitonic_sort_local_shader);
+            build_program(m_key_only_local_program, shader_src + detail::k_bitonic_sort_local_shader);
+            build_program(
+                m_global_program, shader_src + "#define WITH_VALUES\n" + detail::k_bitonic_sort_global_shader
+            );
+            build_program(m_key_only_global_program, shader_src + detail::k_bitonic_sort_global_shader);
+        }
+
+        ~BitonicSort() = default;
+
+        [[nodiscard]] DataType key_data_type() const { return m_key_data_type; }
+        [[nodiscard]] SortOrder order() const { return m_order; }
+
+        /// Sorts the given keys (and values) in place.
+        ///
+        /// @param key_buffer the keys (of the key data type)
+        /// @param val_buffer the GLuint values moved along with the keys, or 0 to sort the keys only
+        /// @param count the number of keys (and values)
+        void operator()(GLuint key_buffer, GLuint val_buffer, size_t count)
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+
+            if (count <= 1)
+                return;
+
+            bool with_values = val_buffer != 0;
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+            if (with_values)
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, val_buffer);
+
+            // The network of the next power of 2, whose keys past the count are skipped
+            size_t count_power_of_2 = next_power_of_2(count);
+
+            run_local(with_values, count, 0);
+
+            for (size_t k = 2 * m_block_size; k <= count_power_of_2; k *= 2)
+            {
+                for (size_t j = k / 2; j >= m_block_size; j /= 2)
+                    run_global(with_values, count, k, j);
+
+                run_local(with_values, count, k);
+            }
+        }
+
+    private:
+        void run_local(bool with_values, size_t count, size_t k)
+        {
+            Program& program = with_values ? m_local_program : m_key_only_local_program;
+            program.use();
+
+            glUniform1ui(program.get_uniform_location("u_count"), count);
+            glUniform1ui(program.get_uniform_location("u_k"), k);
+
+            // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(count, m_block_size);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        void run_global(bool with_values, size_t count, size_t k, size_t j)
+        {
+            Program& program = with_values ? m_global_program : m_key_only_global_program;
+            program.use();
+
+            glUniform1ui(program.get_uniform_location("u_count"), count);
+            glUniform1ui(program.get_uniform_location("u_k"), k);
+            glUniform1ui(program.get_uniform_location("u_j"), j);
+
+            // A thread per pair of the network, on two dimensions as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(next_power_of_2(count) / 2, m_num_threads);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_BITONICSORT_HPP
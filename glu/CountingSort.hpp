@@ -0,0 +1,367 @@
+#ifndef GLU_COUNTINGSORT_HPP
+#define GLU_COUNTINGSORT_HPP
+
+#include <algorithm>
+
+#include "BlellochScan.hpp"
+#include "gl_utils.hpp"
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Keys are grouped by bucket within every subgroup (a ballot per bucket bit), so that a single atomic is
+        /// issued per bucket and subgroup. If the buckets fit the shared memory, they're further aggregated per
+        /// workgroup, and only flushed to global memory once.
+        inline const char* k_counting_sort_common_shader = R"(
+#extension GL_KHR_shader_subgroup_ballot : require
+#extension GL_KHR_shader_subgroup_shuffle : require
+
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_num_buckets;
+layout(location = 2) uniform uint u_num_bucket_bits; // The bits of the last bucket
+
+shared uint s_bucket_buffer[NUM_SHARED_BUCKETS]; // Only used if u_num_buckets <= NUM_SHARED_BUCKETS
+
+/// The bucket of a key: keys past the domain are clamped to the last bucket.
+uint get_bucket(uint key)
+{
+    return min(key, u_num_buckets - 1);
+}
+
+/// The invocations of the subgroup whose key falls in the same bucket (for invocations without key, all of them).
+uvec4 match_bucket(bool has_key, uint bucket)
+{
+    uvec4 has_key_ballot = subgroupBallot(has_key);
+    uvec4 match = has_key ? has_key_ballot : ~has_key_ballot;
+    for (uint bit = 0; bit < u_num_bucket_bits; bit++)
+    {
+        bool is_set = ((bucket >> bit) & 1) != 0;
+        uvec4 ballot = subgroupBallot(is_set);
+        match &= is_set ? ballot : ~ballot;
+    }
+    return match;
+}
+
+void clear_shared_buckets()
+{
+    if (u_num_buckets > NUM_SHARED_BUCKETS) return;
+
+    for (uint bucket = gl_LocalInvocationIndex; bucket < u_num_buckets; bucket += NUM_THREADS)
+    {
+        s_bucket_buffer[bucket] = 0;
+    }
+}
+)";
+
+        inline const char* k_counting_sort_histogram_shader = R"(
+layout(std430, binding = 0) readonly buffer KeyBuffer
+{
+    uint b_key_buffer[];
+};
+
+layout(std430, binding = 1) buffer BucketCountBuffer
+{
+    uint b_bucket_count_buffer[];
+};
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    bool shared_buckets = u_num_buckets <= NUM_SHARED_BUCKETS;
+
+    clear_shared_buckets();
+
+    barrier();
+
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        uint i = (workgroup_i * NUM_ITEMS + item_i) * NUM_THREADS + gl_LocalInvocationIndex;
+        bool has_key = i < u_count;
+        uint bucket = has_key ? get_bucket(b_key_buffer[i]) : 0;
+
+        // The first invocation of every bucket counts the keys of the subgroup
+        uvec4 match = match_bucket(has_key, bucket);
+        if (has_key && gl_SubgroupInvocationID == subgroupBallotFindLSB(match))
+        {
+            uint bucket_count = subgroupBallotBitCount(match);
+            if (shared_buckets) atomicAdd(s_bucket_buffer[bucket], bucket_count);
+            else atomicAdd(b_bucket_count_buffer[bucket], bucket_count);
+        }
+    }
+
+    barrier();
+
+    if (shared_buckets)
+    {
+        for (uint bucket = gl_LocalInvocationIndex; bucket < u_num_buckets; bucket += NUM_THREADS)
+        {
+            uint bucket_count = s_bucket_buffer[bucket];
+            if (bucket_count > 0) atomicAdd(b_bucket_count_buffer[bucket], bucket_count);
+        }
+    }
+}
+)";
+
+        /// Every key takes an index in its bucket: the first invocation of the bucket in the subgroup reserves the
+        /// indices of the subgroup (from the workgroup range, reserved from the bucket cursor afterwards, if the
+        /// buckets fit the shared memory), and the others follow it in the order of the subgroup.
+        inline const char* k_counting_sort_scatter_shader = R"(
+layout(std430, binding = 0) readonly buffer SrcKeyBuffer
+{
+    uint b_src_key_buffer[];
+};
+
+layout(std430, binding = 1) buffer BucketCursorBuffer
+{
+    uint b_bucket_cursor_buffer[]; // The next free index of every bucket, initially its offset
+};
+
+layout(std430, binding = 2) writeonly buffer DstKeyBuffer
+{
+    uint b_dst_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 3) readonly buffer SrcValBuffer
+{
+    uint b_src_val_buffer[];
+};
+
+layout(std430, binding = 4) writeonly buffer DstValBuffer
+{
+    uint b_dst_val_buffer[];
+};
+#endif
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    bool shared_buckets = u_num_buckets <= NUM_SHARED_BUCKETS;
+
+    clear_shared_buckets();
+
+    barrier();
+
+    uint keys[NUM_ITEMS];
+    uint ranks[NUM_ITEMS]; // The index in the bucket, or in the workgroup range of the bucket if shared_buckets
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        uint i = (workgroup_i * NUM_ITEMS + item_i) * NUM_THREADS + gl_LocalInvocationIndex;
+        bool has_key = i < u_count;
+        keys[item_i] = has_key ? b_src_key_buffer[i] : 0;
+        uint bucket = get_bucket(keys[item_i]);
+
+        uvec4 match = match_bucket(has_key, bucket);
+        uint first_invocation_i = subgroupBallotFindLSB(match);
+
+        uint subgroup_base = 0;
+        if (has_key && gl_SubgroupInvocationID == first_invocation_i)
+        {
+            uint bucket_count = subgroupBallotBitCount(match);
+            if (shared_buckets) subgroup_base = atomicAdd(s_bucket_buffer[bucket], bucket_count);
+            else subgroup_base = atomicAdd(b_bucket_cursor_buffer[bucket], bucket_count);
+        }
+
+        ranks[item_i] = subgroupShuffle(subgroup_base, first_invocation_i) + subgroupBallotExclusiveBitCount(match);
+    }
+
+    barrier();
+
+    if (shared_buckets)
+    {
+        // The workgroup range of every bucket
+        for (uint bucket = gl_LocalInvocationIndex; bucket < u_num_buckets; bucket += NUM_THREADS)
+        {
+            uint bucket_count = s_bucket_buffer[bucket];
+            if (bucket_count > 0) s_bucket_buffer[bucket] = atomicAdd(b_bucket_cursor_buffer[bucket], bucket_count);
+        }
+    }
+
+    barrier();
+
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        uint i = (workgroup_i * NUM_ITEMS + item_i) * NUM_THREADS + gl_LocalInvocationIndex;
+        if (i >= u_count) break;
+
+        uint di = ranks[item_i];
+        if (shared_buckets) di += s_bucket_buffer[get_bucket(keys[item_i])];
+
+        b_dst_key_buffer[di] = keys[item_i];
+#ifdef WITH_VALUES
+        b_dst_val_buffer[di] = b_src_val_buffer[i];
+#endif
+    }
+}
+)";
+    } // namespace detail
+
+    /// A class that sorts GLuint keys of a small known domain [0, num_buckets) (e.g. the cells of a grid) by a
+    /// counting sort: a histogram of the buckets, a prefix sum on it and a scatter, i.e. a single pass over the keys
+    /// instead of the steps of RadixSort. The offset of every bucket is output as well.
+    ///
+    /// Keys of the same bucket are moved by atomic cursors, reserved once per subgroup (or per workgroup, up to
+    /// 4096 buckets): their order within the bucket isn't preserved across subgroups (the sort isn't stable).
+    /// RadixSort with a bit range is the stable alternative.
+    class CountingSort
+    {
+    private:
+        const size_t m_num_threads;
+        const size_t m_num_items;
+        const size_t m_num_shared_buckets;
+
+        Program m_histogram_program;
+        Program m_scatter_program;
+        Program m_key_only_scatter_program;
+
+        BlellochScan m_blelloch_scan;
+
+        /// The counts of the buckets, then their offsets, then the next free index of every bucket (while scattering).
+        ShaderStorageBuffer m_bucket_offset_buffer;
+
+        ShaderStorageBuffer m_key_scratch_buffer;
+        ShaderStorageBuffer m_val_scratch_buffer;
+
+    public:
+        CountingSort() :
+            m_num_threads(256),
+            m_num_items(8),
+            m_num_shared_buckets(4096),
+            m_blelloch_scan(DataType_Uint)
+        {
+            GLint subgroup_features = 0;
+            glGetIntegerv(GL_SUBGROUP_SUPPORTED_FEATURES_KHR, &subgroup_features);
+            GLU_CHECK_STATE(subgroup_features & GL_SUBGROUP_FEATURE_BALLOT_BIT_KHR, "Subgroup ballot isn't supported");
+            GLU_CHECK_STATE(
+                subgroup_features & GL_SUBGROUP_FEATURE_SHUFFLE_BIT_KHR, "Subgroup shuffle isn't supported"
+            );
+
+            std::string shader_src = "#version 460\n\n";
+            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
+            shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
+            shader_src += std::string("#define NUM_SHARED_BUCKETS ") + std::to_string(m_num_shared_buckets) + "\n";
+            shader_src += detail::k_counting_sort_common_shader;
+
+            build_program(m_histogram_program, shader_src + detail::k_counting_sort_histogram_shader);
+            build_program(
+                m_scatter_program, shader_src + "#define WITH_VALUES\n" + detail::k_counting_sort_scatter_shader
+            );
+            build_program(m_key_only_scatter_program, shader_src + detail::k_counting_sort_scatter_shader);
+        }
+
+        ~CountingSort() = default;
+
+        /// Sorts the given keys (and values) by bucket, in place.
+        ///
+        /// @param key_buffer the GLuint keys, in [0, num_buckets): greater keys are sorted in the last bucket (keeping
+        ///                   their value)
+        /// @param val_buffer the GLuint values moved along with the keys, or 0 to sort the keys only
+        /// @param count the number of keys (and values)
+        /// @param num_buckets the size of the key domain
+        /// @param bucket_offset_buffer if not 0, a GLuint buffer where num_buckets + 1 offsets are written: the keys
+        ///                             of the i-th bucket span [offsets[i], offsets[i + 1]) once sorted. They can be
+        ///                             given to RadixSort::sort_segments to make the buckets ordered by another key
+        void operator()(
+            GLuint key_buffer, GLuint val_buffer, size_t count, size_t num_buckets, GLuint bucket_offset_buffer = 0
+        )
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+            GLU_CHECK_ARGUMENT(num_buckets > 0, "Num buckets must be greater than zero");
+
+            bool with_values = val_buffer != 0;
+
+            // ---------------------------------------------------------------- Histogram
+
+            size_t num_offsets = num_buckets + 1;
+            if (m_bucket_offset_buffer.size() < num_offsets * sizeof(GLuint))
+                m_bucket_offset_buffer.resize(num_offsets * sizeof(GLuint), false);
+
+            m_bucket_offset_buffer.clear(0);
+
+            size_t num_bucket_bits = 0; // The bits to tell the buckets apart
+            while ((size_t(1) << num_bucket_bits) < num_buckets)
+                num_bucket_bits++;
+
+            size_t num_workgroups = div_ceil(count, m_num_threads * m_num_items);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            size_t num_workgroups_y = div_ceil(num_workgroups, std::max<size_t>(num_workgroups_x, 1));
+
+            if (count > 0)
+            {
+                m_histogram_program.use();
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+                m_bucket_offset_buffer.bind(1);
+
+                set_bucket_uniforms(m_histogram_program, count, num_buckets, num_bucket_bits);
+
+                glDispatchCompute(num_workgroups_x, num_workgroups_y, 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            }
+
+            // ---------------------------------------------------------------- Prefix sum
+
+            m_blelloch_scan(m_bucket_offset_buffer.handle(), num_offsets);
+
+            if (bucket_offset_buffer)
+            {
+                glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+                copy_buffer(m_bucket_offset_buffer.handle(), bucket_offset_buffer, num_offsets * sizeof(GLuint));
+            }
+
+            if (count <= 1)
+                return;
+
+            // ---------------------------------------------------------------- Scatter
+
+            if (m_key_scratch_buffer.size() < count * sizeof(GLuint))
+                m_key_scratch_buffer.resize(count * sizeof(GLuint), false);
+            if (with_values && m_val_scratch_buffer.size() < count * sizeof(GLuint))
+                m_val_scratch_buffer.resize(count * sizeof(GLuint), false);
+
+            Program& scatter_program = with_values ? m_scatter_program : m_key_only_scatter_program;
+            scatter_program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, key_buffer);
+            m_bucket_offset_buffer.bind(1);
+            m_key_scratch_buffer.bind(2);
+            if (with_values)
+            {
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, val_buffer);
+                m_val_scratch_buffer.bind(4);
+            }
+
+            set_bucket_uniforms(scatter_program, count, num_buckets, num_bucket_bits);
+
+            glDispatchCompute(num_workgroups_x, num_workgroups_y, 1);
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+            copy_buffer(m_key_scratch_buffer.handle(), key_buffer, count * sizeof(GLuint));
+            if (with_values)
+                copy_buffer(m_val_scratch_buffer.handle(), val_buffer, count * sizeof(GLuint));
+        }
+
+    private:
+        static void set_bucket_uniforms(Program& program, size_t count, size_t num_buckets, size_t num_bucket_bits)
+        {
+            glUniform1ui(program.get_uniform_location("u_count"), count);
+            glUniform1ui(program.get_uniform_location("u_num_buckets"), num_buckets);
+            glUniform1ui(program.get_uniform_location("u_num_bucket_bits"), num_bucket_bits);
+        }
+
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_COUNTINGSORT_HPP
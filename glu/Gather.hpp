@@ -0,0 +1,125 @@
+#ifndef GLU_GATHER_HPP
+#define GLU_GATHER_HPP
+
+#include <algorithm>
+
+#include "gl_utils.hpp"
+
+namespace glu
+{
+    namespace detail
+    {
+        inline const char* k_gather_shader_src = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer SrcBuffer
+{
+    CHUNK_TYPE b_src_buffer[];
+};
+
+layout(std430, binding = 1) writeonly buffer DstBuffer
+{
+    CHUNK_TYPE b_dst_buffer[];
+};
+
+layout(std430, binding = 2) readonly buffer IndexBuffer
+{
+    uint b_index_buffer[];
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_num_element_chunks;
+
+void main()
+{
+    // A thread per chunk: consecutive threads move consecutive chunks of an element
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint chunk_i = workgroup_i * NUM_THREADS + gl_LocalInvocationIndex;
+
+    uint i = chunk_i / u_num_element_chunks;
+    if (i < u_count)
+    {
+        uint element_chunk_i = chunk_i % u_num_element_chunks;
+        b_dst_buffer[chunk_i] = b_src_buffer[b_index_buffer[i] * u_num_element_chunks + element_chunk_i];
+    }
+}
+)";
+    }
+
+    /// A class that applies a permutation to a buffer of elements of any size: dst[i] = src[index[i]].
+    /// Elements are moved by 16-byte chunks if their stride allows it, by 4-byte chunks otherwise.
+    class Gather
+    {
+    private:
+        const size_t m_num_threads;
+
+        Program m_uvec4_program;
+        Program m_uint_program;
+
+    public:
+        Gather() :
+            m_num_threads(256)
+        {
+            std::string shader_src = "#version 460\n\n";
+            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
+
+            { // uvec4 program
+                Shader shader(GL_COMPUTE_SHADER);
+                shader.source_from_str(shader_src + "#define CHUNK_TYPE uvec4\n" + detail::k_gather_shader_src);
+                shader.compile();
+
+                m_uvec4_program.attach_shader(shader);
+                m_uvec4_program.link();
+            }
+
+            { // uint program
+                Shader shader(GL_COMPUTE_SHADER);
+                shader.source_from_str(shader_src + "#define CHUNK_TYPE uint\n" + detail::k_gather_shader_src);
+                shader.compile();
+
+                m_uint_program.attach_shader(shader);
+                m_uint_program.link();
+            }
+        }
+
+        ~Gather() = default;
+
+        /// @param src_buffer the elements to read
+        /// @param dst_buffer where the permuted elements are written (can't be src_buffer)
+        /// @param index_buffer a GLuint buffer of count indices into src_buffer (e.g. output by RadixSort::argsort)
+        /// @param count the number of elements to write
+        /// @param stride the size of an element in bytes, must be a multiple of 4
+        void operator()(GLuint src_buffer, GLuint dst_buffer, GLuint index_buffer, size_t count, size_t stride)
+        {
+            GLU_CHECK_ARGUMENT(src_buffer, "Invalid src buffer");
+            GLU_CHECK_ARGUMENT(dst_buffer, "Invalid dst buffer");
+            GLU_CHECK_ARGUMENT(src_buffer != dst_buffer, "Src and dst buffer must be different");
+            GLU_CHECK_ARGUMENT(index_buffer, "Invalid index buffer");
+            GLU_CHECK_ARGUMENT(stride > 0 && stride % 4 == 0, "Stride must be a non-zero multiple of 4: %zu", stride);
+
+            if (count == 0)
+                return;
+
+            size_t chunk_size = stride % 16 == 0 ? 16 : 4;
+            size_t num_element_chunks = stride / chunk_size;
+
+            Program& program = chunk_size == 16 ? m_uvec4_program : m_uint_program;
+            program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, dst_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, index_buffer);
+
+            glUniform1ui(program.get_uniform_location("u_count"), count);
+            glUniform1ui(program.get_uniform_location("u_num_element_chunks"), num_element_chunks);
+
+            // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(count * num_element_chunks, m_num_threads);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+    };
+} // namespace glu
+
+#endif // GLU_GATHER_HPP
@@ -0,0 +1,243 @@
+#ifndef GLU_MERGE_HPP
+#define GLU_MERGE_HPP
+
+#include <algorithm>
+
+#include "data_types.hpp"
+#include "gl_utils.hpp"
+#include "radix_sort_common.hpp"
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Every thread writes NUM_ITEMS consecutive elements of the output. Its first element lies on a diagonal of
+        /// the merge path (the grid of the elements of A by those of B), whose crossing point is found by a binary
+        /// search: how many elements of A and B precede it. The NUM_ITEMS elements are then merged sequentially.
+        inline const char* k_merge_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer AKeyBuffer
+{
+    KEY_TYPE b_a_key_buffer[];
+};
+
+layout(std430, binding = 1) readonly buffer BKeyBuffer
+{
+    KEY_TYPE b_b_key_buffer[];
+};
+
+layout(std430, binding = 2) writeonly buffer DstKeyBuffer
+{
+    KEY_TYPE b_dst_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 3) readonly buffer AValBuffer
+{
+    uint b_a_val_buffer[];
+};
+
+layout(std430, binding = 4) readonly buffer BValBuffer
+{
+    uint b_b_val_buffer[];
+};
+
+layout(std430, binding = 5) writeonly buffer DstValBuffer
+{
+    uint b_dst_val_buffer[];
+};
+#endif
+
+layout(location = 0) uniform uint u_a_count;
+layout(location = 1) uniform uint u_b_count;
+
+void main()
+{
+    uint workgroup_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint thread_i = workgroup_i * NUM_THREADS + gl_LocalInvocationIndex;
+
+    uint count = u_a_count + u_b_count;
+    uint diagonal = thread_i * NUM_ITEMS;
+    if (diagonal >= count) return;
+
+    // The number of elements of A preceding the diagonal
+    uint lo = diagonal > u_b_count ? diagonal - u_b_count : 0;
+    uint hi = min(diagonal, u_a_count);
+    while (lo < hi)
+    {
+        uint mid = (lo + hi) / 2;
+        if (precedes(b_b_key_buffer[diagonal - 1 - mid], b_a_key_buffer[mid])) hi = mid;
+        else lo = mid + 1;
+    }
+
+    uint a_i = lo;
+    uint b_i = diagonal - lo;
+
+    uint end_i = min(diagonal + NUM_ITEMS, count);
+    for (uint i = diagonal; i < end_i; i++)
+    {
+        // Keys of A are placed before the equal keys of B (stable merge)
+        bool from_a = b_i >= u_b_count ||
+                      (a_i < u_a_count && !precedes(b_b_key_buffer[b_i], b_a_key_buffer[a_i]));
+        if (from_a)
+        {
+            b_dst_key_buffer[i] = b_a_key_buffer[a_i];
+#ifdef WITH_VALUES
+            b_dst_val_buffer[i] = b_a_val_buffer[a_i];
+#endif
+            a_i++;
+        }
+        else
+        {
+            b_dst_key_buffer[i] = b_b_key_buffer[b_i];
+#ifdef WITH_VALUES
+            b_dst_val_buffer[i] = b_b_val_buffer[b_i];
+#endif
+            b_i++;
+        }
+    }
+}
+)";
+    } // namespace detail
+
+    /// A class that merges two buffers of keys (and values) sorted in the same order into a sorted buffer, with
+    /// merge-path partitioning: every thread finds by a binary search where its part of the output starts in both
+    /// inputs, so that all the threads merge independently. The merge is stable: keys of A are placed before the equal
+    /// keys of B. Keys are compared the way RadixSort orders them.
+    class Merge
+    {
+    private:
+        const size_t m_num_threads;
+
+        /// The number of elements written by every thread.
+        const size_t m_num_items;
+
+        /// The type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or DataType_Double.
+        const DataType m_key_data_type;
+
+        const SortOrder m_order;
+
+        Program m_program;
+        Program m_key_only_program;
+
+    public:
+        /// @param key_data_type the type of the keys: DataType_Uint, DataType_Int, DataType_Float, DataType_UVec2 or
+        ///                      DataType_Double
+        /// @param order the order both inputs are sorted in
+        explicit Merge(DataType key_data_type = DataType_Uint, SortOrder order = SortOrder_Ascending) :
+            m_num_threads(256),
+            m_num_items(8),
+            m_key_data_type(key_data_type),
+            m_order(order)
+        {
+            GLU_CHECK_ARGUMENT(
+                m_key_data_type == DataType_Uint || m_key_data_type == DataType_Int ||
+                    m_key_data_type == DataType_Float || m_key_data_type == DataType_UVec2 ||
+                    m_key_data_type == DataType_Double,
+                "Invalid key data type: %d",
+                m_key_data_type
+            );
+
+            size_t key_size = get_data_type_size(m_key_data_type);
+
+            std::string shader_src = "#version 460\n\n";
+            shader_src += "#define NUM_THREADS " + std::to_string(m_num_threads) + "\n";
+            shader_src += "#define NUM_ITEMS " + std::to_string(m_num_items) + "\n";
+            shader_src += std::string("#define KEY_TYPE ") + (key_size == 8 ? "uvec2" : "uint") + "\n";
+            shader_src += "#define KEY_NUM_BITS " + std::to_string(key_size * 8) + "\n";
+            if (m_key_data_type == DataType_Int)
+                shader_src += "#define SIGNED_KEYS\n";
+            else if (m_key_data_type == DataType_Float || m_key_data_type == DataType_Double)
+                shader_src += "#define FLOAT_KEYS\n";
+            if (m_key_data_type != DataType_Uint && m_key_data_type != DataType_UVec2)
+                shader_src += "#define TRANSFORM_KEYS\n";
+            if (m_order == SortOrder_Descending)
+                shader_src += "#define DESCENDING\n";
+            shader_src += detail::k_radix_sort_common_shader;
+
+            build_program(m_program, shader_src + "#define WITH_VALUES\n" + detail::k_merge_shader);
+            build_program(m_key_only_program, shader_src + detail::k_merge_shader);
+        }
+
+        ~Merge() = default;
+
+        [[nodiscard]] DataType key_data_type() const { return m_key_data_type; }
+        [[nodiscard]] SortOrder order() const { return m_order; }
+
+        /// Merges A and B into dst, which can't be either of them.
+        ///
+        /// @param a_key_buffer the sorted keys of A
+        /// @param a_val_buffer the GLuint values of A, or 0 to merge the keys only
+        /// @param a_count the number of keys of A
+        /// @param b_key_buffer the sorted keys of B
+        /// @param b_val_buffer the GLuint values of B, or 0 to merge the keys only
+        /// @param b_count the number of keys of B
+        /// @param dst_key_buffer where the a_count + b_count merged keys are written
+        /// @param dst_val_buffer where the merged values are written, or 0 to merge the keys only
+        void operator()(
+            GLuint a_key_buffer,
+            GLuint a_val_buffer,
+            size_t a_count,
+            GLuint b_key_buffer,
+            GLuint b_val_buffer,
+            size_t b_count,
+            GLuint dst_key_buffer,
+            GLuint dst_val_buffer
+        )
+        {
+            GLU_CHECK_ARGUMENT(a_key_buffer, "Invalid A key buffer");
+            GLU_CHECK_ARGUMENT(b_key_buffer, "Invalid B key buffer");
+            GLU_CHECK_ARGUMENT(dst_key_buffer, "Invalid dst key buffer");
+            GLU_CHECK_ARGUMENT(
+                dst_key_buffer != a_key_buffer && dst_key_buffer != b_key_buffer,
+                "Dst key buffer must differ from the inputs"
+            );
+
+            bool with_values = dst_val_buffer != 0;
+            GLU_CHECK_ARGUMENT(
+                with_values == (a_val_buffer != 0) && with_values == (b_val_buffer != 0),
+                "Either all the value buffers or none must be given"
+            );
+
+            size_t count = a_count + b_count;
+            if (count == 0)
+                return;
+
+            Program& program = with_values ? m_program : m_key_only_program;
+            program.use();
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, a_key_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, b_key_buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, dst_key_buffer);
+            if (with_values)
+            {
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, a_val_buffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, b_val_buffer);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, dst_val_buffer);
+            }
+
+            glUniform1ui(program.get_uniform_location("u_a_count"), a_count);
+            glUniform1ui(program.get_uniform_location("u_b_count"), b_count);
+
+            // Workgroups on two dimensions, as the guaranteed max workgroup count is 65535
+            size_t num_workgroups = div_ceil(div_ceil(count, m_num_items), m_num_threads);
+            size_t num_workgroups_x = std::min<size_t>(num_workgroups, 65535);
+            glDispatchCompute(num_workgroups_x, div_ceil(num_workgroups, num_workgroups_x), 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+    private:
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_MERGE_HPP
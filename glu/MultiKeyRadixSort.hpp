@@ -0,0 +1,168 @@
+#ifndef GLU_MULTIKEYRADIXSORT_HPP
+#define GLU_MULTIKEYRADIXSORT_HPP
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Gather.hpp"
+#include "RadixSort.hpp"
+
+namespace glu
+{
+    /// A class that sorts by composite keys whose components live in separate buffers, in lexicographic order (the
+    /// first component is the most significant). Components are sorted least significant first, carrying a single
+    /// permutation: the least significant one is argsorted, then every next one is gathered by the permutation so far
+    /// and sorted along with it (stably, so that the order of the previous components is kept). Every pass thus moves
+    /// a component and the permutation only, however many components and values there are; the other components and
+    /// the values are gathered once, by the final permutation.
+    ///
+    /// Components can be of any RadixSort key data type (e.g. DataType_UVec2 for 64-bit keys).
+    class MultiKeyRadixSort
+    {
+    private:
+        const std::vector<DataType> m_key_data_types;
+        const size_t m_num_val_buffers;
+
+        /// A RadixSort per key data type, shared by all the components of that type.
+        std::unordered_map<DataType, std::unique_ptr<RadixSort>> m_radix_sorts;
+
+        Gather m_gather;
+
+        /// The permutation that sorts the keys by the components sorted so far.
+        ShaderStorageBuffer m_index_buffer;
+
+        /// The component being sorted (in the order of the permutation), then every gathered buffer before being
+        /// copied back.
+        ShaderStorageBuffer m_scratch_buffer;
+
+    public:
+        /// @param key_data_types the type of every key component, most significant first
+        /// @param num_val_buffers the number of GLuint value buffers moved along with the keys
+        /// @param num_bits_per_step the number of bits sorted by every step
+        explicit MultiKeyRadixSort(
+            const std::vector<DataType>& key_data_types, size_t num_val_buffers = 0, size_t num_bits_per_step = 4
+        ) :
+            m_key_data_types(key_data_types),
+            m_num_val_buffers(num_val_buffers)
+        {
+            GLU_CHECK_ARGUMENT(!m_key_data_types.empty(), "At least a key component is required");
+
+            for (DataType key_data_type : m_key_data_types)
+            {
+                GLU_CHECK_ARGUMENT(
+                    key_data_type == DataType_Uint || key_data_type == DataType_Int ||
+                        key_data_type == DataType_Float || key_data_type == DataType_UVec2 ||
+                        key_data_type == DataType_Double,
+                    "Invalid key component data type: %d",
+                    key_data_type
+                );
+
+                if (m_radix_sorts.count(key_data_type) == 0)
+                {
+                    RadixSortOptions options;
+                    options.num_bits_per_step = num_bits_per_step;
+                    options.key_data_type = key_data_type;
+                    m_radix_sorts.emplace(key_data_type, std::make_unique<RadixSort>(options));
+                }
+            }
+        }
+
+        ~MultiKeyRadixSort() = default;
+
+        /// Sorts the keys (and values) by the composite key. The components are sorted in place as well.
+        ///
+        /// @param key_buffers the buffer of every key component, most significant first
+        /// @param num_key_bits the number of significant (low) bits of every component, 0 for all of them. Only
+        ///                     unsigned components (DataType_Uint, DataType_UVec2) can have fewer significant bits
+        /// @param val_buffers the GLuint value buffers, as many as num_val_buffers
+        /// @param count the number of keys
+        void operator()(
+            const std::vector<GLuint>& key_buffers,
+            const std::vector<size_t>& num_key_bits,
+            const std::vector<GLuint>& val_buffers,
+            size_t count
+        )
+        {
+            size_t num_components = m_key_data_types.size();
+
+            GLU_CHECK_ARGUMENT(key_buffers.size() == num_components, "Expected %zu key buffers", num_components);
+            GLU_CHECK_ARGUMENT(num_key_bits.size() == num_components, "Expected %zu key bit counts", num_components);
+            GLU_CHECK_ARGUMENT(val_buffers.size() == m_num_val_buffers, "Expected %zu val buffers", m_num_val_buffers);
+
+            size_t max_key_size = sizeof(GLuint); // Values are gathered through the scratch buffer as well
+            for (size_t k = 0; k < num_components; k++)
+            {
+                DataType key_data_type = m_key_data_types[k];
+                size_t key_size = get_data_type_size(key_data_type);
+                bool is_unsigned = key_data_type == DataType_Uint || key_data_type == DataType_UVec2;
+
+                GLU_CHECK_ARGUMENT(key_buffers[k], "Invalid key buffer");
+                GLU_CHECK_ARGUMENT(
+                    num_key_bits[k] <= key_size * 8 &&
+                        (is_unsigned || num_key_bits[k] == 0 || num_key_bits[k] == key_size * 8),
+                    "Invalid number of bits for the key component %zu: %zu",
+                    k,
+                    num_key_bits[k]
+                );
+
+                max_key_size = std::max(max_key_size, key_size);
+            }
+
+            if (count == 0)
+                return;
+
+            if (m_index_buffer.size() < count * sizeof(GLuint))
+                m_index_buffer.resize(count * sizeof(GLuint), false);
+            if (m_scratch_buffer.size() < count * max_key_size)
+                m_scratch_buffer.resize(count * max_key_size, false);
+
+            // ---------------------------------------------------------------- Permutation
+
+            // Least significant component first: every pass is stable, so that it keeps the order of the previous ones
+            for (size_t k = num_components; k-- > 0;)
+            {
+                RadixSort& radix_sort = *m_radix_sorts.at(m_key_data_types[k]);
+                size_t key_size = get_data_type_size(m_key_data_types[k]);
+                BitRange bit_range{0, num_key_bits[k]};
+
+                if (k == num_components - 1)
+                {
+                    copy_buffer(key_buffers[k], m_scratch_buffer.handle(), count * key_size);
+                    radix_sort.argsort(m_scratch_buffer.handle(), m_index_buffer.handle(), count, bit_range);
+                }
+                else
+                {
+                    m_gather(key_buffers[k], m_scratch_buffer.handle(), m_index_buffer.handle(), count, key_size);
+                    radix_sort(m_scratch_buffer.handle(), m_index_buffer.handle(), count, bit_range);
+                }
+            }
+
+            // ---------------------------------------------------------------- Gather
+
+            // The most significant component was sorted by the last pass
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+            copy_buffer(m_scratch_buffer.handle(), key_buffers[0], count * get_data_type_size(m_key_data_types[0]));
+
+            for (size_t k = 1; k < num_components; k++)
+                permute(key_buffers[k], count, get_data_type_size(m_key_data_types[k]));
+            for (GLuint val_buffer : val_buffers)
+                permute(val_buffer, count, sizeof(GLuint));
+        }
+
+    private:
+        /// Applies the sorting permutation to the given buffer, in place.
+        void permute(GLuint buffer, size_t count, size_t stride)
+        {
+            GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
+
+            m_gather(buffer, m_scratch_buffer.handle(), m_index_buffer.handle(), count, stride);
+
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+            copy_buffer(m_scratch_buffer.handle(), buffer, count * stride);
+        }
+    };
+} // namespace glu
+
+#endif // GLU_MULTIKEYRADIXSORT_HPP
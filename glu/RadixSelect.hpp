@@ -0,0 +1,475 @@
+#ifndef GLU_RADIXSELECT_HPP
+#define GLU_RADIXSELECT_HPP
+
+#include <algorithm>
+#include <memory>
+
+#include "RadixSort.hpp"
+
+namespace glu
+{
+    namespace detail
+    {
+        /// The state of a selection, entirely on the GPU so that no step waits for a readback.
+        inline const char* k_radix_select_state_shader = R"(
+#define COUNTER_SELECTED 0
+#define COUNTER_CANDIDATES 1
+#define COUNTER_TIES 2
+
+layout(std430, binding = 1) buffer StateBuffer
+{
+    uint b_k_remaining; // How many keys are still to be selected among the candidates
+    uint b_selected_digit; // The digit of the k-th key at the current step
+    uint b_counters[3]; // Selected keys, next candidates, ties
+    uint b_num_candidates[2]; // One per candidate buffer
+    uint b_dispatch_args[6]; // The indirect dispatch over the candidates of every candidate buffer
+};
+)";
+
+        inline const char* k_radix_select_histogram_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer KeyBuffer
+{
+    KEY_TYPE b_key_buffer[];
+};
+
+layout(std430, binding = 2) buffer HistogramBuffer
+{
+    uint b_histogram_buffer[RADIX_SIZE];
+};
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_radix_shift;
+layout(location = 2) uniform bool u_first_step;
+layout(location = 3) uniform uint u_slot;
+
+shared uint s_count_buffer[RADIX_SIZE];
+
+void main()
+{
+    for (uint radix = gl_LocalInvocationIndex; radix < RADIX_SIZE; radix += NUM_THREADS)
+    {
+        s_count_buffer[radix] = 0;
+    }
+
+    barrier();
+
+    uint count = u_first_step ? u_count : b_num_candidates[u_slot];
+    for (uint i = gl_GlobalInvocationID.x; i < count; i += gl_NumWorkGroups.x * NUM_THREADS)
+    {
+        KEY_TYPE key = b_key_buffer[i];
+#ifdef TRANSFORM_KEYS
+        if (u_first_step) key = to_sortable_key(key);
+#endif
+        atomicAdd(s_count_buffer[get_key_radix(key, u_radix_shift, RADIX_SIZE - 1)], 1);
+    }
+
+    barrier();
+
+    for (uint radix = gl_LocalInvocationIndex; radix < RADIX_SIZE; radix += NUM_THREADS)
+    {
+        if (s_count_buffer[radix] > 0) atomicAdd(b_histogram_buffer[radix], s_count_buffer[radix]);
+    }
+}
+)";
+
+        /// Finds the digit of the k-th key among the candidates, and prepares the dispatch over the next candidates.
+        inline const char* k_radix_select_digit_shader = R"(
+layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 2) buffer HistogramBuffer
+{
+    uint b_histogram_buffer[RADIX_SIZE];
+};
+
+layout(location = 3) uniform uint u_slot;
+
+void main()
+{
+    uint k = b_k_remaining;
+    uint num_preceding_keys = 0;
+    uint digit = 0;
+    for (; digit < RADIX_SIZE - 1; digit++)
+    {
+        if (num_preceding_keys + b_histogram_buffer[digit] >= k) break;
+        num_preceding_keys += b_histogram_buffer[digit];
+    }
+
+    uint num_next_candidates = b_histogram_buffer[digit];
+
+    b_selected_digit = digit;
+    b_k_remaining = k - num_preceding_keys;
+    b_counters[COUNTER_CANDIDATES] = 0;
+    b_counters[COUNTER_TIES] = 0;
+
+    uint next_slot = 1 - u_slot;
+    b_num_candidates[next_slot] = num_next_candidates;
+    b_dispatch_args[next_slot * 3] = min((num_next_candidates + NUM_THREADS - 1) / NUM_THREADS, 65535u);
+    b_dispatch_args[next_slot * 3 + 1] = 1;
+    b_dispatch_args[next_slot * 3 + 2] = 1;
+
+    for (uint radix = 0; radix < RADIX_SIZE; radix++)
+    {
+        b_histogram_buffer[radix] = 0;
+    }
+}
+)";
+
+        /// Writes the keys preceding the selected digit to the output, and compacts the keys having it to the next
+        /// candidate buffer. On the last step, the candidates having the selected digit are equal to the k-th key: as
+        /// many as still required are written to the output.
+        inline const char* k_radix_select_compact_shader = R"(
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) readonly buffer SrcKeyBuffer
+{
+    KEY_TYPE b_src_key_buffer[];
+};
+
+layout(std430, binding = 4) writeonly buffer CandidateKeyBuffer
+{
+    KEY_TYPE b_candidate_key_buffer[];
+};
+
+layout(std430, binding = 6) writeonly buffer DstKeyBuffer
+{
+    KEY_TYPE b_dst_key_buffer[];
+};
+
+#ifdef WITH_VALUES
+layout(std430, binding = 3) readonly buffer SrcValBuffer
+{
+    uint b_src_val_buffer[];
+};
+
+layout(std430, binding = 5) writeonly buffer CandidateValBuffer
+{
+    uint b_candidate_val_buffer[];
+};
+
+layout(std430, binding = 7) writeonly buffer DstValBuffer
+{
+    uint b_dst_val_buffer[];
+};
+#endif
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_radix_shift;
+layout(location = 2) uniform bool u_first_step;
+layout(location = 3) uniform uint u_slot;
+layout(location = 4) uniform bool u_last_step;
+layout(location = 5) uniform uint u_k;
+#ifdef WITH_VALUES
+layout(location = 6) uniform bool u_iota_values; // Values are the index of the keys (first step)
+#endif
+
+/// Reserves an index of the given counter for every invocation of the subgroup whose flag is set, with a single
+/// atomic per subgroup.
+uint reserve_index(uint counter_i, bool flag)
+{
+    uvec4 ballot = subgroupBallot(flag);
+    uint base_i = 0;
+    if (subgroupElect()) base_i = atomicAdd(b_counters[counter_i], subgroupBallotBitCount(ballot));
+    return subgroupBroadcastFirst(base_i) + subgroupBallotExclusiveBitCount(ballot);
+}
+
+void write_selected(KEY_TYPE key, uint i, uint di)
+{
+#ifdef TRANSFORM_KEYS
+    b_dst_key_buffer[di] = from_sortable_key(key);
+#else
+    b_dst_key_buffer[di] = key;
+#endif
+#ifdef WITH_VALUES
+    b_dst_val_buffer[di] = u_iota_values ? i : b_src_val_buffer[i];
+#endif
+}
+
+void main()
+{
+    uint count = u_first_step ? u_count : b_num_candidates[u_slot];
+    uint selected_digit = b_selected_digit;
+    uint k_remaining = b_k_remaining;
+
+    // Whole workgroups iterate together, so that subgroup operations see all their invocations
+    uint stride = gl_NumWorkGroups.x * NUM_THREADS;
+    for (uint base_i = gl_WorkGroupID.x * NUM_THREADS; base_i < count; base_i += stride)
+    {
+        uint i = base_i + gl_LocalInvocationIndex;
+
+        KEY_TYPE key;
+        uint digit = RADIX_SIZE; // Out of range for invocations without key
+        if (i < count)
+        {
+            key = b_src_key_buffer[i];
+#ifdef TRANSFORM_KEYS
+            if (u_first_step) key = to_sortable_key(key);
+#endif
+            digit = get_key_radix(key, u_radix_shift, RADIX_SIZE - 1);
+        }
+
+        bool is_selected = digit < selected_digit;
+        bool has_selected_digit = digit == selected_digit;
+
+        uint selected_i = reserve_index(COUNTER_SELECTED, is_selected);
+        if (is_selected) write_selected(key, i, selected_i);
+
+        if (u_last_step)
+        {
+            uint tie_i = reserve_index(COUNTER_TIES, has_selected_digit);
+            if (has_selected_digit && tie_i < k_remaining) write_selected(key, i, u_k - k_remaining + tie_i);
+        }
+        else
+        {
+            uint candidate_i = reserve_index(COUNTER_CANDIDATES, has_selected_digit);
+            if (has_selected_digit)
+            {
+                b_candidate_key_buffer[candidate_i] = key;
+#ifdef WITH_VALUES
+                b_candidate_val_buffer[candidate_i] = u_iota_values ? i : b_src_val_buffer[i];
+#endif
+            }
+        }
+    }
+}
+)";
+    } // namespace detail
+
+    /// A class that selects the k smallest keys (or the k largest ones, in descending order) with their values,
+    /// without sorting the whole buffer. Keys are narrowed down digit by digit from the most significant one, using the
+    /// radixes of RadixSort: every step counts the digits of the candidate keys, finds the digit of the k-th key,
+    /// writes the keys preceding it to the output and compacts the keys having it as the next candidates. Only the
+    /// first step reads all the keys; the state of the selection never leaves the GPU (later steps are dispatched
+    /// indirectly over the candidates).
+    class RadixSelect
+    {
+    private:
+        const size_t m_num_threads;
+        const size_t m_num_bits_per_step;
+        const size_t m_radix_size;
+
+        /// The type of the keys: DataType_Uint, DataType_Int or DataType_Float.
+        const DataType m_key_data_type;
+
+        const SortOrder m_order;
+
+        Program m_histogram_program;
+        Program m_digit_program;
+        Program m_compact_program;
+        Program m_key_only_compact_program;
+
+        std::unique_ptr<RadixSort> m_radix_sort; // Built by the first selection to sort
+
+        ShaderStorageBuffer m_state_buffer;
+        ShaderStorageBuffer m_histogram_buffer;
+
+        /// The keys (and values) having the digits selected so far; the steps ping-pong between two buffers.
+        ShaderStorageBuffer m_candidate_key_buffers[2];
+        ShaderStorageBuffer m_candidate_val_buffers[2];
+
+        /// Where the indirect dispatch arguments of every candidate buffer are, in the state buffer.
+        static constexpr size_t k_dispatch_args_offset = 7 * sizeof(GLuint);
+
+    public:
+        /// @param key_data_type the type of the keys: DataType_Uint, DataType_Int or DataType_Float
+        /// @param order SortOrder_Ascending to select the k smallest keys, SortOrder_Descending for the k largest
+        explicit RadixSelect(DataType key_data_type = DataType_Uint, SortOrder order = SortOrder_Ascending) :
+            m_num_threads(256),
+            m_num_bits_per_step(8),
+            m_radix_size(size_t(1) << m_num_bits_per_step),
+            m_key_data_type(key_data_type),
+            m_order(order),
+            m_state_buffer(13 * sizeof(GLuint)),
+            m_histogram_buffer(m_radix_size * sizeof(GLuint))
+        {
+            GLU_CHECK_ARGUMENT(
+                m_key_data_type == DataType_Uint || m_key_data_type == DataType_Int ||
+                    m_key_data_type == DataType_Float,
+                "Invalid key data type: %d",
+                m_key_data_type
+            );
+
+            std::string shader_src = "#version 460\n";
+            shader_src += "#extension GL_KHR_shader_subgroup_ballot : require\n\n";
+            shader_src += "#define NUM_THREADS " + std::to_string(m_num_threads) + "\n";
+            shader_src += "#define NUM_BITS_PER_STEP " + std::to_string(m_num_bits_per_step) + "\n";
+            shader_src += "#define RADIX_SIZE " + std::to_string(m_radix_size) + "\n";
+            shader_src += "#define KEY_TYPE uint\n";
+            shader_src += "#define KEY_NUM_BITS 32\n";
+            if (m_key_data_type == DataType_Int)
+                shader_src += "#define SIGNED_KEYS\n";
+            else if (m_key_data_type == DataType_Float)
+                shader_src += "#define FLOAT_KEYS\n";
+            if (m_key_data_type != DataType_Uint)
+                shader_src += "#define TRANSFORM_KEYS\n";
+            if (m_order == SortOrder_Descending)
+                shader_src += "#define DESCENDING\n";
+            shader_src += detail::k_radix_sort_common_shader;
+            shader_src += detail::k_radix_select_state_shader;
+
+            build_program(m_histogram_program, shader_src + detail::k_radix_select_histogram_shader);
+            build_program(m_digit_program, shader_src + detail::k_radix_select_digit_shader);
+            build_program(
+                m_compact_program, shader_src + "#define WITH_VALUES\n" + detail::k_radix_select_compact_shader
+            );
+            build_program(m_key_only_compact_program, shader_src + detail::k_radix_select_compact_shader);
+
+            m_histogram_buffer.clear(0);
+        }
+
+        ~RadixSelect() = default;
+
+        /// Selects the k smallest keys (the k largest in descending order). Keys equal to the k-th one are selected in
+        /// no particular order.
+        ///
+        /// @param key_buffer the keys, left untouched
+        /// @param val_buffer the GLuint values of the keys, or 0 to select the index of the keys as their values
+        /// @param count the number of keys (and values)
+        /// @param k the number of keys to select
+        /// @param dst_key_buffer where the k selected keys are written
+        /// @param dst_val_buffer where the k values of the selected keys are written, or 0 to select the keys only
+        /// @param sorted if set, the selected keys (and values) are sorted; otherwise they're in no particular order
+        void operator()(
+            GLuint key_buffer,
+            GLuint val_buffer,
+            size_t count,
+            size_t k,
+            GLuint dst_key_buffer,
+            GLuint dst_val_buffer,
+            bool sorted = false
+        )
+        {
+            GLU_CHECK_ARGUMENT(key_buffer, "Invalid key buffer");
+            GLU_CHECK_ARGUMENT(dst_key_buffer, "Invalid dst key buffer");
+            GLU_CHECK_ARGUMENT(dst_key_buffer != key_buffer, "Dst and src key buffer must be different");
+            GLU_CHECK_ARGUMENT(k <= count, "Can't select %zu keys out of %zu", k, count);
+
+            if (k == 0)
+                return;
+
+            bool with_values = dst_val_buffer != 0;
+
+            // Every step can keep all the keys as candidates (e.g. if their high bits are the same)
+            for (size_t slot = 0; slot < 2; slot++)
+            {
+                if (m_candidate_key_buffers[slot].size() < count * sizeof(GLuint))
+                    m_candidate_key_buffers[slot].resize(count * sizeof(GLuint), false);
+                if (with_values && m_candidate_val_buffers[slot].size() < count * sizeof(GLuint))
+                    m_candidate_val_buffers[slot].resize(count * sizeof(GLuint), false);
+            }
+
+            GLuint state[13]{};
+            state[0] = k; // k remaining
+            state[5] = count; // Candidates of the first step
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_state_buffer.handle());
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(state), state);
+
+            glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_state_buffer.handle());
+
+            size_t num_steps = 32 / m_num_bits_per_step;
+            for (size_t step = 0; step < num_steps; step++)
+            {
+                size_t slot = step % 2;
+                bool first_step = step == 0;
+                bool last_step = step == num_steps - 1;
+                GLuint radix_shift = 32 - (step + 1) * m_num_bits_per_step;
+
+                GLuint src_key_buffer = first_step ? key_buffer : m_candidate_key_buffers[slot].handle();
+                GLuint src_val_buffer = first_step ? val_buffer : m_candidate_val_buffers[slot].handle();
+
+                // ---------------------------------------------------------------- Histogram
+
+                m_histogram_program.use();
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src_key_buffer);
+                m_state_buffer.bind(1);
+                m_histogram_buffer.bind(2);
+
+                glUniform1ui(m_histogram_program.get_uniform_location("u_count"), count);
+                glUniform1ui(m_histogram_program.get_uniform_location("u_radix_shift"), radix_shift);
+                glUniform1ui(m_histogram_program.get_uniform_location("u_first_step"), first_step);
+                glUniform1ui(m_histogram_program.get_uniform_location("u_slot"), slot);
+
+                dispatch_over_candidates(step, count);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+                // ---------------------------------------------------------------- Digit of the k-th key
+
+                m_digit_program.use();
+
+                glUniform1ui(m_digit_program.get_uniform_location("u_slot"), slot);
+
+                glDispatchCompute(1, 1, 1);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+                // ---------------------------------------------------------------- Compaction
+
+                Program& compact_program = with_values ? m_compact_program : m_key_only_compact_program;
+                compact_program.use();
+
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src_key_buffer);
+                m_candidate_key_buffers[1 - slot].bind(4);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, dst_key_buffer);
+                if (with_values)
+                {
+                    bool iota_values = first_step && val_buffer == 0;
+                    if (!iota_values)
+                        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, src_val_buffer);
+                    m_candidate_val_buffers[1 - slot].bind(5);
+                    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, dst_val_buffer);
+
+                    glUniform1ui(compact_program.get_uniform_location("u_iota_values"), iota_values);
+                }
+
+                glUniform1ui(compact_program.get_uniform_location("u_count"), count);
+                glUniform1ui(compact_program.get_uniform_location("u_radix_shift"), radix_shift);
+                glUniform1ui(compact_program.get_uniform_location("u_first_step"), first_step);
+                glUniform1ui(compact_program.get_uniform_location("u_slot"), slot);
+                glUniform1ui(compact_program.get_uniform_location("u_last_step"), last_step);
+                glUniform1ui(compact_program.get_uniform_location("u_k"), k);
+
+                dispatch_over_candidates(step, count);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            }
+
+            if (sorted)
+            {
+                if (!m_radix_sort)
+                {
+                    RadixSortOptions options;
+                    options.key_data_type = m_key_data_type;
+                    options.order = m_order;
+                    m_radix_sort = std::make_unique<RadixSort>(options);
+                }
+
+                if (with_values)
+                    (*m_radix_sort)(dst_key_buffer, dst_val_buffer, k);
+                else
+                    (*m_radix_sort)(dst_key_buffer, k);
+            }
+        }
+
+    private:
+        /// The first step runs over all the keys, the next ones over the candidates counted on the GPU.
+        void dispatch_over_candidates(size_t step, size_t count)
+        {
+            if (step == 0)
+                glDispatchCompute(std::min<size_t>(div_ceil(count, m_num_threads), 65535), 1, 1);
+            else
+                glDispatchComputeIndirect(k_dispatch_args_offset + (step % 2) * 3 * sizeof(GLuint));
+        }
+
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_RADIXSELECT_HPP
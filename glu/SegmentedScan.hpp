@@ -0,0 +1,428 @@
+#ifndef GLU_SEGMENTEDSCAN_HPP
+#define GLU_SEGMENTEDSCAN_HPP
+
+#include <algorithm>
+#include <string>
+
+#include "BlellochScan.hpp"
+
+namespace glu
+{
+    namespace detail
+    {
+        /// Elements are scanned as (head, value) pairs: combining two pairs restarts from the second one if it's a
+        /// head, so that no value crosses the start of a segment. This operator is associative, but has no subgroup
+        /// operation: subgroups scan it by shuffles (Hillis-Steele), the workgroup as BlellochScan does.
+        ///
+        /// If SEGMENT_OFFSETS, heads are found in the segment offsets: every thread binary searches the segment of its
+        /// first element, then walks the offsets along its consecutive elements. Otherwise, they're read as flags.
+        inline const char* k_segmented_scan_common_shader_src = R"(
+#extension GL_KHR_shader_subgroup_shuffle : require
+#extension GL_KHR_shader_subgroup_shuffle_relative : require
+
+layout(local_size_x = NUM_THREADS, local_size_y = 1, local_size_z = 1) in;
+
+layout(std430, binding = 0) buffer Buffer
+{
+    DATA_TYPE data[];
+};
+
+layout(std430, binding = 1) buffer BlockSumBuffer
+{
+    DATA_TYPE b_block_sum_buffer[]; // The sum of every block since its last head, then its exclusive prefix
+};
+
+layout(std430, binding = 2) buffer BlockHeadBuffer
+{
+    uint b_block_head_buffer[]; // Whether every block holds a head
+};
+
+#ifdef SEGMENT_OFFSETS
+layout(std430, binding = 3) readonly buffer SegmentOffsetBuffer
+{
+    uint b_segment_offset_buffer[]; // num_segments + 1
+};
+
+layout(location = 2) uniform uint u_num_segments;
+#else
+layout(std430, binding = 3) readonly buffer HeadFlagBuffer
+{
+    uint b_head_flag_buffer[]; // Non-zero where a segment starts
+};
+#endif
+
+layout(location = 0) uniform uint u_count;
+layout(location = 1) uniform uint u_num_blocks;
+
+struct SegmentValue
+{
+    uint head; // Whether a segment starts within the combined elements
+    DATA_TYPE value; // The combination of the elements since the last head
+};
+
+const SegmentValue k_identity = SegmentValue(0, IDENTITY);
+
+SegmentValue combine(SegmentValue a, SegmentValue b)
+{
+    return SegmentValue(a.head | b.head, b.head != 0 ? b.value : OPERATION(a.value, b.value));
+}
+
+#ifdef SEGMENT_OFFSETS
+uint g_segment_i; // The first offset not less than the last element checked
+
+/// Places the cursor of is_head on the element i.
+void seek_segment(uint i)
+{
+    uint lo = 0;
+    uint hi = u_num_segments + 1;
+    while (lo < hi)
+    {
+        uint mid = (lo + hi) / 2;
+        if (b_segment_offset_buffer[mid] < i) lo = mid + 1;
+        else hi = mid;
+    }
+    g_segment_i = lo;
+}
+
+/// Whether a segment starts at the element i, called with increasing indices.
+bool is_head(uint i)
+{
+    while (g_segment_i <= u_num_segments && b_segment_offset_buffer[g_segment_i] < i) g_segment_i++;
+    return g_segment_i <= u_num_segments && b_segment_offset_buffer[g_segment_i] == i;
+}
+#else
+void seek_segment(uint i) {}
+
+bool is_head(uint i)
+{
+    return b_head_flag_buffer[i] != 0;
+}
+#endif
+
+SegmentValue subgroup_inclusive_scan(SegmentValue x)
+{
+    for (uint delta = 1; delta < gl_SubgroupSize; delta <<= 1)
+    {
+        SegmentValue y = SegmentValue(subgroupShuffleUp(x.head, delta), subgroupShuffleUp(x.value, delta));
+        if (gl_SubgroupInvocationID >= delta) x = combine(y, x);
+    }
+    return x;
+}
+
+SegmentValue subgroup_shift(SegmentValue x)
+{
+    SegmentValue y = SegmentValue(subgroupShuffleUp(x.head, 1), subgroupShuffleUp(x.value, 1));
+    return gl_SubgroupInvocationID == 0 ? k_identity : y;
+}
+
+SegmentValue subgroup_last(SegmentValue x)
+{
+    return SegmentValue(
+        subgroupShuffle(x.head, gl_SubgroupSize - 1), subgroupShuffle(x.value, gl_SubgroupSize - 1)
+    );
+}
+
+shared SegmentValue s_subgroup_buffer[MAX_NUM_SUBGROUPS];
+shared SegmentValue s_total;
+
+/// Returns the exclusive scan of the pair of this thread, and writes the total of the workgroup to s_total.
+SegmentValue workgroup_exclusive_scan(SegmentValue x)
+{
+    SegmentValue inclusive = subgroup_inclusive_scan(x);
+    if (gl_SubgroupInvocationID == gl_SubgroupSize - 1) s_subgroup_buffer[gl_SubgroupID] = inclusive;
+
+    SegmentValue prefix = subgroup_shift(inclusive);
+
+    barrier();
+
+    if (gl_SubgroupID == 0)
+    {
+        SegmentValue carry = k_identity;
+        for (uint base_i = 0; base_i < gl_NumSubgroups; base_i += gl_SubgroupSize)
+        {
+            uint i = base_i + gl_SubgroupInvocationID;
+            SegmentValue sum = i < gl_NumSubgroups ? s_subgroup_buffer[i] : k_identity;
+            SegmentValue sum_inclusive = subgroup_inclusive_scan(sum);
+            if (i < gl_NumSubgroups) s_subgroup_buffer[i] = combine(carry, subgroup_shift(sum_inclusive));
+            carry = combine(carry, subgroup_last(sum_inclusive));
+        }
+        if (subgroupElect()) s_total = carry;
+    }
+
+    barrier();
+
+    return combine(s_subgroup_buffer[gl_SubgroupID], prefix);
+}
+)";
+
+        /// Phase 1: every workgroup reduces a tile of NUM_THREADS * NUM_ITEMS elements to its sum since its last head.
+        inline const char* k_segmented_scan_reduce_shader_src = R"(
+void main()
+{
+    uint block_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (block_i >= u_num_blocks) return; // The 2D dispatch may exceed the blocks (uniform per workgroup)
+
+    uint i = block_i * NUM_THREADS * NUM_ITEMS + gl_LocalInvocationIndex * NUM_ITEMS;
+
+    seek_segment(i);
+
+    SegmentValue thread_sum = k_identity;
+    for (uint item_i = 0; item_i < NUM_ITEMS && i + item_i < u_count; item_i++)
+    {
+        thread_sum = combine(thread_sum, SegmentValue(is_head(i + item_i) ? 1 : 0, data[i + item_i]));
+    }
+
+    workgroup_exclusive_scan(thread_sum);
+
+    if (gl_LocalInvocationIndex == 0)
+    {
+        b_block_sum_buffer[block_i] = s_total.value;
+        b_block_head_buffer[block_i] = s_total.head;
+    }
+}
+)";
+
+        /// Phase 2: a single workgroup scans the block sums, a tile at a time.
+        inline const char* k_segmented_scan_block_sums_shader_src = R"(
+void main()
+{
+    SegmentValue carry = k_identity;
+    for (uint tile_i = 0; tile_i < u_num_blocks; tile_i += NUM_THREADS * NUM_ITEMS)
+    {
+        uint i = tile_i + gl_LocalInvocationIndex * NUM_ITEMS;
+
+        SegmentValue items[NUM_ITEMS];
+        SegmentValue thread_sum = k_identity;
+        for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+        {
+            items[item_i] = i + item_i < u_num_blocks
+                                ? SegmentValue(b_block_head_buffer[i + item_i], b_block_sum_buffer[i + item_i])
+                                : k_identity;
+            thread_sum = combine(thread_sum, items[item_i]);
+        }
+
+        SegmentValue prefix = combine(carry, workgroup_exclusive_scan(thread_sum));
+        for (uint item_i = 0; item_i < NUM_ITEMS && i + item_i < u_num_blocks; item_i++)
+        {
+            b_block_sum_buffer[i + item_i] = prefix.value;
+            prefix = combine(prefix, items[item_i]);
+        }
+
+        carry = combine(carry, s_total);
+
+        barrier(); // s_total and s_subgroup_buffer are written again by the next tile
+    }
+}
+)";
+
+        /// Phase 3: every workgroup scans its tile, NUM_ITEMS consecutive elements per thread, starting from the
+        /// scanned sum of the blocks before it. Heads restart from IDENTITY (or from themselves if INCLUSIVE).
+        inline const char* k_segmented_scan_downsweep_shader_src = R"(
+void main()
+{
+    uint block_i = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    if (block_i >= u_num_blocks) return;
+
+    uint i = block_i * NUM_THREADS * NUM_ITEMS + gl_LocalInvocationIndex * NUM_ITEMS;
+
+    seek_segment(i);
+
+    SegmentValue items[NUM_ITEMS];
+    SegmentValue thread_sum = k_identity;
+    for (uint item_i = 0; item_i < NUM_ITEMS; item_i++)
+    {
+        bool in_range = i + item_i < u_count;
+        items[item_i] = in_range ? SegmentValue(is_head(i + item_i) ? 1 : 0, data[i + item_i]) : k_identity;
+        thread_sum = combine(thread_sum, items[item_i]);
+    }
+
+    SegmentValue block_prefix = SegmentValue(0, b_block_sum_buffer[block_i]);
+    SegmentValue prefix = combine(block_prefix, workgroup_exclusive_scan(thread_sum));
+    for (uint item_i = 0; item_i < NUM_ITEMS && i + item_i < u_count; item_i++)
+    {
+#ifdef INCLUSIVE
+        prefix = combine(prefix, items[item_i]);
+        data[i + item_i] = prefix.value;
+#else
+        data[i + item_i] = items[item_i].head != 0 ? IDENTITY : prefix.value;
+        prefix = combine(prefix, items[item_i]);
+#endif
+    }
+}
+)";
+    } // namespace detail
+
+    /// A class that implements a segmented prefix scan: every segment of a buffer is scanned independently, whatever
+    /// the lengths of the segments. Segments are given either by head flags (non-zero where a segment starts) or by
+    /// their offsets. It's the same reduce-then-scan as BlellochScan, 3 dispatches whatever the count, on pairs of a
+    /// head flag and a value.
+    class SegmentedScan
+    {
+    private:
+        const DataType m_data_type;
+        const ReduceOperator m_operator;
+        const ScanType m_scan_type;
+        const size_t m_num_threads;
+        const size_t m_num_items;
+
+        Program m_reduce_program;
+        Program m_offset_reduce_program;
+        Program m_block_sums_program;
+        Program m_downsweep_program;
+        Program m_offset_downsweep_program;
+
+        /// The sum of every block since its last head, then its exclusive prefix.
+        ShaderStorageBuffer m_block_sum_buffer;
+
+        /// Whether every block holds a head.
+        ShaderStorageBuffer m_block_head_buffer;
+
+    public:
+        /// @param data_type the type of the elements
+        /// @param operator_ the operator of the scan (ReduceOperator_Or only for integer data types)
+        /// @param scan_type whether the scan is exclusive (the first element of every segment is the identity) or
+        ///                  inclusive
+        explicit SegmentedScan(
+            DataType data_type,
+            ReduceOperator operator_ = ReduceOperator_Sum,
+            ScanType scan_type = ScanType_Exclusive
+        ) :
+            m_data_type(data_type),
+            m_operator(operator_),
+            m_scan_type(scan_type),
+            m_num_threads(1024),
+            m_num_items(4)
+        {
+            GLint subgroup_size = 0;
+            glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &subgroup_size);
+            GLU_CHECK_STATE(
+                subgroup_size > 0 && m_num_threads % subgroup_size == 0, "Unsupported subgroup size: %d", subgroup_size
+            );
+
+            std::string shader_src = "#version 460\n\n";
+
+            shader_src += std::string("#define DATA_TYPE ") + to_glsl_type_str(m_data_type) + "\n";
+            shader_src += detail::get_scan_operator_src(m_data_type, m_operator);
+            if (m_scan_type == ScanType_Inclusive)
+                shader_src += "#define INCLUSIVE\n";
+            shader_src += std::string("#define NUM_THREADS ") + std::to_string(m_num_threads) + "\n";
+            shader_src += std::string("#define NUM_ITEMS ") + std::to_string(m_num_items) + "\n";
+            shader_src += "#define MAX_NUM_SUBGROUPS " + std::to_string(m_num_threads / subgroup_size) + "\n";
+
+            std::string flag_src = shader_src + detail::k_segmented_scan_common_shader_src;
+            std::string offset_src =
+                shader_src + "#define SEGMENT_OFFSETS\n" + detail::k_segmented_scan_common_shader_src;
+
+            build_program(m_reduce_program, flag_src + detail::k_segmented_scan_reduce_shader_src);
+            build_program(m_offset_reduce_program, offset_src + detail::k_segmented_scan_reduce_shader_src);
+            build_program(m_block_sums_program, flag_src + detail::k_segmented_scan_block_sums_shader_src);
+            build_program(m_downsweep_program, flag_src + detail::k_segmented_scan_downsweep_shader_src);
+            build_program(m_offset_downsweep_program, offset_src + detail::k_segmented_scan_downsweep_shader_src);
+        }
+
+        ~SegmentedScan() = default;
+
+        /// Scans every segment of the buffer in place, segments being delimited by head flags. Elements before the
+        /// first head form a segment as well.
+        ///
+        /// @param buffer the input buffer (of the data type)
+        /// @param head_flag_buffer a GLuint per element, non-zero where a segment starts
+        /// @param count the number of elements (up to 2^30)
+        void operator()(GLuint buffer, GLuint head_flag_buffer, size_t count)
+        {
+            GLU_CHECK_ARGUMENT(head_flag_buffer, "Invalid head flag buffer");
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, head_flag_buffer);
+
+            scan(false, buffer, count, 0);
+        }
+
+        /// Scans every segment of the buffer in place, the i-th segment spanning [segment_offsets[i],
+        /// segment_offsets[i + 1]). Elements before the first offset form a segment as well.
+        ///
+        /// @param buffer the input buffer (of the data type)
+        /// @param segment_offset_buffer a GLuint buffer of num_segments + 1 offsets, non-decreasing
+        /// @param num_segments the number of segments
+        /// @param count the number of elements (up to 2^30), usually the last offset
+        void scan_segments(GLuint buffer, GLuint segment_offset_buffer, size_t num_segments, size_t count)
+        {
+            GLU_CHECK_ARGUMENT(segment_offset_buffer, "Invalid segment offset buffer");
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, segment_offset_buffer);
+
+            scan(true, buffer, count, num_segments);
+        }
+
+    private:
+        void scan(bool with_offsets, GLuint buffer, size_t count, size_t num_segments)
+        {
+            GLU_CHECK_ARGUMENT(buffer, "Invalid buffer");
+            GLU_CHECK_ARGUMENT(count <= (size_t(1) << 30), "Count must be at most 2^30");
+
+            if (count == 0)
+                return;
+
+            size_t num_blocks = div_ceil(count, m_num_threads * m_num_items);
+
+            if (m_block_sum_buffer.size() < num_blocks * get_data_type_size(m_data_type))
+                m_block_sum_buffer.resize(num_blocks * get_data_type_size(m_data_type), false);
+            if (m_block_head_buffer.size() < num_blocks * sizeof(GLuint))
+                m_block_head_buffer.resize(num_blocks * sizeof(GLuint), false);
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+            m_block_sum_buffer.bind(1);
+            m_block_head_buffer.bind(2);
+
+            // Blocks on two dimensions, as the guaranteed max workgroup count is 65535
+            size_t num_blocks_x = std::min<size_t>(num_blocks, 65535);
+            size_t num_blocks_y = div_ceil(num_blocks, num_blocks_x);
+
+            // ---------------------------------------------------------------- Reduce
+
+            Program& reduce_program = with_offsets ? m_offset_reduce_program : m_reduce_program;
+            reduce_program.use();
+
+            glUniform1ui(reduce_program.get_uniform_location("u_count"), count);
+            glUniform1ui(reduce_program.get_uniform_location("u_num_blocks"), num_blocks);
+            if (with_offsets)
+                glUniform1ui(reduce_program.get_uniform_location("u_num_segments"), num_segments);
+
+            glDispatchCompute(num_blocks_x, num_blocks_y, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // ---------------------------------------------------------------- Scan of block sums
+
+            m_block_sums_program.use();
+
+            glUniform1ui(m_block_sums_program.get_uniform_location("u_num_blocks"), num_blocks);
+
+            glDispatchCompute(1, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // ---------------------------------------------------------------- Downsweep
+
+            Program& downsweep_program = with_offsets ? m_offset_downsweep_program : m_downsweep_program;
+            downsweep_program.use();
+
+            glUniform1ui(downsweep_program.get_uniform_location("u_count"), count);
+            glUniform1ui(downsweep_program.get_uniform_location("u_num_blocks"), num_blocks);
+            if (with_offsets)
+                glUniform1ui(downsweep_program.get_uniform_location("u_num_segments"), num_segments);
+
+            glDispatchCompute(num_blocks_x, num_blocks_y, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        static void build_program(Program& program, const std::string& shader_src)
+        {
+            Shader shader(GL_COMPUTE_SHADER);
+            shader.source_from_str(shader_src);
+            shader.compile();
+
+            program.attach_shader(shader);
+            program.link();
+        }
+    };
+} // namespace glu
+
+#endif // GLU_SEGMENTEDSCAN_HPP
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cinttypes>
+#include <numeric>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <glad/glad.h>
+
+#include "glu/BitonicSort.hpp"
+#include "glu/RadixSort.hpp"
+#include "util/Random.hpp"
+
+using namespace glu;
+
+TEST_CASE("BitonicSort")
+{
+    const size_t k_num_elements = GENERATE(1, 7, 1000, 1024, 1025, 100000, 1000000);
+    const SortOrder k_order = GENERATE(SortOrder_Ascending, SortOrder_Descending);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Order: %d; Seed: %" PRIu64 "\n", k_num_elements, k_order, k_seed);
+
+    auto compare = [&](float a, float b) { return k_order == SortOrder_Ascending ? a < b : a > b; };
+
+    std::vector<float> keys(k_num_elements);
+    for (float& key : keys)
+        key = float(random.sample_int<GLint>(-1000000, 1000000)) / 1000.0f;
+
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    BitonicSort bitonic_sort(DataType_Float, k_order);
+    bitonic_sort(key_buffer.handle(), val_buffer.handle(), k_num_elements);
+
+    std::vector<float> sorted_keys = key_buffer.get_data<float>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    std::vector<float> expected_keys = keys;
+    std::sort(expected_keys.begin(), expected_keys.end(), compare);
+
+    // The sort isn't stable: values are only checked to move along with their key
+    REQUIRE(sorted_keys == expected_keys);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[sorted_vals[i]]);
+}
+
+TEST_CASE("BitonicSort-key-only")
+{
+    const size_t k_num_elements = GENERATE(1000, 100000, 1000000);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, UINT32_MAX);
+
+    ShaderStorageBuffer key_buffer(keys);
+
+    BitonicSort bitonic_sort;
+    bitonic_sort(key_buffer.handle(), 0, k_num_elements);
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+
+    std::sort(keys.begin(), keys.end());
+    REQUIRE(sorted_keys == keys);
+}
+
+TEST_CASE("BitonicSort-memory-budget")
+{
+    const size_t k_num_elements = 1000000;
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, UINT32_MAX);
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    // Any scratch buffer exceeds the budget: the keys are sorted in place
+    RadixSort radix_sort;
+    radix_sort.set_memory_budget(1);
+    radix_sort(key_buffer.handle(), val_buffer.handle(), k_num_elements);
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[sorted_vals[i]]);
+
+    std::sort(keys.begin(), keys.end());
+    REQUIRE(sorted_keys == keys);
+}
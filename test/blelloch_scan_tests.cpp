@@ -1,3 +1,8 @@
+#include <algorithm>
+#include <cinttypes>
+#include <limits>
+#include <numeric>
+
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
@@ -29,7 +34,7 @@ TEST_CASE("BlellochScan-multiple-sizes")
 {
     const uint64_t k_seed = 123;
     const size_t k_num_elements =
-        GENERATE(1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072, 262144, 524288, 1048576);
+        GENERATE(1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072, 262144, 524288, 1048576, 1, 3, 1000, 600000);
 
     Random random(k_seed);
 
@@ -48,7 +53,7 @@ TEST_CASE("BlellochScan-multiple-sizes")
 TEST_CASE("BlellochScan-multiple-partitions")
 {
     const uint64_t k_seed = 123;
-    const size_t k_num_elements = 1024;
+    const size_t k_num_elements = GENERATE(1024, 1000);
     const size_t k_num_partitions = GENERATE(1, 32, 100, 1000);
 
     Random random(k_seed);
@@ -81,6 +86,129 @@ TEST_CASE("BlellochScan-multiple-partitions")
     }
 }
 
+TEST_CASE("BlellochScan-many-blocks", "[.]")
+{
+    // Blocks are 4096 elements: more than 4096 blocks are scanned in multiple tiles, more than 65535 blocks are
+    // dispatched on two dimensions (with more workgroups than blocks). Hidden, as it takes 1GB on the host and device
+    const size_t k_num_elements = GENERATE(
+        4096 * 4096 + 1,        // 4097 blocks
+        65535 * 4096 + 3 * 4096 // 65538 blocks, 1GB
+    );
+
+    printf("Num elements: %zu\n", k_num_elements);
+
+    // A pattern rather than random values, as quicker to generate; its sum doesn't overflow
+    std::vector<GLuint> data(k_num_elements);
+    for (size_t i = 0; i < k_num_elements; i++)
+        data[i] = GLuint((i * 7 + i / 4096) % 5);
+
+    ShaderStorageBuffer buffer(data);
+
+    BlellochScan blelloch_scan(DataType_Uint);
+    blelloch_scan(buffer.handle(), k_num_elements);
+
+    std::exclusive_scan(data.begin(), data.end(), data.begin(), GLuint(0)); // In place, to spare the memory
+    REQUIRE(buffer.get_data<GLuint>() == data);
+}
+
+TEST_CASE("BlellochScan-operators")
+{
+    const uint64_t k_seed = 123;
+    const size_t k_num_elements = GENERATE(1, 1000, 100000);
+    const ReduceOperator k_operator =
+        GENERATE(ReduceOperator_Sum, ReduceOperator_Mul, ReduceOperator_Min, ReduceOperator_Max);
+    const ScanType k_scan_type = GENERATE(ScanType_Exclusive, ScanType_Inclusive);
+
+    printf(
+        "Num elements: %zu; Operator: %d; Scan type: %d; Seed: %" PRIu64 "\n",
+        k_num_elements,
+        k_operator,
+        k_scan_type,
+        k_seed
+    );
+
+    Random random(k_seed);
+
+    std::vector<GLint> data = random.sample_int_vector<GLint>(k_num_elements, -100, 100);
+
+    ShaderStorageBuffer buffer(data);
+
+    BlellochScan blelloch_scan(DataType_Int, k_operator, k_scan_type);
+    blelloch_scan(buffer.handle(), data.size());
+
+    // Sums and products wrap around, as on the GPU
+    auto operation = [&](GLint a, GLint b) -> GLint {
+        if (k_operator == ReduceOperator_Sum)
+            return GLint(GLuint(a) + GLuint(b));
+        else if (k_operator == ReduceOperator_Mul)
+            return GLint(GLuint(a) * GLuint(b));
+        else if (k_operator == ReduceOperator_Min)
+            return std::min(a, b);
+        else
+            return std::max(a, b);
+    };
+
+    GLint identity = k_operator == ReduceOperator_Sum   ? 0
+                     : k_operator == ReduceOperator_Mul ? 1
+                     : k_operator == ReduceOperator_Min ? std::numeric_limits<GLint>::max()
+                                                        : std::numeric_limits<GLint>::min();
+
+    std::vector<GLint> expected(k_num_elements);
+    GLint prefix = identity;
+    for (size_t i = 0; i < k_num_elements; i++)
+    {
+        if (k_scan_type == ScanType_Inclusive)
+            prefix = operation(prefix, data[i]);
+        expected[i] = prefix;
+        if (k_scan_type == ScanType_Exclusive)
+            prefix = operation(prefix, data[i]);
+    }
+
+    REQUIRE(buffer.get_data<GLint>() == expected);
+}
+
+TEST_CASE("BlellochScan-vectors")
+{
+    const uint64_t k_seed = 123;
+    const size_t k_num_elements = GENERATE(1000, 100000);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    Random random(k_seed);
+
+    // 4 interleaved sequences of integer floats, whose sums and maxima are exact
+    std::vector<float> data(k_num_elements * 4);
+    for (float& value : data)
+        value = float(random.sample_int<GLint>(-100, 100));
+
+    ShaderStorageBuffer sum_buffer(data);
+    ShaderStorageBuffer max_buffer(data);
+
+    BlellochScan sum_scan(DataType_Vec4, ReduceOperator_Sum, ScanType_Inclusive);
+    sum_scan(sum_buffer.handle(), k_num_elements);
+
+    BlellochScan max_scan(DataType_Vec4, ReduceOperator_Max, ScanType_Exclusive);
+    max_scan(max_buffer.handle(), k_num_elements);
+
+    std::vector<float> sums = sum_buffer.get_data<float>();
+    std::vector<float> maxima = max_buffer.get_data<float>();
+
+    for (size_t c = 0; c < 4; c++)
+    {
+        float sum = 0.0f;
+        float max = -std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < k_num_elements; i++)
+        {
+            REQUIRE(maxima[i * 4 + c] == max);
+
+            sum += data[i * 4 + c];
+            max = std::max(max, data[i * 4 + c]);
+
+            REQUIRE(sums[i * 4 + c] == sum);
+        }
+    }
+}
+
 TEST_CASE("BlellochScan-benchmark", "[.][benchmark]")
 {
     const size_t k_num_elements = GENERATE(
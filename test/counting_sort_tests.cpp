@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cinttypes>
+#include <numeric>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <glad/glad.h>
+
+#include "glu/CountingSort.hpp"
+#include "util/Random.hpp"
+
+using namespace glu;
+
+TEST_CASE("CountingSort")
+{
+    const size_t k_num_elements = GENERATE(1, 1000, 100000);
+    const size_t k_num_buckets = GENERATE(1, 100, 4096, 4097, 65536); // Up to 4096 in shared memory
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Num buckets: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_num_buckets, k_seed);
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, GLuint(k_num_buckets));
+
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+    ShaderStorageBuffer bucket_offset_buffer((k_num_buckets + 1) * sizeof(GLuint));
+
+    CountingSort counting_sort;
+    counting_sort(
+        key_buffer.handle(), val_buffer.handle(), k_num_elements, k_num_buckets, bucket_offset_buffer.handle()
+    );
+
+    std::vector<GLuint> bucket_offsets = bucket_offset_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> sorted_keys = keys;
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    for (size_t bucket = 0; bucket <= k_num_buckets; bucket++)
+    {
+        auto expected_offset = std::lower_bound(sorted_keys.begin(), sorted_keys.end(), GLuint(bucket));
+        REQUIRE(bucket_offsets[bucket] == GLuint(expected_offset - sorted_keys.begin()));
+    }
+
+    std::vector<GLuint> gpu_sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> gpu_sorted_vals = val_buffer.get_data<GLuint>();
+
+    REQUIRE(gpu_sorted_keys == sorted_keys);
+
+    // Values are a permutation that follows the keys (in any order within a bucket)
+    std::vector<GLuint> sorted_vals = gpu_sorted_vals;
+    std::sort(sorted_vals.begin(), sorted_vals.end());
+    REQUIRE(sorted_vals == vals);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(gpu_sorted_keys[i] == keys[gpu_sorted_vals[i]]);
+}
+
+TEST_CASE("CountingSort-out-of-range-keys")
+{
+    const size_t k_num_elements = GENERATE(1023, 100000);
+    const size_t k_num_buckets = GENERATE(1, 100, 65536);
+    const int k_duplicate_percentage = GENERATE(0, 90);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf(
+        "Num elements: %zu; Num buckets: %zu; Duplicate percentage: %d; Seed: %" PRIu64 "\n",
+        k_num_elements,
+        k_num_buckets,
+        k_duplicate_percentage,
+        k_seed
+    );
+
+    // Keys up to twice the domain, half of the duplicates in it and half past it
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, GLuint(k_num_buckets * 2));
+    for (GLuint& key : keys)
+    {
+        if (random.sample_int<int>(0, 100) < k_duplicate_percentage)
+            key = random.sample_int<int>(0, 2) == 0 ? GLuint(k_num_buckets / 2) : GLuint(k_num_buckets + 7);
+    }
+
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+    ShaderStorageBuffer bucket_offset_buffer((k_num_buckets + 1) * sizeof(GLuint));
+
+    CountingSort counting_sort;
+    counting_sort(
+        key_buffer.handle(), val_buffer.handle(), k_num_elements, k_num_buckets, bucket_offset_buffer.handle()
+    );
+
+    // Keys past the domain are counted in the last bucket
+    auto get_bucket = [&](GLuint key)
+    {
+        return std::min<GLuint>(key, GLuint(k_num_buckets - 1));
+    };
+
+    std::vector<GLuint> sorted_buckets(k_num_elements);
+    std::transform(keys.begin(), keys.end(), sorted_buckets.begin(), get_bucket);
+    std::sort(sorted_buckets.begin(), sorted_buckets.end());
+
+    std::vector<GLuint> bucket_offsets = bucket_offset_buffer.get_data<GLuint>();
+    for (size_t bucket = 0; bucket <= k_num_buckets; bucket++)
+    {
+        auto expected_offset = std::lower_bound(sorted_buckets.begin(), sorted_buckets.end(), GLuint(bucket));
+        REQUIRE(bucket_offsets[bucket] == GLuint(expected_offset - sorted_buckets.begin()));
+    }
+
+    std::vector<GLuint> gpu_sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> gpu_sorted_vals = val_buffer.get_data<GLuint>();
+
+    // The keys keep their value, and are sorted by bucket
+    std::vector<GLuint> gpu_sorted_buckets(k_num_elements);
+    std::transform(gpu_sorted_keys.begin(), gpu_sorted_keys.end(), gpu_sorted_buckets.begin(), get_bucket);
+    REQUIRE(gpu_sorted_buckets == sorted_buckets);
+
+    std::vector<GLuint> sorted_vals = gpu_sorted_vals;
+    std::sort(sorted_vals.begin(), sorted_vals.end());
+    REQUIRE(sorted_vals == vals);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(gpu_sorted_keys[i] == keys[gpu_sorted_vals[i]]);
+}
@@ -0,0 +1,47 @@
+#include <cinttypes>
+#include <numeric>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <glad/glad.h>
+
+#include "glu/Gather.hpp"
+#include "util/Random.hpp"
+
+using namespace glu;
+
+TEST_CASE("Gather")
+{
+    const size_t k_num_elements = GENERATE(1, 1000, 100000);
+    const size_t k_stride = GENERATE(4, 12, 16, 48);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Stride: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_stride, k_seed);
+
+    size_t num_element_uints = k_stride / sizeof(GLuint);
+
+    std::vector<GLuint> src = random.sample_int_vector<GLuint>(k_num_elements * num_element_uints, 0, UINT32_MAX);
+
+    // A random permutation
+    std::vector<GLuint> indices(k_num_elements);
+    std::iota(indices.begin(), indices.end(), 0);
+    for (size_t i = k_num_elements; i > 1; i--)
+        std::swap(indices[i - 1], indices[random.sample_int<size_t>(0, i)]);
+
+    ShaderStorageBuffer src_buffer(src);
+    ShaderStorageBuffer dst_buffer(src.size() * sizeof(GLuint));
+    ShaderStorageBuffer index_buffer(indices);
+
+    Gather gather;
+    gather(src_buffer.handle(), dst_buffer.handle(), index_buffer.handle(), k_num_elements, k_stride);
+
+    std::vector<GLuint> dst = dst_buffer.get_data<GLuint>();
+    for (size_t i = 0; i < k_num_elements; i++)
+    {
+        for (size_t j = 0; j < num_element_uints; j++)
+            REQUIRE(dst[i * num_element_uints + j] == src[indices[i] * num_element_uints + j]);
+    }
+}
@@ -0,0 +1,2 @@
+#include <glad/glad.h>
+#include "dist/CountingSort.hpp"
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cinttypes>
+#include <numeric>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <glad/glad.h>
+
+#include "glu/Merge.hpp"
+#include "util/Random.hpp"
+
+using namespace glu;
+
+TEST_CASE("Merge")
+{
+    const size_t k_a_count = GENERATE(0, 1, 1000, 100000);
+    const size_t k_b_count = GENERATE(1, 7, 100000);
+    const SortOrder k_order = GENERATE(SortOrder_Ascending, SortOrder_Descending);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("A count: %zu; B count: %zu; Order: %d; Seed: %" PRIu64 "\n", k_a_count, k_b_count, k_order, k_seed);
+
+    auto compare = [&](GLuint a, GLuint b) {
+        return k_order == SortOrder_Ascending ? GLint(a) < GLint(b) : GLint(a) > GLint(b);
+    };
+
+    // Few distinct keys, to check that keys of A are placed before the equal keys of B
+    std::vector<GLuint> a_keys = random.sample_int_vector<GLuint>(k_a_count, 0, 1000);
+    std::vector<GLuint> b_keys = random.sample_int_vector<GLuint>(k_b_count, 0, 1000);
+    for (GLuint& key : a_keys)
+        key = GLuint(GLint(key) - 500);
+    for (GLuint& key : b_keys)
+        key = GLuint(GLint(key) - 500);
+    std::sort(a_keys.begin(), a_keys.end(), compare);
+    std::sort(b_keys.begin(), b_keys.end(), compare);
+
+    std::vector<GLuint> a_vals(k_a_count);
+    std::iota(a_vals.begin(), a_vals.end(), 0);
+    std::vector<GLuint> b_vals(k_b_count);
+    std::iota(b_vals.begin(), b_vals.end(), GLuint(k_a_count));
+
+    // A buffer can't be empty
+    ShaderStorageBuffer a_key_buffer(k_a_count > 0 ? a_keys : std::vector<GLuint>{0});
+    ShaderStorageBuffer a_val_buffer(k_a_count > 0 ? a_vals : std::vector<GLuint>{0});
+    ShaderStorageBuffer b_key_buffer(b_keys);
+    ShaderStorageBuffer b_val_buffer(b_vals);
+    ShaderStorageBuffer dst_key_buffer((k_a_count + k_b_count) * sizeof(GLuint));
+    ShaderStorageBuffer dst_val_buffer((k_a_count + k_b_count) * sizeof(GLuint));
+
+    Merge merge(DataType_Int, k_order);
+    merge(
+        a_key_buffer.handle(),
+        a_val_buffer.handle(),
+        k_a_count,
+        b_key_buffer.handle(),
+        b_val_buffer.handle(),
+        k_b_count,
+        dst_key_buffer.handle(),
+        dst_val_buffer.handle()
+    );
+
+    std::vector<GLuint> merged_vals = dst_val_buffer.get_data<GLuint>();
+    std::vector<GLuint> merged_keys = dst_key_buffer.get_data<GLuint>();
+
+    // The stable merge of the keys, identified by their value
+    std::vector<GLuint> keys = a_keys;
+    keys.insert(keys.end(), b_keys.begin(), b_keys.end());
+    std::vector<GLuint> expected_vals(k_a_count + k_b_count);
+    std::merge(
+        a_vals.begin(),
+        a_vals.end(),
+        b_vals.begin(),
+        b_vals.end(),
+        expected_vals.begin(),
+        [&](GLuint a, GLuint b) { return compare(keys[a], keys[b]); }
+    );
+
+    REQUIRE(merged_vals == expected_vals);
+    for (size_t i = 0; i < merged_keys.size(); i++)
+        REQUIRE(merged_keys[i] == keys[merged_vals[i]]);
+}
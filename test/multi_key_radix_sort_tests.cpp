@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cinttypes>
+#include <numeric>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <glad/glad.h>
+
+#include "glu/MultiKeyRadixSort.hpp"
+#include "util/Random.hpp"
+
+using namespace glu;
+
+TEST_CASE("MultiKeyRadixSort")
+{
+    const size_t k_num_elements = GENERATE(1000, 100000);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    // Sort by (material_id, depth): few materials (10 bits), signed depths
+    std::vector<GLuint> material_ids = random.sample_int_vector<GLuint>(k_num_elements, 0, 16);
+    std::vector<GLuint> depths = random.sample_int_vector<GLuint>(k_num_elements, 0, 100);
+    for (GLuint& depth : depths)
+        depth = GLuint(GLint(depth) - 50);
+
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer material_id_buffer(material_ids);
+    ShaderStorageBuffer depth_buffer(depths);
+    ShaderStorageBuffer val_buffer(vals);
+
+    MultiKeyRadixSort multi_key_radix_sort({DataType_Uint, DataType_Int}, 1);
+    multi_key_radix_sort(
+        {material_id_buffer.handle(), depth_buffer.handle()}, {10, 0}, {val_buffer.handle()}, k_num_elements
+    );
+
+    std::vector<GLuint> sorted_material_ids = material_id_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_depths = depth_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_vals = vals;
+    std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) {
+        if (material_ids[a] != material_ids[b])
+            return material_ids[a] < material_ids[b];
+        return GLint(depths[a]) < GLint(depths[b]);
+    });
+
+    REQUIRE(sorted_vals == expected_vals);
+    for (size_t i = 0; i < k_num_elements; i++)
+    {
+        REQUIRE(sorted_material_ids[i] == material_ids[sorted_vals[i]]);
+        REQUIRE(sorted_depths[i] == depths[sorted_vals[i]]);
+    }
+}
+
+TEST_CASE("MultiKeyRadixSort-mixed-types")
+{
+    const size_t k_num_elements = GENERATE(1, 1000, 100000);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    // Sort by (object_id, distance, layer): 64-bit ids of few distinct values, float distances, 4-bit layers
+    std::vector<uint64_t> object_ids(k_num_elements);
+    for (uint64_t& object_id : object_ids)
+        object_id = (uint64_t(random.sample_int<GLuint>(0, 4)) << 40) | random.sample_int<GLuint>(0, 4);
+
+    std::vector<float> distances(k_num_elements);
+    for (float& distance : distances)
+        distance = float(random.sample_int<GLint>(-10, 10)) * 0.5f;
+
+    std::vector<GLuint> layers = random.sample_int_vector<GLuint>(k_num_elements, 0, 16);
+
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+    std::vector<GLuint> other_vals = random.sample_int_vector<GLuint>(k_num_elements, 0, UINT32_MAX);
+
+    ShaderStorageBuffer object_id_buffer(object_ids);
+    ShaderStorageBuffer distance_buffer(distances);
+    ShaderStorageBuffer layer_buffer(layers);
+    ShaderStorageBuffer val_buffer(vals);
+    ShaderStorageBuffer other_val_buffer(other_vals);
+
+    MultiKeyRadixSort multi_key_radix_sort({DataType_UVec2, DataType_Float, DataType_Uint}, 2);
+    multi_key_radix_sort(
+        {object_id_buffer.handle(), distance_buffer.handle(), layer_buffer.handle()},
+        {42, 0, 4},
+        {val_buffer.handle(), other_val_buffer.handle()},
+        k_num_elements
+    );
+
+    std::vector<uint64_t> sorted_object_ids = object_id_buffer.get_data<uint64_t>();
+    std::vector<float> sorted_distances = distance_buffer.get_data<float>();
+    std::vector<GLuint> sorted_layers = layer_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_other_vals = other_val_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_vals = vals;
+    std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) {
+        if (object_ids[a] != object_ids[b])
+            return object_ids[a] < object_ids[b];
+        if (distances[a] != distances[b])
+            return distances[a] < distances[b];
+        return layers[a] < layers[b];
+    });
+
+    REQUIRE(sorted_vals == expected_vals);
+    for (size_t i = 0; i < k_num_elements; i++)
+    {
+        REQUIRE(sorted_object_ids[i] == object_ids[sorted_vals[i]]);
+        REQUIRE(sorted_distances[i] == distances[sorted_vals[i]]);
+        REQUIRE(sorted_layers[i] == layers[sorted_vals[i]]);
+        REQUIRE(sorted_other_vals[i] == other_vals[sorted_vals[i]]);
+    }
+}
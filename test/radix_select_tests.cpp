@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cinttypes>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <glad/glad.h>
+
+#include "glu/RadixSelect.hpp"
+#include "util/Random.hpp"
+
+using namespace glu;
+
+TEST_CASE("RadixSelect")
+{
+    const size_t k_num_elements = GENERATE(1000, 100000);
+    const size_t k_k = GENERATE(1, 100, 1000);
+    const GLuint k_max_key = GENERATE(100, UINT32_MAX); // Many ties or few
+    const bool k_sorted = GENERATE(false, true);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf(
+        "Num elements: %zu; K: %zu; Max key: %u; Sorted: %d; Seed: %" PRIu64 "\n",
+        k_num_elements,
+        k_k,
+        k_max_key,
+        k_sorted,
+        k_seed
+    );
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, k_max_key);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer dst_key_buffer(k_k * sizeof(GLuint));
+    ShaderStorageBuffer dst_index_buffer(k_k * sizeof(GLuint));
+
+    RadixSelect radix_select;
+    radix_select(
+        key_buffer.handle(), 0, k_num_elements, k_k, dst_key_buffer.handle(), dst_index_buffer.handle(), k_sorted
+    );
+
+    std::vector<GLuint> selected_keys = dst_key_buffer.get_data<GLuint>();
+    std::vector<GLuint> selected_indices = dst_index_buffer.get_data<GLuint>();
+
+    // Every selected key comes from a distinct index
+    for (size_t i = 0; i < k_k; i++)
+        REQUIRE(selected_keys[i] == keys[selected_indices[i]]);
+
+    std::vector<GLuint> unique_indices = selected_indices;
+    std::sort(unique_indices.begin(), unique_indices.end());
+    REQUIRE(std::adjacent_find(unique_indices.begin(), unique_indices.end()) == unique_indices.end());
+
+    if (k_sorted)
+        REQUIRE(std::is_sorted(selected_keys.begin(), selected_keys.end()));
+    else
+        std::sort(selected_keys.begin(), selected_keys.end());
+
+    std::vector<GLuint> expected_keys = keys;
+    std::sort(expected_keys.begin(), expected_keys.end());
+    expected_keys.resize(k_k);
+
+    REQUIRE(selected_keys == expected_keys);
+}
+
+TEST_CASE("RadixSelect-descending-int-keys")
+{
+    const size_t k_num_elements = 100000;
+    const size_t k_k = GENERATE(1, 1000, 100000);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; K: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_k, k_seed);
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, 100000);
+    for (GLuint& key : keys)
+        key = GLuint(GLint(key) - 50000);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer dst_key_buffer(k_k * sizeof(GLuint));
+
+    RadixSelect radix_select(DataType_Int, SortOrder_Descending);
+    radix_select(key_buffer.handle(), 0, k_num_elements, k_k, dst_key_buffer.handle(), 0, true);
+
+    std::vector<GLuint> selected_keys = dst_key_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_keys = keys;
+    std::sort(expected_keys.begin(), expected_keys.end(), [](GLuint a, GLuint b) { return GLint(a) > GLint(b); });
+    expected_keys.resize(k_k);
+
+    REQUIRE(selected_keys == expected_keys);
+}
@@ -1,5 +1,8 @@
 #include <algorithm>
 #include <cinttypes>
+#include <cmath>
+#include <limits>
+#include <numeric>
 #include <unordered_map>
 #include <vector>
 
@@ -157,6 +160,916 @@ TEST_CASE("RadixSort-multiple-sizes")
     check_sorted(sorted_keys);
 }
 
+TEST_CASE("RadixSort-low-entropy-keys")
+{
+    const size_t k_num_elements = GENERATE(2, 3, 1025, 1026, 1027, 23857);
+    const DataType k_key_data_type = GENERATE(DataType_Uint, DataType_UVec2);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    // Few distinct keys: most of the keys of a block have the same radix
+    size_t key_size = get_data_type_size(k_key_data_type) / sizeof(GLuint);
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements * key_size, 0, 3);
+    if (key_size == 2)
+    {
+        for (size_t i = 1; i < keys.size(); i += 2)
+            keys[i] = 0; // High bits
+    }
+
+    ShaderStorageBuffer key_buffer(keys);
+
+    RadixSortOptions options;
+    options.key_data_type = k_key_data_type;
+    RadixSort radix_sort(options);
+    radix_sort(key_buffer.handle(), k_num_elements);
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_keys = keys;
+    if (key_size == 2)
+    {
+        for (size_t i = 0; i < k_num_elements; i++)
+            expected_keys[i] = keys[i * 2];
+        expected_keys.resize(k_num_elements);
+        std::sort(expected_keys.begin(), expected_keys.end());
+        for (size_t i = 0; i < k_num_elements; i++)
+        {
+            REQUIRE(sorted_keys[i * 2] == expected_keys[i]);
+            REQUIRE(sorted_keys[i * 2 + 1] == 0);
+        }
+    }
+    else
+    {
+        std::sort(expected_keys.begin(), expected_keys.end());
+        REQUIRE(sorted_keys == expected_keys);
+    }
+}
+
+TEST_CASE("RadixSort-subgroup-ranking")
+{
+    // Counts that aren't multiples of the subgroup size leave the last subgroup partly empty, above and below the
+    // local sort capacity; most keys sharing a digit fill a 16-bit subgroup count up to the subgroup size
+    const size_t k_num_elements = GENERATE(33, 1023, 1025, 23857, 100003, 1000001);
+    const size_t k_num_bits_per_step = GENERATE(4, 8);
+    const GLuint k_duplicate_percentage = GENERATE(50, 99, 100);
+    const RadixSortEngine k_engine = GENERATE(RadixSortEngine_MultiPass, RadixSortEngine_OneSweep);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf(
+        "Num elements: %zu; Num bits per step: %zu; Duplicates: %u%%; Seed: %" PRIu64 "\n",
+        k_num_elements,
+        k_num_bits_per_step,
+        k_duplicate_percentage,
+        k_seed
+    );
+
+    const GLuint k_duplicate_key = 0x5a5a5a5a;
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, UINT32_MAX);
+    for (GLuint& key : keys)
+    {
+        if (random.sample_int<GLuint>(0, 100) < k_duplicate_percentage)
+            key = k_duplicate_key;
+    }
+
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    RadixSortOptions options;
+    options.num_bits_per_step = k_num_bits_per_step;
+    options.engine = k_engine;
+    RadixSort radix_sort(options);
+    radix_sort(key_buffer.handle(), val_buffer.handle(), keys.size());
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    // The sort is stable: the values of equal keys keep their order
+    std::vector<GLuint> expected_vals = vals;
+    std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) { return keys[a] < keys[b]; });
+
+    REQUIRE(sorted_vals == expected_vals);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[sorted_vals[i]]);
+}
+
+TEST_CASE("RadixSort-local-sort")
+{
+    const DataType k_key_data_type = GENERATE(DataType_Uint, DataType_Int);
+
+    RadixSortOptions options;
+    options.key_data_type = k_key_data_type;
+    RadixSort radix_sort(options);
+
+    // Around the max count sorted on shared memory, so that both paths run
+    size_t capacity = radix_sort.local_sort_capacity();
+    const size_t k_num_elements = GENERATE_COPY(2, 100, 1000, capacity, capacity + 1);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Local sort capacity: %zu; Seed: %" PRIu64 "\n", k_num_elements, capacity, k_seed);
+
+    // Few distinct keys, to check the sort is stable
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, 64);
+    if (k_key_data_type == DataType_Int)
+    {
+        for (GLuint& key : keys)
+            key = GLuint(GLint(key) - 32);
+    }
+
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    radix_sort(key_buffer.handle(), val_buffer.handle(), keys.size());
+
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_vals = vals;
+    std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) {
+        if (k_key_data_type == DataType_Int)
+            return GLint(keys[a]) < GLint(keys[b]);
+        return keys[a] < keys[b];
+    });
+
+    REQUIRE(sorted_vals == expected_vals);
+}
+
+TEST_CASE("RadixSort-segments")
+{
+    const size_t k_num_segments = GENERATE(100, 5000);
+    const size_t k_num_large_segments = GENERATE(0, 1, 7);
+    const size_t k_end_bit = GENERATE(0, 12); // 12 bits take an odd number of steps
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf(
+        "Num segments: %zu; Num large segments: %zu; End bit: %zu; Seed: %" PRIu64 "\n",
+        k_num_segments,
+        k_num_large_segments,
+        k_end_bit,
+        k_seed
+    );
+
+    RadixSort radix_sort;
+
+    // Segments of random length (possibly empty), some of them not fitting the shared memory: they're sorted together
+    // by the multi-pass steps
+    std::vector<GLuint> segment_offsets(k_num_segments + 1, 0);
+    for (size_t i = 0; i < k_num_segments; i++)
+    {
+        GLuint length = random.sample_int<GLuint>(0, 300);
+        if (i % (k_num_segments / 8) == 1 && i / (k_num_segments / 8) < k_num_large_segments)
+            length = GLuint(radix_sort.local_sort_capacity() + random.sample_int<GLuint>(1, 50000));
+        segment_offsets[i + 1] = segment_offsets[i] + length;
+    }
+
+    size_t num_elements = segment_offsets[k_num_segments];
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(num_elements, 0, UINT32_MAX);
+    std::vector<GLuint> vals(num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+    ShaderStorageBuffer segment_offset_buffer(segment_offsets);
+
+    radix_sort.sort_segments(
+        key_buffer.handle(), val_buffer.handle(), segment_offset_buffer.handle(), k_num_segments, {0, k_end_bit}
+    );
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    const GLuint k_mask = k_end_bit == 0 ? UINT32_MAX : (1u << k_end_bit) - 1;
+
+    std::vector<GLuint> expected_vals = vals;
+    for (size_t i = 0; i < k_num_segments; i++)
+    {
+        std::stable_sort(
+            expected_vals.begin() + segment_offsets[i],
+            expected_vals.begin() + segment_offsets[i + 1],
+            [&](GLuint a, GLuint b) { return (keys[a] & k_mask) < (keys[b] & k_mask); }
+        );
+    }
+
+    REQUIRE(sorted_vals == expected_vals);
+    for (size_t i = 0; i < num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[sorted_vals[i]]);
+}
+
+TEST_CASE("RadixSort-argsort")
+{
+    const size_t k_num_elements = GENERATE(1, 1000, 23857, 1000000);
+    const DataType k_key_data_type = GENERATE(DataType_Uint, DataType_Int);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    // Few distinct keys, to check the permutation is stable
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, 1000);
+    if (k_key_data_type == DataType_Int)
+    {
+        for (GLuint& key : keys)
+            key = GLuint(GLint(key) - 500);
+    }
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer index_buffer(k_num_elements * sizeof(GLuint));
+
+    RadixSortOptions options;
+    options.key_data_type = k_key_data_type;
+    RadixSort radix_sort(options);
+    radix_sort.argsort(key_buffer.handle(), index_buffer.handle(), k_num_elements);
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> indices = index_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_indices(k_num_elements);
+    std::iota(expected_indices.begin(), expected_indices.end(), 0);
+    std::stable_sort(expected_indices.begin(), expected_indices.end(), [&](GLuint a, GLuint b) {
+        if (k_key_data_type == DataType_Int)
+            return GLint(keys[a]) < GLint(keys[b]);
+        return keys[a] < keys[b];
+    });
+
+    REQUIRE(indices == expected_indices);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[indices[i]]);
+}
+
+TEST_CASE("RadixSort-multiple-val-buffers")
+{
+    const size_t k_num_elements = GENERATE(1000, 100000);
+    const size_t k_num_val_buffers = GENERATE(2, 5);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Num val buffers: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_num_val_buffers, k_seed);
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, 1000);
+    ShaderStorageBuffer key_buffer(keys);
+
+    // Every value buffer holds the index, shifted by the index of the value buffer
+    std::vector<ShaderStorageBuffer> val_buffers;
+    std::vector<GLuint> val_buffer_handles;
+    for (size_t v = 0; v < k_num_val_buffers; v++)
+    {
+        std::vector<GLuint> vals(k_num_elements);
+        std::iota(vals.begin(), vals.end(), GLuint(v << 24));
+        val_buffers.emplace_back(vals);
+        val_buffer_handles.push_back(val_buffers.back().handle());
+    }
+
+    RadixSortOptions options;
+    options.num_val_buffers = k_num_val_buffers;
+    RadixSort radix_sort(options);
+    radix_sort(key_buffer.handle(), val_buffer_handles, k_num_elements);
+
+    std::vector<GLuint> expected_indices(k_num_elements);
+    std::iota(expected_indices.begin(), expected_indices.end(), 0);
+    std::stable_sort(expected_indices.begin(), expected_indices.end(), [&](GLuint a, GLuint b) {
+        return keys[a] < keys[b];
+    });
+
+    for (size_t v = 0; v < k_num_val_buffers; v++)
+    {
+        std::vector<GLuint> sorted_vals = val_buffers[v].get_data<GLuint>();
+        for (size_t i = 0; i < k_num_elements; i++)
+            REQUIRE(sorted_vals[i] == (GLuint(v << 24) | expected_indices[i]));
+    }
+}
+
+TEST_CASE("RadixSort-num-bits-per-step")
+{
+    const size_t k_num_bits_per_step = GENERATE(1, 3, 4, 5, 6, 8);
+    const size_t k_num_elements = GENERATE(1024, 23857);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf(
+        "Num bits per step: %zu; Num elements: %zu; Seed: %" PRIu64 "\n", k_num_bits_per_step, k_num_elements, k_seed
+    );
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, UINT32_MAX);
+    std::vector<GLuint> vals(k_num_elements);
+    for (size_t i = 0; i < k_num_elements; i++)
+        vals[i] = keys[i] ^ 0xdeadbeef;
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    RadixSortOptions options;
+    options.num_bits_per_step = k_num_bits_per_step;
+    RadixSort radix_sort(options);
+    radix_sort(key_buffer.handle(), val_buffer.handle(), keys.size());
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    check_permutation(keys, sorted_keys);
+    check_sorted(sorted_keys);
+
+    // Values must have followed their keys
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_vals[i] == (sorted_keys[i] ^ 0xdeadbeef));
+}
+
+TEST_CASE("RadixSort-key-only")
+{
+    const size_t k_num_elements = GENERATE(128, 2048, 23857, 47487);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, UINT32_MAX);
+
+    ShaderStorageBuffer key_buffer(keys);
+
+    RadixSort radix_sort;
+    radix_sort(key_buffer.handle(), keys.size());
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+
+    check_permutation(keys, sorted_keys);
+    check_sorted(sorted_keys);
+}
+
+TEST_CASE("RadixSort-64-bit-keys")
+{
+    const size_t k_num_bits_per_step = GENERATE(4, 6, 8);
+    const size_t k_num_elements = GENERATE(1024, 23857);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf(
+        "Num bits per step: %zu; Num elements: %zu; Seed: %" PRIu64 "\n", k_num_bits_per_step, k_num_elements, k_seed
+    );
+
+    std::vector<uint64_t> keys(k_num_elements);
+    std::vector<GLuint> vals(k_num_elements);
+    for (size_t i = 0; i < k_num_elements; i++)
+    {
+        keys[i] = (uint64_t(random.sample_int<GLuint>(0, UINT32_MAX)) << 32) | random.sample_int<GLuint>(0, UINT32_MAX);
+        vals[i] = GLuint(keys[i] >> 16);
+    }
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    RadixSortOptions options;
+    options.num_bits_per_step = k_num_bits_per_step;
+    options.key_data_type = DataType_UVec2;
+    RadixSort radix_sort(options);
+    radix_sort(key_buffer.handle(), val_buffer.handle(), keys.size());
+
+    std::vector<uint64_t> sorted_keys = key_buffer.get_data<uint64_t>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    check_permutation(keys, sorted_keys);
+    check_sorted(sorted_keys);
+
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_vals[i] == GLuint(sorted_keys[i] >> 16));
+}
+
+TEST_CASE("RadixSort-int-keys")
+{
+    const size_t k_num_elements = GENERATE(1024, 23857);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    std::vector<GLint> keys = random.sample_int_vector<GLint>(k_num_elements, -1000000000, 1000000000);
+
+    ShaderStorageBuffer key_buffer(keys);
+
+    RadixSortOptions options;
+    options.key_data_type = DataType_Int;
+    RadixSort radix_sort(options);
+    radix_sort(key_buffer.handle(), keys.size());
+
+    std::vector<GLint> sorted_keys = key_buffer.get_data<GLint>();
+
+    check_permutation(keys, sorted_keys);
+    check_sorted(sorted_keys);
+}
+
+TEST_CASE("RadixSort-float-keys")
+{
+    const size_t k_num_bits_per_step = GENERATE(4, 8);
+    const size_t k_num_elements = GENERATE(1024, 23857);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf(
+        "Num bits per step: %zu; Num elements: %zu; Seed: %" PRIu64 "\n", k_num_bits_per_step, k_num_elements, k_seed
+    );
+
+    std::vector<GLfloat> keys(k_num_elements);
+    std::vector<GLuint> vals(k_num_elements);
+    for (size_t i = 0; i < k_num_elements; i++)
+    {
+        keys[i] = float(random.sample_int<GLint>(-1000000, 1000000)) / 1000.0f;
+        vals[i] = GLuint(i);
+    }
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    RadixSortOptions options;
+    options.num_bits_per_step = k_num_bits_per_step;
+    options.key_data_type = DataType_Float;
+    RadixSort radix_sort(options);
+    radix_sort(key_buffer.handle(), val_buffer.handle(), keys.size());
+
+    std::vector<GLfloat> sorted_keys = key_buffer.get_data<GLfloat>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    check_sorted(sorted_keys);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[sorted_vals[i]]);
+}
+
+TEST_CASE("RadixSort-float-keys-special-values")
+{
+    const float k_inf = std::numeric_limits<float>::infinity();
+    const float k_nan = std::numeric_limits<float>::quiet_NaN();
+
+    const std::vector<GLfloat> keys{3.0f, k_nan, -k_inf, -0.5f, -k_nan, k_inf, 0.0f, -7.0f, 1e-40f, -1e-40f};
+
+    ShaderStorageBuffer key_buffer(keys);
+
+    RadixSortOptions options;
+    options.key_data_type = DataType_Float;
+    RadixSort radix_sort(options);
+    radix_sort(key_buffer.handle(), keys.size());
+
+    std::vector<GLfloat> sorted_keys = key_buffer.get_data<GLfloat>();
+
+    // NaNs are placed last, regardless of their sign
+    const std::vector<GLfloat> expected_keys{-k_inf, -7.0f, -0.5f, -1e-40f, 0.0f, 1e-40f, 3.0f, k_inf};
+    CHECK(std::vector<GLfloat>(sorted_keys.begin(), sorted_keys.begin() + 8) == expected_keys);
+    CHECK(std::isnan(sorted_keys[8]));
+    CHECK(std::isnan(sorted_keys[9]));
+}
+
+TEST_CASE("RadixSort-double-keys")
+{
+    const size_t k_num_elements = GENERATE(1024, 23857);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    std::vector<GLdouble> keys(k_num_elements);
+    for (size_t i = 0; i < k_num_elements; i++)
+        keys[i] = double(random.sample_int<GLint>(-1000000000, 1000000000)) / 1000.0;
+
+    ShaderStorageBuffer key_buffer(keys);
+
+    RadixSortOptions options;
+    options.num_bits_per_step = 8;
+    options.key_data_type = DataType_Double;
+    RadixSort radix_sort(options);
+    radix_sort(key_buffer.handle(), keys.size());
+
+    std::vector<GLdouble> sorted_keys = key_buffer.get_data<GLdouble>();
+
+    check_permutation(keys, sorted_keys);
+    check_sorted(sorted_keys);
+}
+
+TEST_CASE("RadixSort-bit-range")
+{
+    const size_t k_num_elements = GENERATE(1024, 23857);
+    const size_t k_begin_bit = GENERATE(0, 3, 8);
+    const size_t k_end_bit = GENERATE(13, 20, 32);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf(
+        "Num elements: %zu; Bit range: [%zu, %zu); Seed: %" PRIu64 "\n", k_num_elements, k_begin_bit, k_end_bit, k_seed
+    );
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, UINT32_MAX);
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    RadixSort radix_sort;
+    radix_sort(key_buffer.handle(), val_buffer.handle(), keys.size(), {k_begin_bit, k_end_bit});
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    // The sort must be stable and only consider the bits in the range
+    const uint64_t k_mask = (uint64_t(1) << (k_end_bit - k_begin_bit)) - 1;
+    auto get_sort_key = [&](GLuint key) { return uint64_t(key >> k_begin_bit) & k_mask; };
+
+    std::vector<GLuint> expected_vals = vals;
+    std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) {
+        return get_sort_key(keys[a]) < get_sort_key(keys[b]);
+    });
+
+    REQUIRE(sorted_vals == expected_vals);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[sorted_vals[i]]);
+}
+
+TEST_CASE("RadixSort-skip-constant-digits")
+{
+    const size_t k_num_elements = GENERATE(1024, 23857);
+    const GLuint k_max_key = GENERATE(GLuint(1) << 12, GLuint(1) << 20);
+    const DataType k_key_data_type = GENERATE(DataType_Uint, DataType_Float);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Max key: %u; Seed: %" PRIu64 "\n", k_num_elements, k_max_key, k_seed);
+
+    // Float keys are made of the same bits, but they're negative (all the bits are flipped to sort them)
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, k_max_key);
+    if (k_key_data_type == DataType_Float)
+    {
+        for (GLuint& key : keys)
+            key |= 0xc0000000u;
+    }
+
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    RadixSortOptions options;
+    options.key_data_type = k_key_data_type;
+    options.skip_constant_digits = true;
+    RadixSort radix_sort(options);
+    radix_sort(key_buffer.handle(), val_buffer.handle(), keys.size());
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_vals = vals;
+    if (k_key_data_type == DataType_Float)
+    {
+        std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) {
+            return keys[a] > keys[b];
+        });
+    }
+    else
+    {
+        std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) {
+            return keys[a] < keys[b];
+        });
+    }
+
+    REQUIRE(sorted_vals == expected_vals);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[sorted_vals[i]]);
+}
+
+TEST_CASE("RadixSort-onesweep")
+{
+    const size_t k_num_elements = GENERATE(1024, 23857, 1000000);
+    const size_t k_num_bits_per_step = GENERATE(4, 8);
+    const DataType k_key_data_type = GENERATE(DataType_Uint, DataType_Int);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf(
+        "Num elements: %zu; Num bits per step: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_num_bits_per_step, k_seed
+    );
+
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, UINT32_MAX);
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    RadixSortOptions options;
+    options.num_bits_per_step = k_num_bits_per_step;
+    options.key_data_type = k_key_data_type;
+    options.engine = RadixSortEngine_OneSweep;
+    RadixSort radix_sort(options);
+    if (radix_sort.engine() != RadixSortEngine_OneSweep)
+    {
+        printf("OneSweep isn't supported on this device\n");
+        return;
+    }
+
+    radix_sort(key_buffer.handle(), val_buffer.handle(), keys.size());
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_vals = vals;
+    if (k_key_data_type == DataType_Int)
+    {
+        std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) {
+            return GLint(keys[a]) < GLint(keys[b]);
+        });
+    }
+    else
+    {
+        std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) {
+            return keys[a] < keys[b];
+        });
+    }
+
+    REQUIRE(sorted_vals == expected_vals);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[sorted_vals[i]]);
+}
+
+TEST_CASE("RadixSort-engine-override")
+{
+    RadixSortOptions options;
+    options.engine = RadixSortEngine_MultiPass;
+    REQUIRE(RadixSort(options).engine() == RadixSortEngine_MultiPass);
+
+    // Forced, OneSweep is used even if the device isn't recognized (not run, as it may hang there)
+    options.engine = RadixSortEngine_OneSweep;
+    options.force_engine = true;
+    REQUIRE(RadixSort(options).engine() == RadixSortEngine_OneSweep);
+
+    options.force_engine = false;
+    bool is_supported = RadixSort::is_onesweep_supported();
+    REQUIRE(RadixSort(options).engine() == (is_supported ? RadixSortEngine_OneSweep : RadixSortEngine_MultiPass));
+}
+
+TEST_CASE("RadixSort-descending")
+{
+    const RadixSortEngine k_engine = GENERATE(RadixSortEngine_MultiPass, RadixSortEngine_OneSweep);
+    const bool k_skip_constant_digits = GENERATE(false, true);
+
+    RadixSortOptions options;
+    options.key_data_type = DataType_Int;
+    options.skip_constant_digits = k_skip_constant_digits;
+    options.engine = k_engine;
+    options.order = SortOrder_Descending;
+    RadixSort radix_sort(options);
+
+    // Around the max count sorted on shared memory, so that both paths run
+    size_t capacity = radix_sort.local_sort_capacity();
+    const size_t k_num_elements = GENERATE_COPY(100, capacity + 1, 100000);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    // Few distinct keys, to check the sort is stable
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, 1000);
+    for (GLuint& key : keys)
+        key = GLuint(GLint(key) - 500);
+
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    radix_sort(key_buffer.handle(), val_buffer.handle(), keys.size());
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_vals = vals;
+    std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) {
+        return GLint(keys[a]) > GLint(keys[b]);
+    });
+
+    REQUIRE(sorted_vals == expected_vals);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[sorted_vals[i]]);
+}
+
+TEST_CASE("RadixSort-key-extraction")
+{
+    const RadixSortEngine k_engine = GENERATE(RadixSortEngine_MultiPass, RadixSortEngine_OneSweep);
+    const bool k_skip_constant_digits = GENERATE(false, true);
+
+    // Records are (material, depth) pairs, sorted by depth
+    const char* k_key_extraction_src = R"(
+struct Record
+{
+    uint material;
+    int depth;
+};
+
+layout(std430, binding = RECORD_BINDING) readonly buffer RecordBuffer
+{
+    Record b_records[];
+};
+
+uint extract_key(uint index)
+{
+    return uint(b_records[index].depth);
+}
+)";
+    RadixSortOptions options;
+    options.key_data_type = DataType_Int;
+    options.skip_constant_digits = k_skip_constant_digits;
+    options.engine = k_engine;
+    options.key_extraction_src = k_key_extraction_src;
+    RadixSort radix_sort(options);
+
+    // Around the max count sorted on shared memory, so that both paths run
+    size_t capacity = radix_sort.local_sort_capacity();
+    const size_t k_num_elements = GENERATE_COPY(1, 100, capacity + 1, 100000);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    std::vector<GLuint> records = random.sample_int_vector<GLuint>(k_num_elements * 2, 0, 1000);
+    for (size_t i = 1; i < records.size(); i += 2)
+        records[i] = GLuint(GLint(records[i]) - 500); // Depth
+
+    ShaderStorageBuffer record_buffer(records);
+    ShaderStorageBuffer key_buffer(k_num_elements * sizeof(GLuint));
+    ShaderStorageBuffer index_buffer(k_num_elements * sizeof(GLuint));
+
+    radix_sort.sort_records(record_buffer.handle(), key_buffer.handle(), index_buffer.handle(), k_num_elements);
+
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_indices = index_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_indices(k_num_elements);
+    std::iota(expected_indices.begin(), expected_indices.end(), 0);
+    std::stable_sort(expected_indices.begin(), expected_indices.end(), [&](GLuint a, GLuint b) {
+        return GLint(records[a * 2 + 1]) < GLint(records[b * 2 + 1]);
+    });
+
+    REQUIRE(sorted_indices == expected_indices);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == records[sorted_indices[i] * 2 + 1]);
+}
+
+TEST_CASE("RadixSort-sort-and-merge")
+{
+    const size_t k_num_elements = GENERATE(0, 1000, 100000);
+    const size_t k_delta_count = GENERATE(1, 100, 5000);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Delta count: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_delta_count, k_seed);
+
+    size_t merged_count = k_num_elements + k_delta_count;
+
+    // Few distinct keys, to check existing keys are placed before the equal delta keys
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(merged_count, 0, 1000);
+    std::vector<GLuint> vals(merged_count);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    std::vector<GLuint> sorted_vals(vals.begin(), vals.begin() + k_num_elements);
+    std::stable_sort(sorted_vals.begin(), sorted_vals.end(), [&](GLuint a, GLuint b) { return keys[a] < keys[b]; });
+
+    // The existing keys are sorted, the delta keys follow them in another buffer
+    std::vector<GLuint> initial_keys(merged_count);
+    std::vector<GLuint> initial_vals(merged_count);
+    for (size_t i = 0; i < k_num_elements; i++)
+    {
+        initial_keys[i] = keys[sorted_vals[i]];
+        initial_vals[i] = sorted_vals[i];
+    }
+    std::vector<GLuint> delta_keys(keys.begin() + k_num_elements, keys.end());
+    std::vector<GLuint> delta_vals(vals.begin() + k_num_elements, vals.end());
+
+    ShaderStorageBuffer key_buffer(initial_keys);
+    ShaderStorageBuffer val_buffer(initial_vals);
+    ShaderStorageBuffer delta_key_buffer(delta_keys);
+    ShaderStorageBuffer delta_val_buffer(delta_vals);
+
+    RadixSort radix_sort;
+    radix_sort.sort_and_merge(
+        key_buffer.handle(),
+        val_buffer.handle(),
+        k_num_elements,
+        delta_key_buffer.handle(),
+        delta_val_buffer.handle(),
+        k_delta_count
+    );
+
+    std::vector<GLuint> merged_vals = val_buffer.get_data<GLuint>();
+    std::vector<GLuint> merged_keys = key_buffer.get_data<GLuint>();
+
+    // Sorting all the keys at once gives the same order
+    std::vector<GLuint> expected_vals = vals;
+    std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) { return keys[a] < keys[b]; });
+
+    REQUIRE(merged_vals == expected_vals);
+    for (size_t i = 0; i < merged_count; i++)
+        REQUIRE(merged_keys[i] == keys[merged_vals[i]]);
+}
+
+TEST_CASE("RadixSort-adaptive")
+{
+    const size_t k_num_elements = GENERATE(1000, 100000, 1000000);
+    const size_t k_num_swaps = GENERATE(0, 10, 1000000); // The last one makes the keys random (full sort)
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Num swaps: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_num_swaps, k_seed);
+
+    // Sorted keys with few distinct values (to check the stability), then some keys swapped with a near one
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, 10000);
+    std::sort(keys.begin(), keys.end());
+    for (size_t s = 0; s < k_num_swaps; s++)
+    {
+        size_t i = random.sample_int<size_t>(0, k_num_elements - 1);
+        size_t j = std::min<size_t>(i + random.sample_int<size_t>(1, 100), k_num_elements - 1);
+        std::swap(keys[i], keys[j]);
+    }
+
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    RadixSort radix_sort;
+    radix_sort.sort_adaptive(key_buffer.handle(), val_buffer.handle(), k_num_elements);
+
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+    std::vector<GLuint> sorted_keys = key_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_vals = vals;
+    std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) { return keys[a] < keys[b]; });
+
+    REQUIRE(sorted_vals == expected_vals);
+    for (size_t i = 0; i < k_num_elements; i++)
+        REQUIRE(sorted_keys[i] == keys[sorted_vals[i]]);
+}
+
+TEST_CASE("RadixSort-memory-budget")
+{
+    // Just above a power of 2, where scratch buffers padded to the next one would take twice the memory
+    const size_t k_num_elements = (size_t(1) << 20) + 1;
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    // Few distinct keys: the unstable BitonicSort fallback wouldn't keep the order of the values
+    std::vector<GLuint> keys = random.sample_int_vector<GLuint>(k_num_elements, 0, 16);
+    std::vector<GLuint> vals(k_num_elements);
+    std::iota(vals.begin(), vals.end(), 0);
+
+    ShaderStorageBuffer key_buffer(keys);
+    ShaderStorageBuffer val_buffer(vals);
+
+    RadixSort radix_sort;
+
+    size_t required_size = radix_sort.required_internal_buffers_size(k_num_elements);
+    REQUIRE(required_size < (size_t(1) << 21) * 2 * sizeof(GLuint));
+
+    // A budget that fits the count keeps the radix sort
+    radix_sort.set_memory_budget(required_size);
+    radix_sort(key_buffer.handle(), val_buffer.handle(), k_num_elements);
+
+    std::vector<GLuint> sorted_vals = val_buffer.get_data<GLuint>();
+
+    std::vector<GLuint> expected_vals = vals;
+    std::stable_sort(expected_vals.begin(), expected_vals.end(), [&](GLuint a, GLuint b) { return keys[a] < keys[b]; });
+
+    REQUIRE(sorted_vals == expected_vals);
+}
+
 TEST_CASE("RadixSort-benchmark", "[.][benchmark]")
 {
     const size_t k_num_elements = GENERATE(
@@ -182,12 +1095,26 @@ TEST_CASE("RadixSort-benchmark", "[.][benchmark]")
     ShaderStorageBuffer key_buffer(keys);
     ShaderStorageBuffer val_buffer(vals);
 
-    RadixSort radix_sort;
+    const size_t k_num_bits_per_step = GENERATE(4, 8);
+    const RadixSortEngine k_engine = GENERATE(RadixSortEngine_MultiPass, RadixSortEngine_OneSweep);
+
+    RadixSortOptions options;
+    options.num_bits_per_step = k_num_bits_per_step;
+    options.engine = k_engine;
+    RadixSort radix_sort(options);
+    if (radix_sort.engine() != k_engine)
+        return;
 
     radix_sort.prepare_internal_buffers(k_num_elements);
 
     uint64_t ns =
         measure_gl_elapsed_time([&]() { radix_sort(key_buffer.handle(), val_buffer.handle(), k_num_elements); });
 
-    printf("Radix sort; Num elements: %zu, Elapsed: %s\n", k_num_elements, ns_to_human_string(ns).c_str());
+    printf(
+        "Radix sort; Num elements: %zu, Num bits per step: %zu, Engine: %s, Elapsed: %s\n",
+        k_num_elements,
+        k_num_bits_per_step,
+        k_engine == RadixSortEngine_OneSweep ? "OneSweep" : "MultiPass",
+        ns_to_human_string(ns).c_str()
+    );
 }
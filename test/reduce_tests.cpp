@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cinttypes>
+#include <numeric>
+
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
@@ -49,6 +53,13 @@ TEST_CASE("Reduce-simple-uint")
         reduce(buffer.handle(), k_data_length);
         CHECK(buffer.get_data<uint32_t>()[0] == 99);
     }
+
+    SECTION("or")
+    {
+        Reduce reduce(DataType_Uint, ReduceOperator_Or);
+        reduce(buffer.handle(), k_data_length);
+        CHECK(buffer.get_data<uint32_t>()[0] == 127);
+    }
 }
 
 TEST_CASE("Reduce-all")
@@ -182,6 +193,50 @@ TEST_CASE("Reduce-subgroup-non-fitting-size")
     CHECK(calc_sum == sum);
 }
 
+TEST_CASE("Reduce-to-buffer")
+{
+    const size_t k_num_elements = GENERATE(1, 31, 1024, 4097, 88289, 5238082, 16777217);
+    const size_t k_offset = GENERATE(0, 13);
+    const size_t k_result_offset = GENERATE(0, 5);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Offset: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_offset, k_seed);
+
+    std::vector<GLuint> data = random.sample_int_vector<GLuint>(k_offset + k_num_elements, 0, 100);
+
+    ShaderStorageBuffer buffer(data);
+    ShaderStorageBuffer result_buffer(std::vector<GLuint>(k_result_offset + 2, 0xdeadbeef));
+
+    SECTION("sum")
+    {
+        GLuint sum = std::accumulate(data.begin() + k_offset, data.end(), GLuint(0));
+
+        Reduce reduce(DataType_Uint, ReduceOperator_Sum);
+        reduce(buffer.handle(), k_offset, k_num_elements, result_buffer.handle(), k_result_offset);
+
+        std::vector<GLuint> result = result_buffer.get_data<GLuint>();
+        CHECK(result[k_result_offset] == sum);
+        CHECK(result[k_result_offset + 1] == 0xdeadbeef);
+        if (k_result_offset > 0)
+            CHECK(result[k_result_offset - 1] == 0xdeadbeef);
+    }
+
+    SECTION("max")
+    {
+        GLuint max = *std::max_element(data.begin() + k_offset, data.end());
+
+        Reduce reduce(DataType_Uint, ReduceOperator_Max);
+        reduce(buffer.handle(), k_offset, k_num_elements, result_buffer.handle(), k_result_offset);
+
+        CHECK(result_buffer.get_data<GLuint>()[k_result_offset] == max);
+    }
+
+    // The input is left untouched
+    CHECK(buffer.get_data<GLuint>() == data);
+}
+
 TEST_CASE("Reduce-benchmark", "[.][benchmark]")
 {
     const size_t k_num_elements = GENERATE(
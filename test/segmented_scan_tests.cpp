@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cinttypes>
+#include <numeric>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <glad/glad.h>
+
+#include "glu/SegmentedScan.hpp"
+#include "util/Random.hpp"
+
+using namespace glu;
+
+TEST_CASE("SegmentedScan")
+{
+    const size_t k_num_elements = GENERATE(1, 1000, 100000, 1000000);
+    const size_t k_max_segment_length = GENERATE(1, 10, 10000);
+    const ScanType k_scan_type = GENERATE(ScanType_Exclusive, ScanType_Inclusive);
+    const bool k_with_offsets = GENERATE(false, true);
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf(
+        "Num elements: %zu; Max segment length: %zu; Scan type: %d; With offsets: %d; Seed: %" PRIu64 "\n",
+        k_num_elements,
+        k_max_segment_length,
+        k_scan_type,
+        k_with_offsets,
+        k_seed
+    );
+
+    std::vector<GLuint> data = random.sample_int_vector<GLuint>(k_num_elements, 0, 100);
+
+    // Segments of skewed lengths (empty ones too), the first one starting after the first element
+    std::vector<GLuint> segment_offsets{std::min<GLuint>(1, k_num_elements)};
+    while (segment_offsets.back() < k_num_elements)
+    {
+        GLuint length = random.sample_int<GLuint>(0, k_max_segment_length + 1);
+        segment_offsets.push_back(std::min<GLuint>(segment_offsets.back() + length, k_num_elements));
+    }
+    size_t num_segments = segment_offsets.size() - 1;
+
+    std::vector<GLuint> head_flags(k_num_elements, 0);
+    for (GLuint offset : segment_offsets)
+    {
+        if (offset < k_num_elements)
+            head_flags[offset] = 1;
+    }
+
+    ShaderStorageBuffer buffer(data);
+    ShaderStorageBuffer head_flag_buffer(head_flags);
+    ShaderStorageBuffer segment_offset_buffer(segment_offsets);
+
+    SegmentedScan segmented_scan(DataType_Uint, ReduceOperator_Sum, k_scan_type);
+    if (k_with_offsets)
+        segmented_scan.scan_segments(buffer.handle(), segment_offset_buffer.handle(), num_segments, k_num_elements);
+    else
+        segmented_scan(buffer.handle(), head_flag_buffer.handle(), k_num_elements);
+
+    std::vector<GLuint> expected(k_num_elements);
+    GLuint prefix = 0;
+    for (size_t i = 0; i < k_num_elements; i++)
+    {
+        if (head_flags[i])
+            prefix = 0;
+        if (k_scan_type == ScanType_Inclusive)
+            prefix += data[i];
+        expected[i] = prefix;
+        if (k_scan_type == ScanType_Exclusive)
+            prefix += data[i];
+    }
+
+    REQUIRE(buffer.get_data<GLuint>() == expected);
+}
+
+TEST_CASE("SegmentedScan-many-blocks", "[.]")
+{
+    // Blocks are 4096 elements: more than 65535 blocks are dispatched on two dimensions (with more workgroups than
+    // blocks). Hidden, as it takes 2GB on the host and device
+    const size_t k_num_elements = 65535 * 4096 + 3 * 4096; // 65538 blocks, 1GB
+    const bool k_with_offsets = GENERATE(false, true);
+
+    printf("Num elements: %zu; With offsets: %d\n", k_num_elements, k_with_offsets);
+
+    // A pattern rather than random values, as quicker to generate; segments of 1 to 10007 elements
+    std::vector<GLuint> data(k_num_elements);
+    for (size_t i = 0; i < k_num_elements; i++)
+        data[i] = GLuint((i * 7 + i / 4096) % 5);
+
+    std::vector<GLuint> segment_offsets{0};
+    while (segment_offsets.back() < k_num_elements)
+    {
+        GLuint length = GLuint(segment_offsets.size() * 7919 % 10007 + 1);
+        segment_offsets.push_back(std::min<GLuint>(segment_offsets.back() + length, GLuint(k_num_elements)));
+    }
+    size_t num_segments = segment_offsets.size() - 1;
+
+    ShaderStorageBuffer buffer(data);
+
+    SegmentedScan segmented_scan(DataType_Uint);
+    if (k_with_offsets)
+    {
+        ShaderStorageBuffer segment_offset_buffer(segment_offsets);
+        segmented_scan.scan_segments(buffer.handle(), segment_offset_buffer.handle(), num_segments, k_num_elements);
+    }
+    else
+    {
+        std::vector<GLuint> head_flags(k_num_elements, 0);
+        for (size_t segment_i = 0; segment_i < num_segments; segment_i++)
+            head_flags[segment_offsets[segment_i]] = 1;
+
+        ShaderStorageBuffer head_flag_buffer(head_flags);
+        segmented_scan(buffer.handle(), head_flag_buffer.handle(), k_num_elements);
+    }
+
+    // In place, to spare the memory
+    for (size_t segment_i = 0; segment_i < num_segments; segment_i++)
+    {
+        auto segment_begin = data.begin() + segment_offsets[segment_i];
+        auto segment_end = data.begin() + segment_offsets[segment_i + 1];
+        std::exclusive_scan(segment_begin, segment_end, segment_begin, GLuint(0));
+    }
+
+    REQUIRE(buffer.get_data<GLuint>() == data);
+}
+
+TEST_CASE("SegmentedScan-max")
+{
+    const size_t k_num_elements = 100000;
+
+    const uint64_t k_seed = 1;
+    Random random(k_seed);
+
+    printf("Num elements: %zu; Seed: %" PRIu64 "\n", k_num_elements, k_seed);
+
+    std::vector<float> data(k_num_elements);
+    for (float& value : data)
+        value = float(random.sample_int<GLint>(-1000, 1000));
+
+    std::vector<GLuint> head_flags(k_num_elements);
+    for (GLuint& head_flag : head_flags)
+        head_flag = random.sample_int<GLuint>(0, 100) == 0 ? 1 : 0;
+
+    ShaderStorageBuffer buffer(data);
+    ShaderStorageBuffer head_flag_buffer(head_flags);
+
+    SegmentedScan segmented_scan(DataType_Float, ReduceOperator_Max, ScanType_Inclusive);
+    segmented_scan(buffer.handle(), head_flag_buffer.handle(), k_num_elements);
+
+    std::vector<float> expected(k_num_elements);
+    float max = data[0];
+    for (size_t i = 0; i < k_num_elements; i++)
+    {
+        max = i == 0 || head_flags[i] ? data[i] : std::max(max, data[i]);
+        expected[i] = max;
+    }
+
+    REQUIRE(buffer.get_data<float>() == expected);
+}